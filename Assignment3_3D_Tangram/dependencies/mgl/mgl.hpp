@@ -12,13 +12,31 @@
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 
+#include "./mglAllocations.hpp"
+#include "./mglAnimation.hpp"
 #include "./mglApp.hpp"
+#include "./mglAssetPack.hpp"
 #include "./mglCamera.hpp"
 #include "./mglConventions.hpp"
 #include "./mglError.hpp"
+#include "./mglFrameArena.hpp"
+#include "./mglFramePacer.hpp"
+#include "./mglFrameStats.hpp"
+#include "./mglGLCounters.hpp"
+#include "./mglGLObject.hpp"
+#include "./mglGLTrace.hpp"
+#include "./mglGeometry.hpp"
+#include "./mglHud.hpp"
+#include "./mglInput.hpp"
+#include "./mglLog.hpp"
+#include "./mglMemory.hpp"
 #include "./mglMesh.hpp"
 #include "./mglOrbitCamera.hpp"
+#include "./mglProfiler.hpp"
+#include "./mglResources.hpp"
 #include "./mglScenegraph.hpp"
 #include "./mglShader.hpp"
+#include "./mglShaderQueue.hpp"
+#include "./mglTripleBuffer.hpp"
 
 #endif /* MGL_HPP */
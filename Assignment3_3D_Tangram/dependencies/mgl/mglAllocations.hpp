@@ -0,0 +1,69 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Heap Allocation Tracking
+//
+// When MGL_TRACK_ALLOCATIONS is defined, the global operator new and delete
+// are replaced by versions that count allocations, bytes requested and frees
+// for the calling thread before passing on to malloc and free. The counters
+// are per thread and written only by their own thread, so tracking adds no
+// contention between threads; a lock is taken only when a thread first
+// allocates. Profiler scopes record the allocations made inside them.
+//
+// Memory obtained with malloc, or by the driver, is not seen. Without the
+// define nothing is replaced and all counts stay at zero; the Profile
+// configuration defines it.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef MGL_ALLOCATIONS_HPP
+#define MGL_ALLOCATIONS_HPP
+
+#include <cstdint>
+
+namespace mgl {
+
+class Allocations;
+
+struct AllocationCounts {
+  uint64_t allocations = 0;
+  uint64_t bytes = 0;
+  uint64_t frees = 0;
+};
+
+//////////////////////////////////////////////////////////////////// Allocations
+
+class Allocations {
+ public:
+  static Allocations &getInstance();
+  static bool isTracking();              // built with MGL_TRACK_ALLOCATIONS
+  static AllocationCounts getThread();   // calling thread, since it started
+
+  void setThreadName(const char *name);  // must outlive the tracker
+  AllocationCounts getTotal();           // all threads, including finished
+
+  void endFrame();                       // by the Engine after each frame
+  const AllocationCounts &getFrame();    // all threads, last frame
+  // From the given frame on, every frame that allocates is reported as an
+  // error and fails the check.
+  void setSteadyState(uint32_t first_frame);
+  bool passedSteadyState();
+
+  void report();  // totals per thread
+
+ private:
+  Allocations();
+  AllocationCounts Last, Frame;
+  uint32_t Frames;
+  uint32_t SteadyFrame;
+  bool Checking;
+  uint64_t FailedFrames;
+
+ public:
+  Allocations(Allocations const &) = delete;
+  void operator=(Allocations const &) = delete;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+}  // namespace mgl
+
+#endif /* MGL_ALLOCATIONS_HPP */
@@ -0,0 +1,255 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Coroutine Animations
+//
+// An Animation is a C++20 coroutine that plays out a choreography as plain
+// sequential code, suspending on awaitables instead of keeping a state
+// machine:
+//
+//   mgl::Animation assemble(mgl::SceneNode &a, mgl::SceneNode &b) {
+//     co_await mgl::tween(a, 1.0f, 0.5);  // a sub-animation, to its end
+//     co_await mgl::wait(0.2);
+//     co_await mgl::all(mgl::tween(a, 0.0f, 0.5), mgl::tween(b, 1.0f, 0.5));
+//   }
+//
+// An Animator runs the animations started on it from update(), once a frame,
+// on the thread that updates the scene. Each suspended animation waits in
+// exactly one queue, for this frame, the next one or a timer, so resuming
+// thousands of them costs one indirect call each and no allocation. Their
+// coroutine frames are taken from the AnimationPool, which keeps freed frames
+// for reuse, so after warming up starting an animation does not touch the
+// heap either.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef MGL_ANIMATION_HPP
+#define MGL_ANIMATION_HPP
+
+#include <array>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace mgl {
+
+class AnimationPool;
+class Animation;
+class Animator;
+class SceneNode;
+
+////////////////////////////////////////////////////////////////// AnimationPool
+
+// Blocks of a few power-of-two sizes, carved from chunks that are never given
+// back; frames larger than the largest block come from the heap and are
+// counted.
+class AnimationPool {
+ public:
+  static const std::size_t MIN_BLOCK = 64;    // bytes
+  static const std::size_t MAX_BLOCK = 4096;  // bytes
+  static const std::size_t BLOCKS_PER_CHUNK = 64;
+
+  static AnimationPool &getInstance();
+  void *allocate(std::size_t bytes);
+  void deallocate(void *p, std::size_t bytes);
+
+  std::size_t getReserved();  // bytes carved into blocks
+  std::size_t getInUse();     // frames alive
+  uint64_t getOversized();    // frames taken from the heap
+
+ private:
+  static const int CLASSES = 7;  // MIN_BLOCK to MAX_BLOCK
+  struct Block {
+    Block *next;
+  };
+
+  AnimationPool();
+  std::mutex Mutex;
+  Block *Free[CLASSES];
+  std::vector<std::unique_ptr<unsigned char[]>> Chunks;
+  std::size_t Reserved, InUse;
+  uint64_t Oversized;
+
+  static int getClass(std::size_t bytes);  // -1 if too large
+
+ public:
+  AnimationPool(AnimationPool const &) = delete;
+  void operator=(AnimationPool const &) = delete;
+};
+
+////////////////////////////////////////////////////////////////////// Animation
+
+// Starts suspended; it runs once started on an Animator or awaited by another
+// animation, which then resumes when it ends. Owns its frame until then.
+class Animation {
+ public:
+  struct promise_type;
+  using Handle = std::coroutine_handle<promise_type>;
+
+  struct FinalAwaiter {
+    bool await_ready() noexcept { return false; }
+    std::coroutine_handle<> await_suspend(Handle self) noexcept;
+    void await_resume() noexcept {}
+  };
+
+  struct promise_type {
+    Animator *Owner = nullptr;
+    std::coroutine_handle<> Continuation;  // awaiting this one, if any
+    unsigned int *Remaining = nullptr;     // of the all() it belongs to
+    promise_type *Prev = nullptr, *Next = nullptr;  // started on Owner
+
+    static void *operator new(std::size_t bytes) {
+      return AnimationPool::getInstance().allocate(bytes);
+    }
+    static void operator delete(void *p, std::size_t bytes) {
+      AnimationPool::getInstance().deallocate(p, bytes);
+    }
+
+    Animation get_return_object() {
+      return Animation(Handle::from_promise(*this));
+    }
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    FinalAwaiter final_suspend() noexcept { return {}; }
+    void return_void() {}
+    void unhandled_exception();
+  };
+
+  struct Awaiter {
+    Handle Child;
+    bool await_ready() { return false; }
+    std::coroutine_handle<> await_suspend(Handle parent);
+    void await_resume() {}
+  };
+
+  Animation() = default;
+  explicit Animation(Handle coroutine) : Coroutine(coroutine) {}
+  Animation(Animation &&other) noexcept : Coroutine(other.release()) {}
+  Animation &operator=(Animation &&other) noexcept;
+  ~Animation();
+
+  Awaiter operator co_await() && { return {Coroutine}; }
+  Handle getHandle() const { return Coroutine; }
+  Handle release();  // gives up ownership of the frame
+
+  Animation(Animation const &) = delete;
+  void operator=(Animation const &) = delete;
+
+ private:
+  Handle Coroutine;
+};
+
+/////////////////////////////////////////////////////////////////////// Animator
+
+class Animator {
+ public:
+  Animator();
+  ~Animator();  // destroys the animations still running
+
+  void start(Animation animation);  // runs from the next update()
+  void update(double elapsed);      // in seconds, since the last one
+  void clear();  // destroys every animation, not from within one
+
+  bool isIdle();
+  std::size_t getRunning();
+  double getTime();
+  double getElapsed();  // by the last update()
+
+  // For awaitables, to resume a suspended animation later on.
+  void resume(std::coroutine_handle<> handle);  // in this update()
+  void resumeNextFrame(std::coroutine_handle<> handle);
+  void resumeAt(std::coroutine_handle<> handle, double time);
+  void finish(Animation::Handle handle);  // of an animation started here
+
+  Animator(Animator const &) = delete;
+  void operator=(Animator const &) = delete;
+
+ private:
+  struct Timer {
+    double time;
+    uint64_t order;  // breaks ties, first come first resumed
+    std::coroutine_handle<> handle;
+  };
+
+  double Time, Elapsed;
+  std::vector<std::coroutine_handle<>> Ready, Deferred;  // to the next frame
+  std::vector<Timer> Timers;  // a heap, earliest at the front
+  uint64_t TimerOrder;
+  Animation::promise_type *Started;  // list of the animations started here
+  std::size_t Running;
+
+  static bool isLater(const Timer &a, const Timer &b);
+};
+
+///////////////////////////////////////////////////////////////////// AWAITABLES
+
+class Wait {
+ public:
+  explicit Wait(double seconds) : Seconds(seconds) {}
+  bool await_ready() { return Seconds <= 0.0; }
+  void await_suspend(Animation::Handle self);
+  void await_resume() {}
+
+ private:
+  double Seconds;
+};
+
+// Resumes with the seconds elapsed by the frame it resumes in.
+class NextFrame {
+ public:
+  bool await_ready() { return false; }
+  void await_suspend(Animation::Handle self);
+  double await_resume();
+
+ private:
+  Animator *Owner = nullptr;
+};
+
+// Runs its animations side by side and resumes when the last one has ended.
+template <std::size_t N>
+class Join {
+ public:
+  explicit Join(std::array<Animation, N> &&animations)
+      : Animations(std::move(animations)), Remaining(0) {}
+  bool await_ready() { return N == 0; }
+  void await_suspend(Animation::Handle self);
+  void await_resume() {}
+
+ private:
+  std::array<Animation, N> Animations;
+  unsigned int Remaining;
+};
+
+template <std::size_t N>
+void Join<N>::await_suspend(Animation::Handle self) {
+  Animator *owner = self.promise().Owner;
+  Remaining = N;
+  for (Animation &animation : Animations) {
+    Animation::promise_type &child = animation.getHandle().promise();
+    child.Owner = owner;
+    child.Continuation = self;
+    child.Remaining = &Remaining;
+    owner->resume(animation.getHandle());
+  }
+}
+
+inline Wait wait(double seconds) { return Wait(seconds); }
+
+inline NextFrame nextFrame() { return NextFrame(); }
+
+template <typename... Animations>
+Join<sizeof...(Animations)> all(Animations &&...animations) {
+  return Join<sizeof...(Animations)>(
+      std::array<Animation, sizeof...(Animations)>{std::move(animations)...});
+}
+
+// Moves the node's animation stage to the given one, linearly over the given
+// seconds; see SceneNode::setStage().
+Animation tween(SceneNode &node, float stage, double seconds);
+
+////////////////////////////////////////////////////////////////////////////////
+}  // namespace mgl
+
+#endif /* MGL_ANIMATION_HPP */
@@ -12,7 +12,16 @@
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 
+#include <atomic>
+#include <functional>
 #include <glm/glm.hpp>
+#include <string>
+
+#include "./mglAllocations.hpp"
+#include "./mglFramePacer.hpp"
+#include "./mglFrameStats.hpp"
+#include "./mglHud.hpp"
+#include "./mglInput.hpp"
 
 namespace mgl {
 
@@ -23,7 +32,15 @@ class Engine;
 
 class App {
  public:
+  // Runs on a worker thread while the window and context are created, so it
+  // must not call GL; initCallback() is only called once it has returned.
+  virtual void preloadCallback() {}
   virtual void initCallback(GLFWwindow *window) {}
+  // Advances the simulation, without GL calls, on the thread handling input.
+  // Called before displayCallback(), or while it runs on the render thread,
+  // in which case the two must only share what they hand over explicitly,
+  // e.g. through a TripleBuffer.
+  virtual void updateCallback(GLFWwindow *window, double elapsed) {}
   virtual void displayCallback(GLFWwindow *window, double elapsed) {}
   virtual void windowCloseCallback(GLFWwindow *window) {}
   virtual void windowSizeCallback(GLFWwindow *window, int width, int height) {}
@@ -37,6 +54,34 @@ class App {
   virtual void joystickCallback(int jid, int event) {}
 };
 
+///////////////////////////////////////////////////////////////// StartupTimings
+
+// Milliseconds per startup phase. The preload runs in parallel with the
+// GLFW, GLEW and OpenGL setup; preloadWait is how long init then blocked on it.
+struct StartupTimings {
+  double preload = 0.0;
+  double setupGLFW = 0.0;
+  double setupGLEW = 0.0;
+  double setupOpenGL = 0.0;
+  double preloadWait = 0.0;
+  double initCallback = 0.0;
+  double init = 0.0;
+  double firstFrame = 0.0;       // first displayCallback and swap
+  double timeToFirstFrame = 0.0;  // from process start
+};
+
+/////////////////////////////////////////////////////////////////// TimingTotals
+
+// Milliseconds totalled over the frames concerned, e.g. those that had to
+// wait for the GPU.
+struct TimingTotals {
+  uint32_t frames = 0;
+  double total = 0.0;
+  double max = 0.0;
+
+  void add(double milliseconds);
+};
+
 ///////////////////////////////////////////////////////////////////////// Engine
 
 class Engine {
@@ -48,11 +93,72 @@ class Engine {
   void setApp(App *app);
   App *getApp();
   void setOpenGL(int major, int minor);
+  // A vsync of -1 asks for adaptive vsync, which tears rather than waiting
+  // for the next refresh when a frame is late, where the driver supports it.
   void setWindow(int width, int height, const char *title, int fullscreen,
                  int vsync);
+  void setHeadless(bool headless);  // render offscreen, see setupHeadless()
+  void setFrameLimit(unsigned int frames);  // 0 runs until the window closes
+  // Draws a frame only when requested: by input, by resizing or uncovering
+  // the window, or by invalidate(), and otherwise blocks waiting for events.
+  // Ignored when headless, replaying, benchmarking or showing the HUD.
+  void setOnDemand(bool on_demand);
+  // While waiting on demand, also calls the function every given seconds,
+  // and draws a frame only when it returns true; for changes that cannot
+  // wake the wait themselves, such as files watched by modification time.
+  // Without one, the default, only events end the wait.
+  void setIdlePoll(std::function<bool()> poll, double seconds);
+  void invalidate();  // requests another frame, from any thread
+  // Moves displayCallback() and the GL context to a thread of their own, so
+  // that input and updateCallback() stay on the main thread, one update per
+  // frame drawn, and neither waits for the other. Needs a window; ignored
+  // when headless, recording, replaying or benchmarking, and on-demand
+  // drawing does not apply.
+  void setRenderThread(bool threaded);
+  // Waits after each swap until the GPU has finished all but the given
+  // number of frames, 1 to 3, trading throughput for input latency; 0 lets
+  // the driver queue as many as it likes.
+  void setFramesInFlight(int frames);
+  const TimingTotals &getGpuWait();
+  // Also queues the input dispatched to the App, see InputQueue, for
+  // displayCallback() to apply right before drawing, and measures the
+  // latency from the oldest event it applied to the end of the swap.
+  void setLateLatching(bool late_latching);
+  InputQueue &getInputQueue();
+  // Handles the input received since the frame started; does nothing while
+  // recording or replaying, so that replays stay exact, nor when drawing on
+  // the render thread, where the queue is kept up to date anyway.
+  void latchInput();
+  const TimingTotals &getInputLatency();
+  bool isHeadless();
+  GLuint getFramebuffer();  // offscreen target when headless, 0 otherwise
+  bool setInputRecording(const std::string &filename);
+  bool setInputReplay(const std::string &filename);  // ends run() when done
+  bool isReplaying();
+  // Captures the GL calls of the setup and of the given number of frames,
+  // 0 for all, see GLTraceRecorder.
+  bool setGLCapture(const std::string &filename, unsigned int frames);
+  // Runs warmup frames, then collects statistics over the given number of
+  // frames, after which run() returns.
+  void setBenchmark(unsigned int warmup, unsigned int frames);
+  FrameStats &getFrameStats();
+  // Paces the frames of run(). The idle rate applies after frames in which
+  // nothing asked for a redraw, see invalidate().
+  FramePacer &getFramePacer();
+  void setCallCounting(bool counting);  // see GLCounters
+  void setHudVisible(bool visible);      // drawn over displayCallback()
+  bool isHudVisible();
   void init();
   void run();
 
+  const StartupTimings &getStartupTimings();
+  void setStartupReport(const std::string &filename);
+
+  // Called by the GLFW callbacks; records the event and passes it to the App,
+  // or drops it while a replay is providing the input instead.
+  void handleInput(GLFWwindow *window, InputEvent event);
+  void getCursorPos(double *xpos, double *ypos);  // as last dispatched
+
  protected:
   virtual ~Engine();
 
@@ -64,12 +170,67 @@ class Engine {
   const char *WindowTitle;
   int Fullscreen;
   int Vsync;
+  StartupTimings Startup;
+  std::string StartupReport;
+  bool Headless;
+  unsigned int FrameLimit;
+  bool OnDemand;
+  std::function<bool()> IdlePoll;
+  double IdleInterval;
+  std::atomic<bool> Redraw;
+  bool RenderThreaded, Threaded;
+  std::atomic<bool> Running;  // cleared to stop the render thread
+  static const int MAX_FRAMES_IN_FLIGHT = 3;
+  int FramesInFlight;
+  GLsync Fences[MAX_FRAMES_IN_FLIGHT];  // of the last frames, by frame
+  TimingTotals GpuWait;
+  bool LateLatching;
+  InputQueue Latched;
+  TimingTotals InputLatency;
+  GLuint Framebuffer, ColorBuffer, DepthBuffer;
+  void *EglDisplay, *EglContext, *EglSurface;  // opaque EGL handles
+  InputRecorder Recorder;
+  InputReplayer Replayer;
+  bool Recording, Replaying;
+  bool Capturing;
+  std::atomic<uint32_t> Frame;  // frames completed by run()
+  double RunStart;
+  double CursorX, CursorY;
+  static const int GPU_TIMERS = 4;  // frames in flight before reading back
+  bool Benchmarking;
+  FrameStats Stats;
+  FramePacer Pacer;
+  GLuint GpuTimers[GPU_TIMERS];
+  uint32_t GpuTimerFrame[GPU_TIMERS];
+  bool GpuTimerPending[GPU_TIMERS];
+  bool CallCounting;
+  std::atomic<bool> HudVisible;
+  Hud *Overlay;  // created the first time it is shown
 
   void setupWindow();
   void setupGLFW();
+  bool setupEGL();
+  void setupHeadless();
+  void setupFramebuffer();
+  void destroyContext();
+  bool shouldClose();
+  bool shouldWait();
+  void waitForRedraw();
+  void pace();
+  void drawHud(double elapsed);
+  void endFrame();
+  void limitFramesInFlight();
+  void releaseFences();
+  void measureInputLatency();
+  void runRenderThread();
+  void renderLoop();
+  void dispatchInput(const InputEvent &event);
+  void collectGpuTimer(int timer);
+  double getTime();
   void setupGLEW();
   void setupOpenGL();
   void setupCallbacks();
+  void reportStartup();
 
  public:
   Engine(Engine const &) = delete;
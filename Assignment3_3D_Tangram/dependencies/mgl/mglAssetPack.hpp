@@ -0,0 +1,132 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Asset Pack
+//
+// A single file holding every asset, memory-mapped once at runtime:
+//
+//   [PackHeader][PackEntry x count, sorted by hash][names][data...]
+//
+// Each data block starts on a 64-byte boundary and may be LZ4 compressed.
+// Uncompressed entries are handed out as pointers into the mapping.
+// All integers are little-endian.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef MGL_ASSET_PACK_HPP
+#define MGL_ASSET_PACK_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace mgl {
+
+class AssetPack;
+class AssetPackWriter;
+
+////////////////////////////////////////////////////////////////////// Format
+
+const char PACK_MAGIC[8] = {'M', 'G', 'L', 'P', 'A', 'C', 'K', '\0'};
+const uint32_t PACK_VERSION = 1;
+const uint64_t PACK_ALIGNMENT = 64;
+const uint32_t PACK_LZ4 = 0x1;
+
+struct PackHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t count;
+  uint64_t tocOffset;
+  uint64_t namesOffset;
+  uint8_t reserved[32];
+};
+static_assert(sizeof(PackHeader) == 64, "PackHeader must be 64 bytes");
+
+struct PackEntry {
+  uint64_t hash;
+  uint64_t offset;
+  uint64_t size;     // bytes stored in the pack
+  uint64_t rawSize;  // bytes after decompression
+  uint32_t flags;
+  uint32_t nameOffset;
+  uint32_t nameLength;
+  uint32_t reserved;
+};
+static_assert(sizeof(PackEntry) == 48, "PackEntry must be 48 bytes");
+
+// FNV-1a over the '/'-separated path, usable at compile time.
+constexpr uint64_t hashAssetName(const char *name) {
+  uint64_t hash = 0xcbf29ce484222325ull;
+  for (; *name; ++name) {
+    hash ^= static_cast<uint8_t>(*name);
+    hash *= 0x100000001b3ull;
+  }
+  return hash;
+}
+
+std::string normalizeAssetName(const std::string &name);
+
+std::vector<uint8_t> lz4Compress(const uint8_t *src, std::size_t size);
+bool lz4Decompress(const uint8_t *src, std::size_t size, uint8_t *dst,
+                   std::size_t raw_size);
+
+////////////////////////////////////////////////////////////////////// AssetPack
+
+class AssetPack {
+ public:
+  struct Asset {
+    const char *data = nullptr;
+    std::size_t size = 0;
+    explicit operator bool() const { return data != nullptr; }
+  };
+
+  AssetPack();
+  ~AssetPack();
+  bool open(const std::string &filename);
+  void close();
+  bool isOpen();
+
+  bool contains(const std::string &name);
+  Asset get(const std::string &name);
+  std::vector<std::string> list();
+
+ private:
+  const uint8_t *Data;
+  std::size_t Size;
+  const PackEntry *Entries;
+  uint32_t Count;
+  std::map<uint64_t, std::unique_ptr<uint8_t[]>> Decompressed;
+#ifdef _WIN32
+  void *FileHandle;
+  void *MappingHandle;
+#endif
+
+  bool isInside(uint64_t offset, uint64_t length);
+  bool validate();
+  const PackEntry *find(const std::string &name);
+};
+
+//////////////////////////////////////////////////////////////// AssetPackWriter
+
+class AssetPackWriter {
+ public:
+  void add(const std::string &name, const std::vector<uint8_t> &data,
+           bool compress);
+  bool write(const std::string &filename);
+
+ private:
+  struct Item {
+    std::string name;
+    std::vector<uint8_t> data;
+    uint64_t rawSize;
+    uint32_t flags;
+  };
+  std::vector<Item> Items;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+}  // namespace mgl
+
+#endif /* MGL_ASSET_PACK_HPP */
@@ -15,23 +15,34 @@
 
 #include <glm/glm.hpp>
 
+#include "./mglGLObject.hpp"
+#include "./mglMemory.hpp"
+
 namespace mgl {
 
 	class Camera;
 
 	///////////////////////////////////////////////////////////////////////// Camera
 
+	// The matrices are plain values until upload() writes them to the uniform
+	// buffer, so that they can be computed on another thread than the one
+	// owning the GL context, which then uploads a copy of them.
 	class Camera {
 	private:
-		GLuint UboId;
+		GLBuffer Ubo;
 		GLuint BindingPoint;
 		glm::mat4 ViewMatrix;
 		glm::mat4 ProjectionMatrix;
+		glm::mat4 Uploaded[2];  // what the uniform buffer holds
+		bool UploadValid;
+		MemoryAccount Memory;
 
 	public:
 		explicit Camera(GLuint bindingpoint);
 		virtual ~Camera();
 		void activate();
+		void upload();  // skipped when the matrices did not change
+		void upload(const glm::mat4& viewmatrix, const glm::mat4& projectionmatrix);
 
 		glm::mat4 getViewMatrix();
 		void setViewMatrix(const glm::mat4& viewmatrix);
@@ -12,22 +12,69 @@
 #include <iostream>
 #include <string>
 
+// Error checks are compiled in when MGL_GL_CHECKS is non-zero, which is the
+// default of DEBUG builds; staging builds may define it on its own. As every
+// glGetError stalls until the GPU catches up, the checks only run in sampled
+// frames, one in every check interval, and inside the scope selected with
+// setCheckedScope(), so that frame times stay meaningful.
+
+#ifndef MGL_GL_CHECKS
+#ifdef DEBUG
+#define MGL_GL_CHECKS 1
+#else
+#define MGL_GL_CHECKS 0
+#endif
+#endif
+
 //////////////////////////////////////////////////////////// Errors (OpenGL 2.0)
 
 void checkOpenGLError(const std::string &function, const std::string &file,
-                      int line);
+                      int line);  // always checks, exits on error
 
-#ifdef DEBUG
-#define MGL_CHECK checkOpenGLError(__FUNCTION__, __FILE__, __LINE__);
+void setCheckInterval(unsigned int frames);  // 0 checks the scope only
+void setCheckedScope(const std::string &name);
+void beginCheckedFrame(unsigned int frame);
+bool isCheckSampled();  // in this frame, or inside the checked scope
+
+// Checks for errors left before it when entered and for those raised inside
+// it when left.
+class CheckScope {
+ public:
+  CheckScope(const char *name, const char *function, const char *file,
+             int line);
+  ~CheckScope();
+
+ private:
+  const char *Name, *Function, *File;
+  int Line;
+  bool Active, Selected;
+};
+
+#if MGL_GL_CHECKS
+#define MGL_CHECK                                         \
+  {                                                       \
+    if (isCheckSampled())                                 \
+      checkOpenGLError(__FUNCTION__, __FILE__, __LINE__); \
+  }
+#define MGL_CHECK_FRAME(frame) beginCheckedFrame(frame)
+#define MGL_CHECK_SCOPE(name) \
+  CheckScope mgl_check_scope(name, __FUNCTION__, __FILE__, __LINE__)
 #else
 #define MGL_CHECK
+#define MGL_CHECK_FRAME(frame)
+#define MGL_CHECK_SCOPE(name)
 #endif
 
 ////////////////////////////////////////////////////// Debug Output (OpenGL 4.3)
 
+// Debug messages are asynchronous, so they cost the driver no stalls, and
+// aggregated by id: each one is logged the first time and only counted after.
+
 void setupDebugOutput();
+void releaseDebugOutput();
+void reportDebugOutput(std::ostream &os);  // every message, with its count
 
-#ifdef DEBUG
+#if MGL_GL_CHECKS
 #define MGL_DEBUG setupDebugOutput();
 #else
 #define MGL_DEBUG
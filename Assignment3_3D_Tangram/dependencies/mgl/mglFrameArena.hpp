@@ -0,0 +1,110 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Frame Arenas
+//
+// Each thread has a FrameArena, a bump allocator for data that lives for one
+// frame only: allocating moves a pointer forward, freeing does nothing but
+// take back the last allocation, and reset() drops everything at once. The
+// Engine resets the arenas of the threads running its loops at the top of
+// every frame; any other thread using its arena must reset it itself.
+//
+// ArenaAllocator adapts an arena for standard containers, e.g. a FrameVector,
+// which must not outlive the frame. When an arena runs out, the overflow is
+// taken from the heap and counted, and the next reset() grows the arena to
+// the high-water mark, so that after a frame or two nothing touches the heap;
+// report() shows the marks, to size arenas from real runs.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef MGL_FRAME_ARENA_HPP
+#define MGL_FRAME_ARENA_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace mgl {
+
+class FrameArena;
+template <typename T>
+class ArenaAllocator;
+
+///////////////////////////////////////////////////////////////////// FrameArena
+
+class FrameArena {
+ public:
+  static const std::size_t DEFAULT_CAPACITY = 256 * 1024;  // bytes
+
+  static FrameArena &getLocal();  // of the calling thread
+  static void setDefaultCapacity(std::size_t bytes);  // for arenas yet unused
+  static void report(std::ostream &os);  // all arenas, between frames
+
+  void setName(const char *name);
+  void *allocate(std::size_t bytes, std::size_t alignment);
+  void deallocate(void *p, std::size_t bytes);
+  void reset();
+
+  std::size_t getCapacity();
+  std::size_t getUsed();
+  std::size_t getHighWater();  // most bytes used in any frame
+  uint32_t getOverflows();     // frames that needed the heap
+
+ private:
+  std::string Name;
+  std::unique_ptr<unsigned char[]> Block;
+  std::size_t Capacity, Top;
+  std::vector<std::unique_ptr<unsigned char[]>> Overflow;
+  std::size_t OverflowBytes;
+  std::size_t HighWater;
+  uint32_t Overflows;
+
+  FrameArena(const std::string &name, std::size_t capacity);
+  static FrameArena *create();
+
+ public:
+  FrameArena(FrameArena const &) = delete;
+  void operator=(FrameArena const &) = delete;
+};
+
+///////////////////////////////////////////////////////////////// ArenaAllocator
+
+template <typename T>
+class ArenaAllocator {
+ public:
+  using value_type = T;
+
+  ArenaAllocator() : Arena(&FrameArena::getLocal()) {}
+  explicit ArenaAllocator(FrameArena &arena) : Arena(&arena) {}
+  template <typename U>
+  ArenaAllocator(const ArenaAllocator<U> &other) : Arena(other.getArena()) {}
+
+  T *allocate(std::size_t n) {
+    return static_cast<T *>(Arena->allocate(n * sizeof(T), alignof(T)));
+  }
+  void deallocate(T *p, std::size_t n) { Arena->deallocate(p, n * sizeof(T)); }
+  FrameArena *getArena() const { return Arena; }
+
+ private:
+  FrameArena *Arena;
+};
+
+template <typename T, typename U>
+bool operator==(const ArenaAllocator<T> &a, const ArenaAllocator<U> &b) {
+  return a.getArena() == b.getArena();
+}
+
+template <typename T, typename U>
+bool operator!=(const ArenaAllocator<T> &a, const ArenaAllocator<U> &b) {
+  return a.getArena() != b.getArena();
+}
+
+template <typename T>
+using FrameVector = std::vector<T, ArenaAllocator<T>>;
+
+////////////////////////////////////////////////////////////////////////////////
+}  // namespace mgl
+
+#endif /* MGL_FRAME_ARENA_HPP */
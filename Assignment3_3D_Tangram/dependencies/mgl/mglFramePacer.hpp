@@ -0,0 +1,69 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Frame Pacing
+//
+// FramePacer holds the Engine to a target frame rate, independently of vsync.
+// Each wait() sleeps until shortly before the next frame is due and spins for
+// the rest, as sleeps overshoot by up to a scheduler tick; the spin margin
+// trades CPU time for precision. Frames are scheduled from when the previous
+// one was due, not from when it actually started, so that small overshoots do
+// not accumulate, unless the frame is late by a whole period or more.
+//
+// When the Engine reports that nothing changed in the last frame, the idle
+// rate applies instead, which saves power while the scene is static.
+//
+// The interval between frames is measured whether or not a target is set, so
+// that vsync alone can be checked too; frames around idle ones are left out.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef MGL_FRAME_PACER_HPP
+#define MGL_FRAME_PACER_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+
+namespace mgl {
+
+class FramePacer;
+
+///////////////////////////////////////////////////////////////////// FramePacer
+
+class FramePacer {
+ public:
+  struct Jitter {
+    uint32_t frames = 0;  // intervals measured
+    double mean = 0.0, stddev = 0.0, min = 0.0, max = 0.0;  // milliseconds
+    uint32_t late = 0;  // longer than one and a half target periods
+  };
+
+  FramePacer();
+  void setTargetFps(double fps);  // 0 leaves the rate to vsync
+  void setIdleFps(double fps);    // while nothing changes, 0 disables
+  void setSpinMargin(double milliseconds);
+  bool isIdleEnabled();
+  double getRemaining(bool idle);  // seconds until the next frame is due
+  void wait(bool idle);            // until the next frame is due, then starts it
+  void reset();
+
+  Jitter getJitter();
+  void report(std::ostream &os);
+
+ private:
+  using Clock = std::chrono::steady_clock;
+  double TargetPeriod, IdlePeriod, SpinMargin;  // seconds
+  bool Started, LastIdle;
+  Clock::time_point Scheduled;  // when the current frame was due
+  Clock::time_point LastStart;  // when it actually started
+  uint32_t Frames, Late;
+  double Mean, M2, Min, Max;  // running, in seconds
+
+  double getPeriod(bool idle);
+  void addInterval(double seconds);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+}  // namespace mgl
+
+#endif /* MGL_FRAME_PACER_HPP */
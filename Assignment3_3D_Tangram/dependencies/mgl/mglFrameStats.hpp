@@ -0,0 +1,66 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Frame Statistics and Baselines
+//
+// Collects CPU and GPU frame times, and the CPU time of each Engine phase,
+// for the frames of a benchmark run. The report is JSON with percentiles
+// under "metrics" and histograms under "histograms"; a saved report serves as
+// the baseline of later runs. A baseline may also hold a "tolerances" object
+// of percentages per metric, which override the one given to compare().
+// Input latency is only known for the frames that applied some input.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef MGL_FRAME_STATS_HPP
+#define MGL_FRAME_STATS_HPP
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace mgl {
+
+class FrameStats;
+
+enum FramePhase {
+  PHASE_EVENTS,
+  PHASE_DISPLAY,
+  PHASE_SWAP,
+  PHASE_GPU_WAIT,  // see Engine::setFramesInFlight()
+  FRAME_PHASES
+};
+
+/////////////////////////////////////////////////////////////////// FrameStats
+
+class FrameStats {
+ public:
+  struct Summary {
+    double p50 = 0.0, p95 = 0.0, p99 = 0.0, max = 0.0, mean = 0.0;
+  };
+
+  void reset(uint32_t first_frame, uint32_t frames);
+  void addCpu(uint32_t frame, double cpu, const double (&phases)[FRAME_PHASES]);
+  void addGpu(uint32_t frame, double gpu);  // may arrive frames later
+  void addInputLatency(uint32_t frame, double latency);
+  bool hasGpu();
+
+  std::map<std::string, double> getMetrics();  // in milliseconds
+  bool writeReport(const std::string &filename);
+  // Returns false if any metric is worse than the baseline by more than its
+  // tolerance, in percent. Maxima are only compared with an explicit one.
+  bool compare(const std::string &baseline, double tolerance);
+
+ private:
+  static const int SERIES = 3 + FRAME_PHASES;  // cpu, gpu, phases, latency
+  uint32_t FirstFrame = 0;
+  std::vector<double> Series[SERIES];
+  std::vector<bool> GpuValid;
+
+  static Summary summarize(std::vector<double> values);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+}  // namespace mgl
+
+#endif /* MGL_FRAME_STATS_HPP */
@@ -0,0 +1,81 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// OpenGL Call Counters
+//
+// Counts the GL calls issued per frame by category, together with the bytes
+// uploaded to buffers and the triangles submitted. install() replaces the
+// GLEW entry points of the counted functions with wrappers that bump a
+// counter and call through, so it must run after glewInit(); the cost is one
+// extra indirect call per GL call, and nothing at all when not installed.
+//
+// OpenGL 1.1 functions (glClear, glEnable, glDrawElements, ...) are exported
+// by the system library rather than loaded by GLEW, and are not counted.
+// Draws are therefore counted for glDrawElementsBaseVertex and the other
+// post-1.1 draw calls only, which is what mgl uses.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef MGL_GL_COUNTERS_HPP
+#define MGL_GL_COUNTERS_HPP
+
+#include <cstdint>
+
+namespace mgl {
+
+class GLCounters;
+
+enum GLCallCategory {
+  GL_CALL_DRAW,
+  GL_CALL_PROGRAM,  // glUseProgram
+  GL_CALL_UNIFORM,
+  GL_CALL_BIND,    // buffers, vertex arrays, framebuffers, textures
+  GL_CALL_UPLOAD,  // glBufferData, glBufferSubData
+  GL_CALL_CATEGORIES
+};
+
+struct GLCallCounts {
+  uint64_t calls[GL_CALL_CATEGORIES] = {};
+  uint64_t bytes = 0;      // uploaded to buffers
+  uint64_t triangles = 0;  // submitted by draw calls, times instances
+};
+
+///////////////////////////////////////////////////////////////////// GLCounters
+
+class GLCounters {
+ public:
+  static GLCounters &getInstance();
+
+  void install();  // after glewInit(), on the thread owning the context
+  bool isInstalled();
+  void setSummaryInterval(unsigned int frames);  // 0 disables the summary
+
+  void endFrame();  // called by the Engine after each frame
+  const GLCallCounts &getFrame();    // last completed frame
+  const GLCallCounts &getCurrent();  // frame in progress
+  // Drops whatever was counted since getCurrent() returned these counts,
+  // so that tools such as the HUD do not count themselves.
+  void rewind(const GLCallCounts &counts);
+  const GLCallCounts &getTotal();    // since install()
+  uint64_t getFrames();
+
+  static const char *getCategoryName(GLCallCategory category);
+
+ private:
+  GLCounters();
+  bool Installed;
+  unsigned int SummaryInterval;
+  GLCallCounts Frame, Total, Interval;
+  uint64_t Frames;
+  unsigned int IntervalFrames;
+
+  void printSummary();
+
+ public:
+  GLCounters(GLCounters const &) = delete;
+  void operator=(GLCounters const &) = delete;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+}  // namespace mgl
+
+#endif /* MGL_GL_COUNTERS_HPP */
@@ -0,0 +1,134 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// OpenGL Object Handles
+//
+// A GLObject owns one OpenGL name and, when destroyed or reset, hands it to
+// the DeletionQueue instead of deleting it on the spot: deleting an object the
+// GPU may still be reading from can stall the driver. The queue fences each
+// frame's releases at the end of the frame and deletes them once that fence
+// has signalled, at most a budget of objects per frame, so that unloading a
+// large scene is spread over several frames instead of causing a hitch.
+//
+// Objects may be released from any thread; the queue itself must be driven
+// from the thread owning the GL context. flush() deletes everything left,
+// without waiting, and must be called before the context is destroyed.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef MGL_GL_OBJECT_HPP
+#define MGL_GL_OBJECT_HPP
+
+#include <GL/glew.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <vector>
+
+namespace mgl {
+
+enum GLObjectType {
+  GL_OBJECT_BUFFER,
+  GL_OBJECT_VERTEX_ARRAY,
+  GL_OBJECT_TEXTURE,
+  GL_OBJECT_PROGRAM,
+  GL_OBJECT_FRAMEBUFFER,
+  GL_OBJECT_RENDERBUFFER,
+  GL_OBJECT_QUERY
+};
+
+class DeletionQueue;
+template <GLObjectType TYPE>
+class GLObject;
+
+////////////////////////////////////////////////////////////////// DeletionQueue
+
+class DeletionQueue {
+ public:
+  static const unsigned int DEFAULT_BUDGET = 256;  // objects per frame
+
+  static DeletionQueue &getInstance();
+  void release(GLObjectType type, GLuint id);
+  void setBudget(unsigned int objects);  // per frame, 0 for no limit
+  void endFrame();  // fences this frame's releases, deletes what is due
+  void flush();     // deletes everything now
+  std::size_t getPending();  // not deleted yet
+  uint64_t getDeleted();
+
+ private:
+  struct Object {
+    GLObjectType type;
+    GLuint id;
+  };
+  struct Batch {
+    GLsync fence;
+    std::vector<Object> objects;
+    std::size_t next;  // objects before it are deleted
+  };
+
+  DeletionQueue();
+  std::mutex Mutex;  // guards Released only
+  std::vector<Object> Released;
+  // Batches are moved between the lists, never freed, so that once the
+  // vectors have grown, retiring and deleting objects does not allocate.
+  std::list<Batch> Retired, Spare;
+  unsigned int Budget;
+  uint64_t Deleted;
+
+  static void destroy(const Object &object);
+
+ public:
+  DeletionQueue(DeletionQueue const &) = delete;
+  void operator=(DeletionQueue const &) = delete;
+};
+
+/////////////////////////////////////////////////////////////////////// GLObject
+
+template <GLObjectType TYPE>
+class GLObject {
+ public:
+  GLObject() : Id(0) {}
+  explicit GLObject(GLuint id) : Id(id) {}
+  GLObject(GLObject &&other) noexcept : Id(other.detach()) {}
+  GLObject &operator=(GLObject &&other) noexcept {
+    reset(other.detach());
+    return *this;
+  }
+  ~GLObject() { reset(); }
+
+  GLuint get() const { return Id; }
+  explicit operator bool() const { return Id != 0; }
+  void reset(GLuint id = 0) {  // releases the current object, if any
+    if (Id) DeletionQueue::getInstance().release(TYPE, Id);
+    Id = id;
+  }
+  GLuint detach() {  // gives up ownership without releasing
+    const GLuint id = Id;
+    Id = 0;
+    return id;
+  }
+
+  GLObject(GLObject const &) = delete;
+  void operator=(GLObject const &) = delete;
+
+ private:
+  GLuint Id;
+};
+
+using GLBuffer = GLObject<GL_OBJECT_BUFFER>;
+using GLVertexArray = GLObject<GL_OBJECT_VERTEX_ARRAY>;
+using GLTexture = GLObject<GL_OBJECT_TEXTURE>;
+using GLProgram = GLObject<GL_OBJECT_PROGRAM>;
+using GLFramebuffer = GLObject<GL_OBJECT_FRAMEBUFFER>;
+using GLRenderbuffer = GLObject<GL_OBJECT_RENDERBUFFER>;
+using GLQuery = GLObject<GL_OBJECT_QUERY>;
+
+GLBuffer createBuffer();
+GLVertexArray createVertexArray();
+GLTexture createTexture();
+
+////////////////////////////////////////////////////////////////////////////////
+}  // namespace mgl
+
+#endif /* MGL_GL_OBJECT_HPP */
@@ -0,0 +1,104 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// OpenGL Command Trace
+//
+// GLTraceRecorder captures the GL command stream into a binary trace, with
+// the data of every buffer upload and shader source, so that GLTracePlayer
+// can re-issue it later in another context without the app that made it.
+// The recorder wraps the GLEW entry points, as GLCounters does, so it must
+// be installed right after glewInit() to see the resources being created.
+//
+// Only the post-1.1 entry points mgl uses for buffers, vertex arrays,
+// shaders, uniforms and draws are captured. Fixed-function state (glEnable,
+// glViewport, glClear, ...) is exported by the system library and cannot be
+// wrapped; the player relies on the Engine setting it up as it did when the
+// trace was captured. Textures and queries are not captured.
+//
+// Trace format (little-endian): the 8-byte magic "MGLTRACE", a uint32
+// version, the uint16 viewport width and height, then one record per call:
+// uint16 opcode, uint32 payload size and the payload. Arguments are stored
+// as they were passed; data is stored as a uint32 size and the bytes. A
+// GL_TRACE_FRAME record starts every frame; what comes before the first one
+// sets up the resources.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef MGL_GL_TRACE_HPP
+#define MGL_GL_TRACE_HPP
+
+#include <GL/glew.h>
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace mgl {
+
+class GLTraceRecorder;
+class GLTracePlayer;
+
+//////////////////////////////////////////////////////////////// GLTraceRecorder
+
+class GLTraceRecorder {
+ public:
+  static GLTraceRecorder &getInstance();
+
+  // Captures the given number of frames, 0 for all, after the setup.
+  bool open(const std::string &filename, uint32_t frames);
+  bool isOpen();
+  // After glewInit(), on the thread owning the context.
+  void install(uint16_t width, uint16_t height);
+  void setPaused(bool paused);  // e.g. around the HUD, which is not replayed
+  void beginFrame();
+  void endFrame();  // writes out the frame, closes after the last one
+  void close();
+
+ private:
+  GLTraceRecorder();
+  std::ofstream File;
+  std::string Filename;
+  uint32_t FrameLimit, Frames;
+  bool Installed;
+
+ public:
+  GLTraceRecorder(GLTraceRecorder const &) = delete;
+  void operator=(GLTraceRecorder const &) = delete;
+};
+
+////////////////////////////////////////////////////////////////// GLTracePlayer
+
+// Object names, uniform locations and block indices are translated from the
+// ones of the capture to the ones of the current context through tables
+// indexed by the captured values, so that replay costs no lookups.
+class GLTracePlayer {
+ public:
+  bool open(const std::string &filename);
+  uint16_t getWidth();
+  uint16_t getHeight();
+  uint32_t getFrameCount();
+  std::size_t getCommandCount(uint32_t frame);
+  void setup();  // creates the resources, needs the GL context
+  void play(uint32_t frame);
+
+ private:
+  enum ObjectType { BUFFER, VERTEX_ARRAY, SHADER, PROGRAM, OBJECT_TYPES };
+  std::vector<char> Data;
+  std::size_t SetupEnd = 0;
+  std::vector<std::size_t> FrameStarts;  // offsets, plus the end of the data
+  std::vector<std::size_t> FrameCommands;
+  uint16_t Width = 0, Height = 0;
+  std::vector<GLuint> Names[OBJECT_TYPES];
+  std::vector<std::vector<GLint>> Locations;  // per captured program
+  std::vector<std::vector<GLuint>> BlockIndices;
+  GLuint Program = 0;  // captured name of the program in use
+
+  GLuint &name(ObjectType type, GLuint captured);
+  GLint location(GLint captured);
+  void execute(std::size_t begin, std::size_t end);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+}  // namespace mgl
+
+#endif /* MGL_GL_TRACE_HPP */
@@ -0,0 +1,94 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Compile-Time Geometry
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef MGL_GEOMETRY_HPP
+#define MGL_GEOMETRY_HPP
+
+#include <cstddef>
+
+namespace mgl {
+
+template <std::size_t V, std::size_t I>
+struct Geometry;
+
+/////////////////////////////////////////////////////////////////////// Geometry
+
+template <std::size_t V, std::size_t I>
+struct Geometry {
+  static const unsigned int N_VERTICES = V;
+  static const unsigned int N_INDICES = I;
+
+  float Positions[V][3] = {};
+  float Normals[V][3] = {};
+  unsigned int Indices[I] = {};
+};
+
+constexpr float constexprSqrt(float x) {
+  if (x <= 0.0f) return 0.0f;
+  float r = x > 1.0f ? x : 1.0f;
+  for (int i = 0; i < 32; i++) r = 0.5f * (r + x / r);
+  return r;
+}
+
+////////////////////////////////////////////////////////////////////// Extrusion
+
+// Extrudes a convex, counter-clockwise polygon in the XY plane along Z,
+// between -depth/2 and depth/2. Every face gets its own vertices so that
+// normals stay flat, as in the exported .obj pieces.
+
+template <std::size_t N>
+using Extrusion = Geometry<6 * N, 12 * N - 12>;
+
+template <std::size_t N>
+constexpr Extrusion<N> extrude(const float (&polygon)[N][2], float depth) {
+  Extrusion<N> g;
+  const float h = depth * 0.5f;
+  unsigned int v = 0, i = 0;
+
+  // front (+Z) and back (-Z) caps, triangulated as fans
+  for (int side = 0; side < 2; side++) {
+    const float z = side == 0 ? h : -h;
+    const unsigned int base = v;
+    for (std::size_t k = 0; k < N; k++) {
+      g.Positions[v][0] = polygon[k][0];
+      g.Positions[v][1] = polygon[k][1];
+      g.Positions[v][2] = z;
+      g.Normals[v][2] = side == 0 ? 1.0f : -1.0f;
+      v++;
+    }
+    for (unsigned int k = 1; k + 1 < N; k++) {
+      g.Indices[i++] = base;
+      g.Indices[i++] = side == 0 ? base + k : base + k + 1;
+      g.Indices[i++] = side == 0 ? base + k + 1 : base + k;
+    }
+  }
+
+  // one quad per edge, facing outwards
+  for (std::size_t k = 0; k < N; k++) {
+    const float *a = polygon[k];
+    const float *b = polygon[(k + 1) % N];
+    const float dx = b[0] - a[0], dy = b[1] - a[1];
+    const float length = constexprSqrt(dx * dx + dy * dy);
+    const float nx = dy / length, ny = -dx / length;
+    const float quad[4][3] = {
+        {a[0], a[1], h}, {a[0], a[1], -h}, {b[0], b[1], -h}, {b[0], b[1], h}};
+    const unsigned int base = v;
+    for (int q = 0; q < 4; q++) {
+      for (int c = 0; c < 3; c++) g.Positions[v][c] = quad[q][c];
+      g.Normals[v][0] = nx;
+      g.Normals[v][1] = ny;
+      v++;
+    }
+    const unsigned int order[6] = {0, 1, 2, 0, 2, 3};
+    for (unsigned int o : order) g.Indices[i++] = base + o;
+  }
+  return g;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+}  // namespace mgl
+
+#endif /* MGL_GEOMETRY_HPP */
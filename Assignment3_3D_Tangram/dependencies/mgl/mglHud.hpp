@@ -0,0 +1,73 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Performance HUD
+//
+// An overlay with a rolling frame-time graph and counters: frame time, draw
+// calls, triangles and uploads (when GLCounters is installed) and the memory
+// of the process. Text comes from an embedded 5x7 bitmap font; all text and
+// graph quads go into one dynamic vertex buffer drawn with a single call.
+// The text is only rebuilt a few times per second; the graph every frame.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef MGL_HUD_HPP
+#define MGL_HUD_HPP
+
+#include <GL/glew.h>
+
+#include <vector>
+
+#include "./mglGLObject.hpp"
+#include "./mglShader.hpp"
+
+namespace mgl {
+
+class Hud;
+
+//////////////////////////////////////////////////////////////////////////// Hud
+
+class Hud {
+ public:
+  static const int GRAPH_SAMPLES = 120;
+  static const int MAX_QUADS = 1024;
+  static constexpr double TEXT_INTERVAL = 250.0;  // milliseconds
+
+  Hud();  // needs a current OpenGL context
+  ~Hud();
+  void addFrame(double milliseconds);
+  void draw();
+
+ private:
+  struct Vertex {
+    GLfloat x, y, u, v;
+    GLubyte color[4];
+  };
+
+  ShaderProgram *Shaders;
+  GLVertexArray Vao;
+  GLBuffer Vbo;
+  GLTexture Texture;
+  GLint ViewportId;
+  double FrameTimes[GRAPH_SAMPLES];
+  int NextFrame;
+  double TextTime, TextFrames, TextMax;
+  std::vector<Vertex> Text;
+  std::vector<Vertex> Vertices;
+
+  void createAtlas();
+  void createShaders();
+  void createBuffers();
+  void buildText();
+  void addText(std::vector<Vertex> &vertices, float x, float y,
+               const char *text);
+  static void addQuad(std::vector<Vertex> &vertices, float x, float y,
+                      float w, float h, float u0, float v0, float u1,
+                      float v1, const GLubyte (&color)[4]);
+  void addSolid(std::vector<Vertex> &vertices, float x, float y, float w,
+                float h, const GLubyte (&color)[4]);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+}  // namespace mgl
+
+#endif /* MGL_HUD_HPP */
@@ -0,0 +1,105 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Input Recording and Replay
+//
+// The Engine can log every GLFW callback, together with the elapsed time of
+// each frame, and later feed the log back through the same App callbacks on
+// a simulated clock, so that a run can be repeated exactly.
+//
+// Log format (little-endian): the 8-byte magic "MGLINPUT", a uint32 version,
+// then one record per event: uint8 type, uint32 frame, float64 time and a
+// payload whose size depends on the type.
+//
+// The InputQueue hands the same events, stamped with when they were queued,
+// to code that applies them later than the App callbacks, e.g. just before
+// drawing, possibly on another thread.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef MGL_INPUT_HPP
+#define MGL_INPUT_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace mgl {
+
+class InputRecorder;
+class InputReplayer;
+class InputQueue;
+
+enum InputEventType : uint8_t {
+  INPUT_FRAME,  // d[0] is the elapsed time passed to displayCallback()
+  INPUT_WINDOW_CLOSE,
+  INPUT_WINDOW_SIZE,   // i: width, height
+  INPUT_CURSOR,        // d: xpos, ypos
+  INPUT_KEY,           // i: key, scancode, action, mods
+  INPUT_MOUSE_BUTTON,  // i: button, action, mods
+  INPUT_SCROLL,        // d: xoffset, yoffset
+  INPUT_JOYSTICK,      // i: jid, event
+  INPUT_EVENT_TYPES
+};
+
+struct InputEvent {
+  InputEventType type;
+  uint32_t frame;
+  double time;  // seconds since Engine::run() started
+  int32_t i[4];
+  double d[2];
+};
+
+////////////////////////////////////////////////////////////////// InputRecorder
+
+class InputRecorder {
+ public:
+  bool open(const std::string &filename);
+  void record(const InputEvent &event);
+  void close();
+
+ private:
+  std::ofstream File;
+};
+
+////////////////////////////////////////////////////////////////// InputReplayer
+
+class InputReplayer {
+ public:
+  bool open(const std::string &filename);
+  bool next(uint32_t frame, InputEvent &event);  // next event of that frame
+  uint32_t getFrameCount();  // frames recorded
+  bool isDone();
+
+ private:
+  std::vector<InputEvent> Events;
+  std::size_t Next = 0;
+};
+
+///////////////////////////////////////////////////////////////////// InputQueue
+
+// Lock-free ring for a single producer and a single consumer thread, which
+// may be the same. It never blocks: when full, new events are dropped.
+class InputQueue {
+ public:
+  static const uint32_t CAPACITY = 256;
+
+  bool push(const InputEvent &event);  // producer
+  bool pop(InputEvent &event);         // consumer
+  // Consumer: the queueing time of the oldest event popped since the last
+  // call, or a negative value if none was.
+  double takeOldest();
+  uint32_t getDropped();
+
+ private:
+  InputEvent Events[CAPACITY];
+  std::atomic<uint32_t> Head{0}, Tail{0};  // free running, next pop and push
+  std::atomic<uint32_t> Dropped{0};
+  double Oldest = -1.0;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+}  // namespace mgl
+
+#endif /* MGL_INPUT_HPP */
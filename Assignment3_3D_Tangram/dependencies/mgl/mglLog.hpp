@@ -0,0 +1,137 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Asynchronous Logging
+//
+// MGL_LOG_ERROR(...), MGL_LOG_WARNING(...), MGL_LOG_INFO(...) and
+// MGL_LOG_DEBUG(...) take a stream expression, e.g.
+//
+//   MGL_LOG_WARNING("Cannot write " << filename);
+//
+// Levels below MGL_LOG_LEVEL (LOG_DEBUG in DEBUG builds, LOG_INFO otherwise)
+// are discarded at compile time, message formatting included. Each call site
+// logs at most RATE_LIMIT messages per second; the number of messages it
+// suppressed is appended to the next one it logs.
+//
+// Messages go to a queue of the logging thread, without locking, and a writer
+// thread prints them in order to std::cerr, in batches, every few
+// milliseconds. When a queue is full its messages are dropped and counted.
+// Whatever is queued when the program exits, exit() included, is written out.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef MGL_LOG_HPP
+#define MGL_LOG_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace mgl {
+
+class LogSite;
+class LogQueue;
+class Logger;
+
+enum LogLevel { LOG_DEBUG, LOG_INFO, LOG_WARNING, LOG_ERROR };
+
+#ifndef MGL_LOG_LEVEL
+#ifdef DEBUG
+#define MGL_LOG_LEVEL mgl::LOG_DEBUG
+#else
+#define MGL_LOG_LEVEL mgl::LOG_INFO
+#endif
+#endif
+
+constexpr bool isLogged(LogLevel level) { return level >= MGL_LOG_LEVEL; }
+
+//////////////////////////////////////////////////////////////////////// LogSite
+
+// The rate limit of one call site, shared by all threads logging from it.
+class LogSite {
+ public:
+  static const uint32_t RATE_LIMIT = 10;  // messages per second
+  bool allow();
+  uint32_t takeSuppressed();
+
+ private:
+  std::atomic<int64_t> WindowStart{0};  // milliseconds
+  std::atomic<uint32_t> Count{0}, Suppressed{0};
+};
+
+/////////////////////////////////////////////////////////////////////// LogQueue
+
+// Lock-free ring of one producer thread, drained by the writer.
+class LogQueue {
+ public:
+  struct Entry {
+    uint64_t sequence;
+    LogLevel level;
+    std::string text;
+  };
+  static const uint32_t CAPACITY = 1024;
+
+  bool push(Entry &entry);  // moves the text out on success
+  bool pop(Entry &entry);
+
+ private:
+  Entry Entries[CAPACITY];
+  std::atomic<uint32_t> Head{0}, Tail{0};
+};
+
+///////////////////////////////////////////////////////////////////////// Logger
+
+class Logger {
+ public:
+  static Logger &getInstance();
+  void write(LogLevel level, LogSite &site, std::string text);
+  void flush();  // writes out everything queued so far
+
+ private:
+  Logger();
+  std::mutex QueuesMutex;  // only taken when a thread first logs
+  std::vector<std::unique_ptr<LogQueue>> Queues;
+  std::mutex DrainMutex;  // the writer, flush() and exit take turns
+  std::vector<LogQueue::Entry> Batch;
+  std::atomic<uint64_t> Sequence{0};
+  std::atomic<uint32_t> Dropped{0};
+  std::atomic<bool> Stopping{false}, Stopped{false};
+  std::thread Writer;
+
+  LogQueue &getQueue();
+  void run();
+  void drain();
+  static void print(LogLevel level, const std::string &text);
+  static void stop();
+
+ public:
+  Logger(Logger const &) = delete;
+  void operator=(Logger const &) = delete;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+}  // namespace mgl
+
+#define MGL_LOG(level, message)                                         \
+  do {                                                                  \
+    if constexpr (mgl::isLogged(level)) {                               \
+      static mgl::LogSite mgl_log_site;                                 \
+      if (mgl_log_site.allow()) {                                       \
+        std::ostringstream mgl_log_stream;                              \
+        mgl_log_stream << message;                                      \
+        mgl::Logger::getInstance().write(level, mgl_log_site,           \
+                                         mgl_log_stream.str());         \
+      }                                                                 \
+    }                                                                   \
+  } while (0)
+
+#define MGL_LOG_DEBUG(message) MGL_LOG(mgl::LOG_DEBUG, message)
+#define MGL_LOG_INFO(message) MGL_LOG(mgl::LOG_INFO, message)
+#define MGL_LOG_WARNING(message) MGL_LOG(mgl::LOG_WARNING, message)
+#define MGL_LOG_ERROR(message) MGL_LOG(mgl::LOG_ERROR, message)
+
+#endif /* MGL_LOG_HPP */
@@ -0,0 +1,89 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Memory Accounting
+//
+// Meshes, shader programs and cameras each own a MemoryAccount that reports
+// the CPU and GPU bytes they hold to the MemoryRegistry. GPU sizes are what
+// was handed to the driver (buffer sizes, program binaries), not what the
+// driver actually reserves. The registry can be dumped as a table and checked
+// against CPU and GPU budgets.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef MGL_MEMORY_HPP
+#define MGL_MEMORY_HPP
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace mgl {
+
+class MemoryAccount;
+class MemoryRegistry;
+
+enum MemoryKind { MEMORY_MESH, MEMORY_PROGRAM, MEMORY_CAMERA, MEMORY_KINDS };
+
+struct MemoryUsage {
+  MemoryKind kind = MEMORY_KINDS;  // for the total of all kinds
+  std::string name;
+  uint64_t cpu = 0;  // bytes
+  uint64_t gpu = 0;
+};
+
+////////////////////////////////////////////////////////////////// MemoryAccount
+
+class MemoryAccount {
+ public:
+  explicit MemoryAccount(MemoryKind kind);
+  ~MemoryAccount();
+  void setName(const std::string &name);
+  void setCpu(uint64_t bytes);
+  void setGpu(uint64_t bytes);
+  MemoryAccount(MemoryAccount const &) = delete;
+  void operator=(MemoryAccount const &) = delete;
+
+ private:
+  uint32_t Id;
+};
+
+///////////////////////////////////////////////////////////////// MemoryRegistry
+
+class MemoryRegistry {
+ public:
+  static MemoryRegistry &getInstance();
+  static const char *getKindName(MemoryKind kind);
+
+  std::vector<MemoryUsage> getUsage();  // largest first
+  MemoryUsage getTotal();               // kind and name are meaningless
+  MemoryUsage getTotal(MemoryKind kind);
+
+  void setBudget(uint64_t cpu, uint64_t gpu);  // bytes, 0 is unlimited
+  bool checkBudget();  // reports what is over budget
+  void dump(std::ostream &os);
+
+ private:
+  friend class MemoryAccount;
+  MemoryRegistry();
+  std::mutex Mutex;  // accounts are created on loader threads too
+  std::map<uint32_t, MemoryUsage> Accounts;
+  uint32_t NextId;
+  uint64_t CpuBudget, GpuBudget;
+
+  uint32_t add(MemoryKind kind);
+  void remove(uint32_t id);
+  template <typename F>
+  void change(uint32_t id, F f);
+
+ public:
+  MemoryRegistry(MemoryRegistry const &) = delete;
+  void operator=(MemoryRegistry const &) = delete;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+}  // namespace mgl
+
+#endif /* MGL_MEMORY_HPP */
@@ -19,6 +19,9 @@
 #include <string>
 #include <vector>
 
+#include "./mglGLObject.hpp"
+#include "./mglGeometry.hpp"
+#include "./mglMemory.hpp"
 #include "./mglScenegraph.hpp"
 
 namespace mgl {
@@ -27,6 +30,13 @@ class Mesh;
 
 #define CREATE_BITANGENT
 
+// What stays in CPU memory once a mesh has been uploaded.
+enum MeshRetention {
+  RETAIN_ALL,
+  RETAIN_POSITIONS,  // positions and indices, for picking
+  RETAIN_NONE
+};
+
 /////////////////////////////////////////////////////////////////////////// Mesh
 
 class Mesh : public IDrawable {
@@ -43,6 +53,10 @@ class Mesh : public IDrawable {
   Mesh();
   ~Mesh();
 
+  static void setDefaultRetention(MeshRetention retention);  // RETAIN_ALL
+  void setRetention(MeshRetention retention);
+  void setName(const std::string &name);  // as listed in memory reports
+
   void setAssimpFlags(unsigned int flags);
   void joinIdenticalVertices();
   void generateNormals();
@@ -52,16 +66,45 @@ class Mesh : public IDrawable {
   void flipUVs();
 
   void create(const std::string &filename);
+  void create(const void *data, std::size_t size, const std::string &hint);
+  void create(const float (*positions)[3], const float (*normals)[3],
+              unsigned int n_vertices, const unsigned int *indices,
+              unsigned int n_indices);
+  template <std::size_t V, std::size_t I>
+  void create(const Geometry<V, I> &geometry) {
+    create(geometry.Positions, geometry.Normals, V, geometry.Indices, I);
+  }
+
+  // create() split in two: load() only touches the CPU and may run on any
+  // thread; upload() needs the GL context.
+  void load(const std::string &filename);
+  void load(const void *data, std::size_t size, const std::string &hint);
+  void load(const aiScene *scene);  // as is, without Assimp post-processing
+  void load(const float (*positions)[3], const float (*normals)[3],
+            unsigned int n_vertices, const unsigned int *indices,
+            unsigned int n_indices);
+  template <std::size_t V, std::size_t I>
+  void load(const Geometry<V, I> &geometry) {
+    load(geometry.Positions, geometry.Normals, V, geometry.Indices, I);
+  }
+  void upload();  // fails once the retention has released the data
+  bool isUploaded();
   void draw() override;
 
   bool hasNormals();
   bool hasTexcoords();
   bool hasTangentsAndBitangents();
+  const std::vector<glm::vec3> &getPositions();  // empty if not retained
+  const std::vector<unsigned int> &getIndices();
 
  private:
-  GLuint VaoId;
+  static MeshRetention DefaultRetention;
+  GLVertexArray Vao;
   unsigned int AssimpFlags;
-  bool NormalsLoaded, TexcoordsLoaded, TangentsAndBitangentsLoaded;
+  MeshRetention Retention;
+  MemoryAccount Memory;
+  bool NormalsLoaded, TexcoordsLoaded, TangentsAndBitangentsLoaded;  // on CPU
+  bool NormalsUploaded, TexcoordsUploaded, TangentsAndBitangentsUploaded;
 
   struct MeshData {
     unsigned int nIndices = 0;
@@ -79,10 +122,14 @@ class Mesh : public IDrawable {
 #endif
   std::vector<unsigned int> Indices;
 
+  void processImport(Assimp::Importer &importer, const aiScene *scene,
+                     const std::string &name);
   void processScene(const aiScene *scene);
   void processMesh(const aiMesh *mesh);
   void createBufferObjects();
   void destroyBufferObjects();
+  void applyRetention();
+  void updateMemory();
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -62,9 +62,10 @@ namespace mgl {
 		void setPerspectiveMatrix(float fovy, float aspect, float near, float far);
 		void changeProjection();
 
-		void update();
+		bool update();  // whether the view moved since the last update
 		void cursor(double xpos, double ypos);
 		void mouseButton(GLFWwindow* win, int button, int action);
+		void mouseButton(int button, int action, double xpos, double ypos);  // at that cursor position
 		void scroll(double xoffset, double yoffset);
 	};
 
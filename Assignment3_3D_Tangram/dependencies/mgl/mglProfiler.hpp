@@ -0,0 +1,171 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Frame Profiler
+//
+// Scoped CPU and GPU timing markers, exported as Chrome trace-event JSON
+// (chrome://tracing or ui.perfetto.dev). The markers are only compiled in when
+// MGL_PROFILE is defined; otherwise the macros expand to nothing.
+//
+// CPU scopes may be used on any thread and are written, without locking, to a
+// ring buffer owned by that thread. GPU scopes must be used on the thread that
+// owns the OpenGL context: they issue GL_TIMESTAMP queries that are read back
+// a few frames later, and dropped rather than waited for if still pending.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef MGL_PROFILER_HPP
+#define MGL_PROFILER_HPP
+
+#include <GL/glew.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "./mglAllocations.hpp"
+
+namespace mgl {
+
+class Profiler;
+class ProfileScope;
+class GpuProfileScope;
+
+#define MGL_PROFILE_CONCAT_(a, b) a##b
+#define MGL_PROFILE_CONCAT(a, b) MGL_PROFILE_CONCAT_(a, b)
+
+#ifdef MGL_PROFILE
+#define MGL_PROFILE_SCOPE(name) \
+  mgl::ProfileScope MGL_PROFILE_CONCAT(mgl_profile_, __LINE__)(name)
+#define MGL_PROFILE_GPU_SCOPE(name) \
+  mgl::GpuProfileScope MGL_PROFILE_CONCAT(mgl_gpu_profile_, __LINE__)(name)
+#define MGL_PROFILE_FRAME() mgl::Profiler::getInstance().beginFrame()
+#define MGL_PROFILE_THREAD(name) \
+  mgl::Profiler::getInstance().setThreadName(name)
+#define MGL_PROFILE_FLUSH() mgl::Profiler::getInstance().flush()
+#else
+#define MGL_PROFILE_SCOPE(name)
+#define MGL_PROFILE_GPU_SCOPE(name)
+#define MGL_PROFILE_FRAME()
+#define MGL_PROFILE_THREAD(name)
+#define MGL_PROFILE_FLUSH()
+#endif
+
+struct ProfileEvent {
+  const char *name;  // must outlive the profiler, usually a literal
+  int64_t start;     // nanoseconds since the profiler was created
+  int64_t duration;  // nanoseconds
+  uint32_t depth;
+  uint32_t allocations;  // heap allocations made inside the scope
+  uint64_t bytes;
+};
+
+/////////////////////////////////////////////////////////////////////// Profiler
+
+class Profiler {
+ public:
+  static const std::size_t EVENTS_PER_THREAD = 1 << 16;
+  static const int GPU_FRAMES = 4;    // frames in flight before reading back
+  static const int GPU_SCOPES = 64;   // per frame, further scopes are ignored
+
+  static Profiler &getInstance();
+
+  void setThreadName(const char *name);
+  int64_t now();
+
+  void record(const char *name, int64_t start, uint32_t depth,
+              uint32_t allocations = 0, uint64_t bytes = 0);
+  uint32_t enter();  // returns the depth of the new scope
+  void leave();
+
+  void beginFrame();  // reads back the oldest GPU frame without blocking
+  int beginGpu(const char *name);  // returns -1 if no query is available
+  void endGpu(int scope);
+  void flush();  // waits for pending GPU queries and releases them
+
+  bool exportTrace(const std::string &filename);
+  uint64_t getDroppedGpuFrames();
+
+ private:
+  struct ThreadBuffer {
+    uint32_t id;
+    std::string name;
+    std::atomic<uint64_t> count{0};
+    std::unique_ptr<ProfileEvent[]> events;
+  };
+  struct GpuFrame {
+    GLuint queries[2 * GPU_SCOPES];
+    ProfileEvent scopes[GPU_SCOPES];
+    int count = 0;
+  };
+
+  Profiler();
+  ThreadBuffer &getBuffer();
+  ThreadBuffer *createBuffer(const char *name);
+  void push(ThreadBuffer &buffer, const ProfileEvent &event);
+  bool collect(GpuFrame &frame, bool wait);
+
+  const int64_t Epoch;
+  std::mutex BuffersMutex;  // only taken when a thread registers
+  std::vector<std::unique_ptr<ThreadBuffer>> Buffers;
+  ThreadBuffer *Gpu;
+  GpuFrame GpuFrames[GPU_FRAMES];
+  int GpuFrameIndex;
+  uint32_t GpuDepth;
+  bool GpuReady;
+  int64_t GpuOffset;  // CPU minus GPU clock, in nanoseconds
+  uint64_t DroppedGpuFrames;
+
+ public:
+  Profiler(Profiler const &) = delete;
+  void operator=(Profiler const &) = delete;
+};
+
+/////////////////////////////////////////////////////////////////// ProfileScope
+
+class ProfileScope {
+ public:
+  explicit ProfileScope(const char *name)
+      : Name(name),
+        Depth(Profiler::getInstance().enter()),
+        Allocated(Allocations::getThread()),
+        Start(Profiler::getInstance().now()) {}
+  ~ProfileScope() {
+    Profiler &profiler = Profiler::getInstance();
+    profiler.leave();
+    const AllocationCounts allocated = Allocations::getThread();
+    profiler.record(
+        Name, Start, Depth,
+        static_cast<uint32_t>(allocated.allocations - Allocated.allocations),
+        allocated.bytes - Allocated.bytes);
+  }
+  ProfileScope(ProfileScope const &) = delete;
+  void operator=(ProfileScope const &) = delete;
+
+ private:
+  const char *Name;
+  uint32_t Depth;
+  AllocationCounts Allocated;
+  int64_t Start;
+};
+
+//////////////////////////////////////////////////////////////// GpuProfileScope
+
+class GpuProfileScope {
+ public:
+  explicit GpuProfileScope(const char *name)
+      : Scope(Profiler::getInstance().beginGpu(name)) {}
+  ~GpuProfileScope() { Profiler::getInstance().endGpu(Scope); }
+  GpuProfileScope(GpuProfileScope const &) = delete;
+  void operator=(GpuProfileScope const &) = delete;
+
+ private:
+  int Scope;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+}  // namespace mgl
+
+#endif /* MGL_PROFILER_HPP */
@@ -0,0 +1,78 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Resource Manager
+//
+// Hands out reference-counted handles to meshes and shader programs, so that
+// repeated requests share one instance. Resources nobody references any more
+// are only freed when collect() is called, at a point of the app's choosing.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef MGL_RESOURCES_HPP
+#define MGL_RESOURCES_HPP
+
+#include <GL/glew.h>
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "./mglMesh.hpp"
+#include "./mglShader.hpp"
+#include "./mglShaderQueue.hpp"
+
+namespace mgl {
+
+class ResourceManager;
+
+template <class T>
+using Handle = std::shared_ptr<T>;
+
+struct ShaderSource {
+  GLenum type;
+  std::string filename;        // label, and the file used by live reload
+  const char *source;          // null to read filename from disk
+  GLint length = -1;           // -1 if source is null-terminated
+};
+
+//////////////////////////////////////////////////////////////// ResourceManager
+
+class ResourceManager {
+ public:
+  using MeshLoader = std::function<void(Mesh &)>;
+  using ProgramSetup = std::function<void(ShaderProgram &)>;
+
+  void setShaderQueue(ShaderQueue *queue);
+
+  Handle<Mesh> getMesh(const std::string &filename, unsigned int flags);
+  Handle<Mesh> getMesh(const std::string &name, unsigned int flags,
+                       const MeshLoader &loader);
+  Handle<ShaderProgram> getProgram(const std::vector<ShaderSource> &sources,
+                                   const ProgramSetup &setup);
+
+  unsigned int collect();  // returns the number of resources freed
+  std::size_t getMeshCount();
+  std::size_t getProgramCount();
+
+ private:
+  struct MeshKey {
+    std::string name;
+    unsigned int flags;
+    bool operator<(const MeshKey &other) const {
+      return flags != other.flags ? flags < other.flags : name < other.name;
+    }
+  };
+  std::map<MeshKey, Handle<Mesh>> Meshes;
+  std::map<uint64_t, Handle<ShaderProgram>> Programs;
+  ShaderQueue *Queue = nullptr;
+
+  static uint64_t hashSources(const std::vector<ShaderSource> &sources);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+}  // namespace mgl
+
+#endif /* MGL_RESOURCES_HPP */
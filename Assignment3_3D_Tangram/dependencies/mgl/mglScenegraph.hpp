@@ -9,12 +9,17 @@
 #ifndef MGL_SCENEGRAPH_HPP
 #define MGL_SCENEGRAPH_HPP
 
+#include <GL/glew.h>
+
 #include <glm/glm.hpp>
 #include <vector>
 
 namespace mgl {
 
 class IDrawable;
+class Mesh;
+class ShaderProgram;
+class SceneNode;
 
 ////////////////////////////////////////////////////////////////////// IDrawable
 
@@ -23,6 +28,64 @@ class IDrawable {
   virtual void draw(void) = 0;
 };
 
+////////////////////////////////////////////////////////////////////// SceneNode
+
+// A node animates between two model matrices, its box position (0) and its
+// shape position (2), as the left and right arrow keys are held; the current
+// matrix (1) is the one drawn. Nodes without a shader use their parent's.
+// update() returns whether the node moved, i.e. the animation is running.
+// setStage() moves a node to a given stage directly, e.g. from a tween (see
+// mglAnimation.hpp), without its children.
+//
+// To draw on another thread than the one updating, collect() appends the
+// world transforms of the nodes with a mesh, in drawing order, to a snapshot
+// that drawCollected() later consumes instead of the nodes' own matrices.
+// Snapshots used within the frame may be FrameVectors, off the heap.
+class SceneNode {
+ public:
+  glm::vec3 Color = glm::vec3(1.0f);
+
+  void setShader(ShaderProgram *shaders);
+  void setMesh(Mesh *mesh);
+  void addChild(SceneNode *child);
+  void addPosition(int pos, const glm::mat4 &m);
+  std::vector<SceneNode *> &getChildren();
+
+  float getStage();
+  void setStage(float stage);  // from 0 (box) to 1 (shape)
+  bool update(const bool *pressedKeys);
+  void draw(GLint modelMatrixId, GLint colorId,
+            const glm::mat4 &parentTransform = glm::mat4(1.0f),
+            ShaderProgram *parentShader = nullptr);
+  template <typename Allocator>
+  void collect(std::vector<glm::mat4, Allocator> &transforms,
+               const glm::mat4 &parentTransform = glm::mat4(1.0f));
+  void drawCollected(GLint modelMatrixId, GLint colorId,
+                     const glm::mat4 *&transforms,
+                     ShaderProgram *parentShader = nullptr);
+
+ private:
+  glm::mat4 M[3] = {glm::mat4(1.0f), glm::mat4(1.0f), glm::mat4(1.0f)};
+  float AnimationStage = 0.0f;
+  float PrevAnimationStage = 0.0f;
+  float AnimationStep = 0.005f;
+  ShaderProgram *Shaders = nullptr;
+  Mesh *NodeMesh = nullptr;
+  std::vector<SceneNode *> Children;
+
+  void pose();
+};
+
+template <typename Allocator>
+void SceneNode::collect(std::vector<glm::mat4, Allocator> &transforms,
+                        const glm::mat4 &parentTransform) {
+  const glm::mat4 totalTransform = parentTransform * M[1];
+  if (NodeMesh) transforms.push_back(totalTransform);
+  for (SceneNode *child : Children) {
+    child->collect(transforms, totalTransform);
+  }
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 }  // namespace mgl
 
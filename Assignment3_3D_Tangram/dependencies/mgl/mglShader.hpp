@@ -15,6 +15,9 @@
 #include <map>
 #include <string>
 
+#include "./mglGLObject.hpp"
+#include "./mglMemory.hpp"
+
 namespace mgl {
 
 class ShaderProgram;
@@ -27,8 +30,9 @@ class ShaderProgram {
 
   struct ShaderInfo {
     GLuint index;
+    std::string filename;
   };
-  std::map<GLenum, GLuint> Shaders;
+  std::map<GLenum, ShaderInfo> Shaders;
 
   struct AttributeInfo {
     GLuint index;
@@ -49,6 +53,8 @@ class ShaderProgram {
   ShaderProgram();
   ~ShaderProgram();
   void addShader(const GLenum shader_type, const std::string &filename);
+  void addShader(const GLenum shader_type, const std::string &filename,
+                 const char *source, const GLint length = -1);
   void addAttribute(const std::string &name, const GLuint index);
   bool isAttribute(const std::string &name);
   void addUniform(const std::string &name);
@@ -59,11 +65,38 @@ class ShaderProgram {
   void bind();
   void unbind();
 
+  // Non-blocking build: submit() issues the link, isReady() polls the driver
+  // (GL_KHR_parallel_shader_compile) and finish() queries the results.
+  void submit();
+  bool isReady();
+  void finish();
+  bool isLinked();
+
+  // Live reload: rebuild() recompiles the sources into a second program that
+  // replaces ProgramId only once pollRebuild() sees it linked successfully.
+  // Programs that may have been drawn with go to the DeletionQueue; pending
+  // ones never were, and are deleted on the spot.
+  void rebuild();
+  bool isRebuilding();
+  bool pollRebuild();
+
  private:
+  bool Linked;
+  GLuint PendingId;
+  std::map<GLenum, GLuint> PendingShaders;
+  MemoryAccount Memory;
+
   const std::string read(const std::string &filename);
-  const GLuint checkCompilation(const GLuint shader_id,
-                                const std::string &filename);
-  void checkLinkage();
+  const GLuint compileShader(const GLenum shader_type,
+                             const std::string &filename);
+  const GLuint compileShader(const GLenum shader_type, const char *source,
+                             const GLint length = -1);
+  bool checkCompilation(const GLuint shader_id, const std::string &filename);
+  bool checkLinkage(const GLuint program_id);
+  bool isComplete(const GLuint program_id);
+  void bindAttributes(const GLuint program_id);
+  void resolveLocations();
+  void updateMemory();
 };
 
 ////////////////////////////////////////////////////////////////////////////////
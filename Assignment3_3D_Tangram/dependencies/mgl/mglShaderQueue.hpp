@@ -0,0 +1,95 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Shader Compile Queue and Live Reload
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef MGL_SHADER_QUEUE_HPP
+#define MGL_SHADER_QUEUE_HPP
+
+#include <GL/glew.h>
+
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "./mglShader.hpp"
+
+namespace mgl {
+
+class FileWatcher;
+class ShaderQueue;
+
+//////////////////////////////////////////////////////////////////// FileWatcher
+
+// With inotify, a thread of its own waits for changes and calls the listener
+// as they happen, so nothing needs polling; otherwise poll() compares the
+// modification times, see isPolling().
+class FileWatcher {
+ public:
+  // Without inotify, modification times are compared at most this often.
+  static constexpr double POLL_INTERVAL = 0.5;  // seconds
+
+  FileWatcher();
+  ~FileWatcher();
+  // Called on the watcher thread; set before watching any file.
+  void setListener(std::function<void()> listener);
+  void watch(const std::string &filename);  // ignored if not on disk
+  void unwatch(const std::string &filename);
+  bool isWatched(const std::string &filename);
+  bool isPolling();  // files are watched by modification time only
+  std::vector<std::string> poll();  // never blocks
+
+ private:
+  struct FileInfo {
+    std::string filename;
+    std::filesystem::path path;
+    std::filesystem::file_time_type time;
+  };
+  std::mutex Mutex;  // the watcher thread reads the files too
+  std::vector<FileInfo> Files;
+  double LastPoll;
+  std::function<void()> Listener;
+#ifdef __linux__
+  int Fd, StopFd;
+  std::map<int, std::filesystem::path> Directories;
+  std::vector<std::string> Changed;  // since the last poll()
+  std::thread Thread;  // started by the first watch()
+
+  void run();
+#endif
+};
+
+//////////////////////////////////////////////////////////////////// ShaderQueue
+
+// Changed files wake on-demand drawing: the watcher invalidates the frame
+// or, without inotify, the Engine polls it while idle.
+class ShaderQueue {
+ public:
+  ShaderQueue();
+  ~ShaderQueue();
+  void add(ShaderProgram *program);
+  void watch(ShaderProgram *program);
+  void remove(ShaderProgram *program);
+  bool update();  // true when a program was linked or swapped in
+  bool isIdle();  // nothing being linked or rebuilt
+  void wait();
+
+ private:
+  std::vector<ShaderProgram *> Pending;
+  std::vector<ShaderProgram *> Watched;
+  std::vector<std::string> Changed;  // polled, not yet reloaded
+  FileWatcher Watcher;
+  bool IdlePolling;  // by the Engine, see Engine::setIdlePoll()
+
+  bool pollFiles();
+};
+
+////////////////////////////////////////////////////////////////////////////////
+}  // namespace mgl
+
+#endif /* MGL_SHADER_QUEUE_HPP */
@@ -0,0 +1,57 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Lock-Free Triple Buffer
+//
+// Hands values from one writer thread to one reader thread without either
+// ever waiting for the other. The writer fills its back slot and publishes
+// it by swapping it with the middle one; the reader takes the middle slot in
+// exchange for its front one whenever a newer value was published, and
+// otherwise keeps reading the same one. Values the reader was too slow to
+// take are overwritten, so it always sees the latest complete one.
+//
+// Slots are reused, never reallocated, so a value whose members keep their
+// capacity (e.g. vectors cleared and refilled) costs no allocations.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef MGL_TRIPLE_BUFFER_HPP
+#define MGL_TRIPLE_BUFFER_HPP
+
+#include <atomic>
+#include <cstdint>
+
+namespace mgl {
+
+template <typename T>
+class TripleBuffer;
+
+/////////////////////////////////////////////////////////////////// TripleBuffer
+
+template <typename T>
+class TripleBuffer {
+ public:
+  T &getBack() { return Slots[Back]; }  // writer only
+  void publish() {
+    Back = Middle.exchange(Back | FRESH, std::memory_order_acq_rel) & INDEX;
+  }
+  bool isPending() {  // published, not yet taken by the reader
+    return Middle.load(std::memory_order_acquire) & FRESH;
+  }
+  const T &read() {  // reader only
+    if (Middle.load(std::memory_order_relaxed) & FRESH) {
+      Front = Middle.exchange(Front, std::memory_order_acq_rel) & INDEX;
+    }
+    return Slots[Front];
+  }
+
+ private:
+  static const uint8_t INDEX = 3, FRESH = 4;
+  T Slots[3];
+  uint8_t Back = 0, Front = 1;
+  std::atomic<uint8_t> Middle{2};
+};
+
+////////////////////////////////////////////////////////////////////////////////
+}  // namespace mgl
+
+#endif /* MGL_TRIPLE_BUFFER_HPP */
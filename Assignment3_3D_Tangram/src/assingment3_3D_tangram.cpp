@@ -15,209 +15,189 @@
 #include <glm/gtx/transform.hpp>
 #include <glm/gtx/string_cast.hpp>
 #include <glm/gtx/matrix_interpolation.hpp>
+#include <atomic>
+#include <cmath>
+#include <memory>
 #include <vector>
 #include <iostream>
 
 #include "../mgl/mgl.hpp"
+#include "./generated/shaders.hpp"
 
 
-///////////////////////////////////////////////////////////////////////// SCENE NODE CLASS
-
-class SceneNode {
-private:
-    glm::mat4 M[3]; // three model matrices: 0 - box position, 1 - current position, and 2 - tangram shape position
-    int positionId = 0;
-
-    float animationStage = 0.0f;
-    float prevAnimationStage = 0.0f;
-    float animationStep = 0.005f;
-
-    mgl::ShaderProgram* shaders = nullptr;
-
-public:
-    glm::vec3 color;
-    std::vector<SceneNode*> children;
-    mgl::Mesh* mesh;
-
-    void setShader(mgl::ShaderProgram* s) {
-        shaders = s;
-    }
-
-    void setMesh(mgl::Mesh* m) {
-        mesh = m;
-    }
-
-    void addChild(SceneNode* child) {
-        children.push_back(child);
-    }
-
-    void draw(GLint modelMatrixId, GLint colorId, const glm::mat4& parentTransform = glm::mat4(1.0f), mgl::ShaderProgram* parentShader = nullptr) {
-        glm::mat4 totalTransform = parentTransform * M[1];
-
-        if (mesh) {
-            if (!shaders) { shaders = parentShader; }
-            shaders->bind();
-            glUniformMatrix4fv(modelMatrixId, 1, GL_FALSE, glm::value_ptr(totalTransform));
-            glUniform3f(colorId, color[0], color[1], color[2]);
-            mesh->draw();
-            shaders->unbind();
-        }
-
-        for (SceneNode* child : children) {
-            child->draw(modelMatrixId, colorId, totalTransform, shaders);
-        }
-    }
-
-    void update(bool* pressedKeys) {
-        if (pressedKeys[GLFW_KEY_LEFT]) {
-            animationStage -= animationStep;
-        }
-        if (pressedKeys[GLFW_KEY_RIGHT]) {
-            animationStage += animationStep;
-        }
-        animationStage = glm::clamp(animationStage, 0.0f, 1.0f);
-
-        if (animationStage == prevAnimationStage) {
-            prevAnimationStage = animationStage;
-            return;
-        }
-        prevAnimationStage = animationStage;
-
-        //Linear interpolation for translation
-        glm::vec3 initialTranslation = glm::vec3(M[0][3]);
-        glm::vec3 finalTranslation = glm::vec3(M[2][3]);
-        glm::vec3 currentTranslation = glm::mix(initialTranslation, finalTranslation, animationStage);
-
-
-        //Linear interpolation for rotation
-        glm::mat3 initialRotationMatrix = glm::mat3(M[0]);
-        glm::mat3 finalRotationMatrix = glm::mat3(M[2]);
-
-        // Normalize the columns to remove scaling effects
-        for (int i = 0; i < 3; ++i) {
-            initialRotationMatrix[i] = glm::normalize(initialRotationMatrix[i]);
-            finalRotationMatrix[i] = glm::normalize(finalRotationMatrix[i]);
-        }
-        glm::quat initialRotation = glm::quat_cast(initialRotationMatrix);
-        glm::quat finalRotation = glm::quat_cast(finalRotationMatrix);
-        glm::quat currentRotation = glm::lerp(initialRotation, finalRotation, animationStage);
-
-
-        // Linear interpolation for scaling. Scaling doesnt change so we can just use initial scale
-        glm::vec3 currentScale = glm::vec3(glm::length(M[0][0]), glm::length(M[0][1]), glm::length(M[0][2]));
-
-        M[1] = glm::translate(currentTranslation) * glm::toMat4(currentRotation) * glm::scale(currentScale);
-
-        for (SceneNode* child : children) {
-            child->update(pressedKeys);
-        }
-    }
-
-    void addPosition(int pos, glm::mat4 m) {
-        M[pos] = m;
-    }
-};
-
 ////////////////////////////////////////////////////////////////////////// MYAPP
 
 class MyApp : public mgl::App {
 public:
+    void preloadCallback() override;
     void initCallback(GLFWwindow* win) override;
+    void updateCallback(GLFWwindow* win, double elapsed) override;
     void displayCallback(GLFWwindow* win, double elapsed) override;
     void windowSizeCallback(GLFWwindow* win, int width, int height) override;
     void keyCallback(GLFWwindow* win, int key, int scancode, int action, int mods) override;
-    void cursorCallback(GLFWwindow* win, double xpos, double ypos) override;
-    void mouseButtonCallback(GLFWwindow* win, int button, int action, int mods) override;
-    void scrollCallback(GLFWwindow* win, double xoffset, double yoffset) override;
+
+    void setAssetPack(mgl::AssetPack* pack);
+    void setScripted(bool scripted);
+    void setDemo(bool demo);
+    void setSceneCopies(int copies);
 
 private:
-    mgl::ShaderProgram* Shaders = nullptr;
+    // what updateCallback() hands over to displayCallback(), possibly running
+    // on another thread; the cameras belong to the latter, see latchCamera()
+    struct FrameState {
+        std::vector<glm::mat4> transforms;  // see SceneNode::collect()
+    };
+
+    mgl::AssetPack* Assets = nullptr;
+    mgl::ResourceManager Resources;
+    mgl::Handle<mgl::ShaderProgram> Shaders;
+    std::vector<mgl::ShaderSource> ShaderSources;
+    mgl::ShaderQueue* ShaderQueue = nullptr;
 
     //  root node for the scene
-    SceneNode root = SceneNode();
-    SceneNode triangle1 = SceneNode();
-    SceneNode triangle2 = SceneNode();
-    SceneNode triangle3 = SceneNode();
-    SceneNode triangle4 = SceneNode();
-    SceneNode triangle5 = SceneNode();
-    SceneNode square = SceneNode();
-    SceneNode parallelogram = SceneNode();
+    mgl::SceneNode root = mgl::SceneNode();
+    mgl::SceneNode triangle1 = mgl::SceneNode();
+    mgl::SceneNode triangle2 = mgl::SceneNode();
+    mgl::SceneNode triangle3 = mgl::SceneNode();
+    mgl::SceneNode triangle4 = mgl::SceneNode();
+    mgl::SceneNode triangle5 = mgl::SceneNode();
+    mgl::SceneNode square = mgl::SceneNode();
+    mgl::SceneNode parallelogram = mgl::SceneNode();
+    std::vector<std::unique_ptr<mgl::SceneNode>> copies;  // generated for benchmarks
+    int sceneCopies = 1;
+    bool scripted = false;
+    bool demo = false;
+    mgl::Animator animator;
 
     const GLuint UBO_BP[2] = { 0, 1 };
     mgl::OrbitCamera* Cameras[2] = { nullptr, nullptr };
     int cameraId = 1;
+    double cursorX = 0.0, cursorY = 0.0;  // as last applied to the cameras
+    mgl::TripleBuffer<FrameState> states;
+    std::atomic<bool> resized = false;
 
     GLint ModelMatrixId;
     GLint ColorId;
-    std::vector<mgl::Mesh*> meshes;  // Vector to store multiple meshes
+    std::vector<mgl::Handle<mgl::Mesh>> meshes;  // Vector to store multiple meshes
 
-    bool pressedKeys[GLFW_KEY_LAST];
+    bool pressedKeys[GLFW_KEY_LAST + 1] = {};  // cleared, so that replays start alike
 
-    void createMeshes();
+    void loadMeshes();
+    void uploadMeshes();
+    template <std::size_t V, std::size_t I>
+    mgl::Handle<mgl::Mesh> createMesh(const std::string& name, const mgl::Geometry<V, I>& geometry);
+    void loadShaderSources();
     void createShaderPrograms();
+    void updateShaderPrograms();
     void createCamera();
+    bool latchCamera();
     void createScene();
-    void drawScene();
+    void createSceneCopies();
+    void drawScene(const FrameState& state);
+    mgl::Animation script();
+    mgl::Animation assemble();
 };
 
 ///////////////////////////////////////////////////////////////////////// MESHES
 
-void MyApp::createMeshes() {
-    std::string mesh_dir = "./assets/models/";
-
-    std::string mesh_file = "triangular-prism.obj";
-    mgl::Mesh* prismMesh = new mgl::Mesh();
-    prismMesh->joinIdenticalVertices();
-    prismMesh->create(mesh_dir + mesh_file);
-    meshes.push_back(prismMesh);
-
-
-    mesh_file = "cube.obj";
-    mgl::Mesh* squareMesh = new mgl::Mesh();
-    squareMesh->joinIdenticalVertices();
-    squareMesh->create(mesh_dir + mesh_file);
-    meshes.push_back(squareMesh);
+// Piece outlines of the models in ./assets/models/, extruded at compile time
+// so that no mesh file is opened at startup.
+constexpr float PRISM_FACE[3][2] = { {-0.707107f, 0.0f}, {0.0f, 0.0f}, {-0.353553f, 0.353553f} };
+constexpr float CUBE_FACE[4][2] = { {-0.5f, 0.0f}, {0.0f, 0.0f}, {0.0f, 0.5f}, {-0.5f, 0.5f} };
+constexpr float PARALLELEPIPED_FACE[4][2] = { {-0.5f, 0.0f}, {0.0f, 0.0f}, {-0.5f, 0.5f}, {-1.0f, 0.5f} };
+
+constexpr auto PRISM_GEOMETRY = mgl::extrude(PRISM_FACE, 0.5f);
+constexpr auto CUBE_GEOMETRY = mgl::extrude(CUBE_FACE, 0.5f);
+constexpr auto PARALLELEPIPED_GEOMETRY = mgl::extrude(PARALLELEPIPED_FACE, 0.5f);
+
+// Loads the model from the asset pack if one was given, straight from the
+// mapped memory, or else uses the built-in geometry. Either way the resource
+// manager only loads it the first time it is asked for. Runs in the preload,
+// so it only prepares the CPU side of the mesh.
+template <std::size_t V, std::size_t I>
+mgl::Handle<mgl::Mesh> MyApp::createMesh(const std::string& name, const mgl::Geometry<V, I>& geometry) {
+    const std::string path = "assets/models/" + name;
+    if (Assets && Assets->contains(path)) {
+        return Resources.getMesh(path, aiProcess_Triangulate | aiProcess_JoinIdenticalVertices,
+            [&](mgl::Mesh& mesh) {
+                mgl::AssetPack::Asset asset = Assets->get(path);
+                mesh.load(asset.data, asset.size, name.substr(name.rfind('.') + 1));
+            });
+    }
+    return Resources.getMesh("builtin/" + name, 0,
+        [&](mgl::Mesh& mesh) { mesh.load(geometry); });
+}
 
+void MyApp::loadMeshes() {
+    meshes.push_back(createMesh("triangular-prism.obj", PRISM_GEOMETRY));
+    meshes.push_back(createMesh("cube.obj", CUBE_GEOMETRY));
+    meshes.push_back(createMesh("parallelepiped.obj", PARALLELEPIPED_GEOMETRY));
+}
 
-    mesh_file = "parallelepiped.obj";
-    mgl::Mesh* parallelepipedMesh = new mgl::Mesh();
-    parallelepipedMesh->joinIdenticalVertices();
-    parallelepipedMesh->create(mesh_dir + mesh_file);
-    meshes.push_back(parallelepipedMesh);
+void MyApp::uploadMeshes() {
+    for (mgl::Handle<mgl::Mesh>& mesh : meshes) {
+        mesh->upload();
+    }
 }
 
 ///////////////////////////////////////////////////////////////////////// SHADER
 
-void MyApp::createShaderPrograms() {
-    Shaders = new mgl::ShaderProgram();
-    Shaders->addShader(GL_VERTEX_SHADER, "./src/shaders/vertex_shader.glsl");
-    Shaders->addShader(GL_FRAGMENT_SHADER, "./src/shaders/frag_shader.glsl");
-
-    Shaders->addAttribute(mgl::POSITION_ATTRIBUTE, mgl::Mesh::POSITION);
-
-    if (!meshes.empty()) {
-        mgl::Mesh* mesh = meshes[0];
-
-        Shaders->addAttribute(mgl::POSITION_ATTRIBUTE, mgl::Mesh::POSITION);
-        if (mesh->hasNormals()) {
-            Shaders->addAttribute(mgl::NORMAL_ATTRIBUTE, mgl::Mesh::NORMAL);
+void MyApp::loadShaderSources() {
+    // embedded at build time unless the asset pack overrides them; the paths
+    // are also used for live reload
+    ShaderSources = {
+        { GL_VERTEX_SHADER, "./src/shaders/vertex_shader.glsl", mgl::embedded::VERTEX_SHADER_GLSL },
+        { GL_FRAGMENT_SHADER, "./src/shaders/frag_shader.glsl", mgl::embedded::FRAG_SHADER_GLSL } };
+    for (mgl::ShaderSource& source : ShaderSources) {
+        mgl::AssetPack::Asset asset;
+        if (Assets) {
+            asset = Assets->get(source.filename);
         }
-        if (mesh->hasTexcoords()) {
-            Shaders->addAttribute(mgl::TEXCOORD_ATTRIBUTE, mgl::Mesh::TEXCOORD);
-        }
-        if (mesh->hasTangentsAndBitangents()) {
-            Shaders->addAttribute(mgl::TANGENT_ATTRIBUTE, mgl::Mesh::TANGENT);
+        if (asset) {
+            source.source = asset.data;
+            source.length = static_cast<GLint>(asset.size);
         }
     }
+}
 
-    Shaders->addUniform(mgl::MODEL_MATRIX);
-    Shaders->addUniform(mgl::COLOR);
-    Shaders->addUniformBlock(mgl::CAMERA_BLOCK, UBO_BP[0]);
+void MyApp::createShaderPrograms() {
+    Shaders = Resources.getProgram(ShaderSources, [&](mgl::ShaderProgram& program) {
+        program.addAttribute(mgl::POSITION_ATTRIBUTE, mgl::Mesh::POSITION);
+
+        if (!meshes.empty()) {
+            mgl::Mesh* mesh = meshes[0].get();
+
+            program.addAttribute(mgl::POSITION_ATTRIBUTE, mgl::Mesh::POSITION);
+            if (mesh->hasNormals()) {
+                program.addAttribute(mgl::NORMAL_ATTRIBUTE, mgl::Mesh::NORMAL);
+            }
+            if (mesh->hasTexcoords()) {
+                program.addAttribute(mgl::TEXCOORD_ATTRIBUTE, mgl::Mesh::TEXCOORD);
+            }
+            if (mesh->hasTangentsAndBitangents()) {
+                program.addAttribute(mgl::TANGENT_ATTRIBUTE, mgl::Mesh::TANGENT);
+            }
+        }
+
+        program.addUniform(mgl::MODEL_MATRIX);
+        program.addUniform(mgl::COLOR);
+        program.addUniformBlock(mgl::CAMERA_BLOCK, UBO_BP[0]);
+    });
 
-    Shaders->create();
+    // linked in the background; drawing starts once the queue reports it
+    if (!ShaderQueue) {
+        ShaderQueue = new mgl::ShaderQueue();
+        Resources.setShaderQueue(ShaderQueue);
+    }
+    ShaderQueue->add(Shaders.get());
+    ShaderQueue->watch(Shaders.get());
+}
 
-    ModelMatrixId = Shaders->Uniforms[mgl::MODEL_MATRIX].index;
-    ColorId = Shaders->Uniforms[mgl::COLOR].index;
+void MyApp::updateShaderPrograms() {
+    if (ShaderQueue->update()) {
+        ModelMatrixId = Shaders->Uniforms[mgl::MODEL_MATRIX].index;
+        ColorId = Shaders->Uniforms[mgl::COLOR].index;
+    }
 }
 
 ///////////////////////////////////////////////////////////////////////// CAMERA
@@ -236,6 +216,42 @@ void MyApp::createCamera() {
     Cameras[1]->setPerspectiveMatrix(30.0f, 800.0f / 600.0f, 1.0f, 10.0f);
 }
 
+// Applies the input queued since the last frame, late in displayCallback(),
+// so that the view is as recent as possible when the frame is drawn.
+bool MyApp::latchCamera() {
+    mgl::Engine& engine = mgl::Engine::getInstance();
+    engine.latchInput();
+    mgl::InputEvent event;
+    while (engine.getInputQueue().pop(event)) {
+        switch (event.type) {
+        case mgl::INPUT_CURSOR:
+            cursorX = event.d[0], cursorY = event.d[1];
+            Cameras[cameraId]->cursor(cursorX, cursorY);
+            break;
+        case mgl::INPUT_MOUSE_BUTTON:
+            Cameras[cameraId]->mouseButton(event.i[0], event.i[1], cursorX, cursorY);
+            break;
+        case mgl::INPUT_SCROLL:
+            Cameras[cameraId]->scroll(event.d[0], event.d[1]);
+            break;
+        case mgl::INPUT_KEY:
+            if (event.i[2] == GLFW_RELEASE && event.i[0] == GLFW_KEY_C) {
+                cameraId = (cameraId + 1) % 2;
+                Cameras[cameraId]->activate();
+            }
+            else if (event.i[2] == GLFW_RELEASE && event.i[0] == GLFW_KEY_P) {
+                Cameras[cameraId]->changeProjection();
+            }
+            break;
+        default:
+            break;
+        }
+    }
+    const bool moving = Cameras[cameraId]->update();
+    Cameras[cameraId]->upload();
+    return moving;
+}
+
 /////////////////////////////////////////////////////////////////////////// DRAW
 
 glm::mat4 I(1.0f);
@@ -246,21 +262,21 @@ glm::mat4 M;
 
 void MyApp::createScene() {
 
-    mgl::Mesh* triangleMesh = meshes[0];
-    mgl::Mesh* squareMesh = meshes[1];
-    mgl::Mesh* parallelogramMesh = meshes[2];
+    mgl::Mesh* triangleMesh = meshes[0].get();
+    mgl::Mesh* squareMesh = meshes[1].get();
+    mgl::Mesh* parallelogramMesh = meshes[2].get();
     float side = 0.5f;
     float hypotenuse = sqrt(2 * pow(side, 2));
     float triangleHeight = hypotenuse / 2;
 
-    root.setShader(Shaders);
+    root.setShader(Shaders.get());
     M = I;
     root.addPosition(0, M);
     root.addPosition(1, M);
     root.addPosition(2, M);
 
     // Draw triangles
-    triangle1.setShader(Shaders);
+    triangle1.setShader(Shaders.get());
     triangle1.setMesh(triangleMesh);
     triangle1.addPosition(0, M); // set box matrix model
     triangle1.addPosition(1, M); // set animation matrix equal to initial position matrix model
@@ -268,10 +284,10 @@ void MyApp::createScene() {
     T = glm::translate(glm::vec3(0.0f, side, -side));
     M = T * R;
     triangle1.addPosition(2, M); // set tangram shape matrix model
-    triangle1.color = glm::vec3(0.0f, 0.62f, 0.65f);
+    triangle1.Color = glm::vec3(0.0f, 0.62f, 0.65f);
     root.addChild(&triangle1);
 
-    triangle2.setShader(Shaders);
+    triangle2.setShader(Shaders.get());
     triangle2.setMesh(triangleMesh);
     R = glm::rotate(glm::radians(-90.0f), glm::vec3(0, 0, 1));
     T = glm::translate(glm::vec3(-triangleHeight - hypotenuse, triangleHeight, 0.0f));
@@ -282,10 +298,10 @@ void MyApp::createScene() {
     T = glm::translate(glm::vec3(0.0f, 0.0f, side));
     M = T * R;
     triangle2.addPosition(2, M);
-    triangle2.color = glm::vec3(0.92f, 0.28f, 0.15f);
+    triangle2.Color = glm::vec3(0.92f, 0.28f, 0.15f);
     root.addChild(&triangle2);
 
-    triangle3.setShader(Shaders);
+    triangle3.setShader(Shaders.get());
     triangle3.setMesh(triangleMesh);
     S = glm::scale(glm::vec3(sqrt(2), sqrt(2), 1));
     R = glm::rotate(glm::radians(135.0f), glm::vec3(0, 0, 1));
@@ -298,10 +314,10 @@ void MyApp::createScene() {
     T = glm::translate(glm::vec3(0.0f, 0.0f, 0.0f));
     M = T * R * S;
     triangle3.addPosition(2, M);
-    triangle3.color = glm::vec3(0.43f, 0.23f, 0.75f);
+    triangle3.Color = glm::vec3(0.43f, 0.23f, 0.75f);
     root.addChild(&triangle3);
 
-    triangle4.setShader(Shaders);
+    triangle4.setShader(Shaders.get());
     triangle4.setMesh(triangleMesh);
     S = glm::scale(glm::vec3(2, 2, 1));
     R = glm::rotate(glm::radians(90.0f), glm::vec3(0, 0, 1));
@@ -313,10 +329,10 @@ void MyApp::createScene() {
     T = glm::translate(glm::vec3(0.0f, side, 2.0f * hypotenuse));
     M = T * R * S;
     triangle4.addPosition(2, M);
-    triangle4.color = glm::vec3(0.80f, 0.05f, 0.4f);
+    triangle4.Color = glm::vec3(0.80f, 0.05f, 0.4f);
     root.addChild(&triangle4);
 
-    triangle5.setShader(Shaders);
+    triangle5.setShader(Shaders.get());
     triangle5.setMesh(triangleMesh);
     S = glm::scale(glm::vec3(2, 2, 1));
     R = glm::rotate(glm::radians(180.0f), glm::vec3(1, 0, 0));
@@ -328,12 +344,12 @@ void MyApp::createScene() {
     T = glm::translate(glm::vec3(0.0f, 0.0f, 0.0f * hypotenuse));
     M = T * R * S;
     triangle5.addPosition(2, M);
-    triangle5.color = glm::vec3(0.06f, 0.51f, 0.95f);
+    triangle5.Color = glm::vec3(0.06f, 0.51f, 0.95f);
     root.addChild(&triangle5);
 
 
     // draw square
-    square.setShader(Shaders);
+    square.setShader(Shaders.get());
     square.setMesh(squareMesh);
     R = glm::rotate(glm::radians(45.0f), glm::vec3(0, 0, 1));
     T = glm::translate(glm::vec3(-triangleHeight, triangleHeight, 0.0f));
@@ -344,12 +360,12 @@ void MyApp::createScene() {
     T = glm::translate(glm::vec3(0.0f, 0.0f, 2.0f * hypotenuse));
     M = T * R;
     square.addPosition(2, M);
-    square.color = glm::vec3(0.13f, 0.67f, 0.14f);
+    square.Color = glm::vec3(0.13f, 0.67f, 0.14f);
     root.addChild(&square);
 
 
     // draw parallelogram
-    parallelogram.setShader(Shaders);
+    parallelogram.setShader(Shaders.get());
     parallelogram.setMesh(parallelogramMesh);
     R = glm::rotate(glm::radians(-45.0f), glm::vec3(0, 0, 1));
     T = glm::translate(glm::vec3(-1.5f * hypotenuse, triangleHeight, 0.0f));
@@ -360,75 +376,414 @@ void MyApp::createScene() {
     T = glm::translate(glm::vec3(0.0f, 0.0f, side));
     M = T * R;
     parallelogram.addPosition(2, M);
-    parallelogram.color = glm::vec3(0.99f, 0.55f, 0.0f);
+    parallelogram.Color = glm::vec3(0.99f, 0.55f, 0.0f);
     root.addChild(&parallelogram);
 
 }
 
-void MyApp::drawScene() {
-    // draw entire scene from root node
-    root.draw(ModelMatrixId, ColorId);
+// Benchmarks can enlarge the scene: the seven pieces are repeated, scaled down
+// to a grid in front of camera B, under group nodes animated from the root.
+void MyApp::createSceneCopies() {
+    mgl::SceneNode* pieces[] = { &triangle1, &triangle2, &triangle3, &triangle4, &triangle5, &square, &parallelogram };
+    const int side = static_cast<int>(std::ceil(std::sqrt(sceneCopies)));
+    const float cell = 4.0f / side;
+    for (int k = 1; k < sceneCopies; k++) {
+        std::unique_ptr<mgl::SceneNode> group = std::make_unique<mgl::SceneNode>();
+        M = glm::translate(glm::vec3(0.0f, cell * (k / side + 0.5f) - 2.0f, cell * (k % side + 0.5f) - 2.0f)) *
+            glm::scale(glm::vec3(1.0f / side));
+        group->addPosition(0, M);
+        group->addPosition(1, M);
+        group->addPosition(2, M);
+        for (mgl::SceneNode* piece : pieces) {
+            copies.push_back(std::make_unique<mgl::SceneNode>(*piece));
+            group->addChild(copies.back().get());
+        }
+        root.addChild(group.get());
+        copies.push_back(std::move(group));
+    }
+}
+
+void MyApp::drawScene(const FrameState& state) {
+    // draw entire scene from root node, as it was when last updated
+    const glm::mat4* transforms = state.transforms.data();
+    root.drawCollected(ModelMatrixId, ColorId, transforms);
 }
 
 ////////////////////////////////////////////////////////////////////// CALLBACKS
 
+void MyApp::setAssetPack(mgl::AssetPack* pack) {
+    Assets = pack;
+}
+
+void MyApp::setScripted(bool script) {
+    scripted = script;
+}
+
+void MyApp::setSceneCopies(int n) {
+    sceneCopies = n;
+}
+
+void MyApp::setDemo(bool d) {
+    demo = d;
+}
+
+// Scripted runs hold the right arrow for 200 frames, then the left one, so
+// that the pieces keep animating between the box and the tangram shape.
+mgl::Animation MyApp::script() {
+    for (;;) {
+        for (bool forward : { true, false }) {
+            pressedKeys[GLFW_KEY_RIGHT] = forward;
+            pressedKeys[GLFW_KEY_LEFT] = !forward;
+            for (int frame = 0; frame < 200; frame++) {
+                co_await mgl::nextFrame();
+            }
+        }
+    }
+}
+
+// The assembly demo: the pieces fly from the box into the tangram shape a few
+// at a time, rest, and go back the same way.
+mgl::Animation MyApp::assemble() {
+    for (;;) {
+        for (float stage : { 1.0f, 0.0f }) {
+            co_await mgl::tween(triangle1, stage, 0.6);
+            co_await mgl::wait(0.2);
+            co_await mgl::all(mgl::tween(square, stage, 0.8), mgl::tween(parallelogram, stage, 0.8));
+            co_await mgl::wait(0.2);
+            co_await mgl::all(mgl::tween(triangle2, stage, 0.6), mgl::tween(triangle3, stage, 0.6),
+                mgl::tween(triangle4, stage, 0.6), mgl::tween(triangle5, stage, 0.6));
+            co_await mgl::wait(1.0);
+        }
+    }
+}
+
+void MyApp::preloadCallback() {
+    loadMeshes();
+    loadShaderSources();
+}
+
 void MyApp::initCallback(GLFWwindow* win) {
-    createMeshes();
+    uploadMeshes();
     createShaderPrograms();  // after mesh;
     createCamera();
     createScene();
+    createSceneCopies();
+    if (scripted) {
+        animator.start(script());
+    }
+    if (demo) {
+        animator.start(assemble());
+    }
 }
 void MyApp::windowSizeCallback(GLFWwindow* win, int winx, int winy) {
-    glViewport(0, 0, 800, 600);
+    resized = true;  // the viewport is reset on the render side
 }
 
 void MyApp::keyCallback(GLFWwindow* win, int key, int scancode, int action, int mods) {
     //std::cout << "key: " << key << " " << scancode << " " << action << " " << mods << std::endl;
-    pressedKeys[key] = action != GLFW_RELEASE;
+    if (key != GLFW_KEY_UNKNOWN) {
+        pressedKeys[key] = action != GLFW_RELEASE;
+    }
 
+    // the camera keys are handled in latchCamera()
     if (action == GLFW_RELEASE) {
         switch (key) {
-        case GLFW_KEY_C:
-            cameraId = (cameraId + 1) % 2;
-            Cameras[cameraId]->activate();
-            break;
-
-        case GLFW_KEY_P:
-            Cameras[cameraId]->changeProjection();
+        case GLFW_KEY_H:
+            mgl::Engine::getInstance().setHudVisible(!mgl::Engine::getInstance().isHudVisible());
             break;
         }
     }
 }
 
-void MyApp::displayCallback(GLFWwindow* win, double elapsed) {
-    Cameras[cameraId]->update();
-    root.update(pressedKeys);
-    drawScene();
-}
-
-void MyApp::cursorCallback(GLFWwindow* win, double xpos, double ypos) {
-    //std::cout << "mouse: " << xpos << " " << ypos << std::endl;
-    Cameras[cameraId]->cursor(xpos, ypos);
-}
-
-void MyApp::mouseButtonCallback(GLFWwindow* win, int button, int action, int mods) {
-    Cameras[cameraId]->mouseButton(win, button, action);
+void MyApp::updateCallback(GLFWwindow* win, double elapsed) {
+    {
+        MGL_PROFILE_SCOPE("Animator::update");
+        animator.update(elapsed);
+    }
+    bool animating;
+    {
+        MGL_PROFILE_SCOPE("SceneNode::update");
+        animating = root.update(pressedKeys);
+    }
+    FrameState& state = states.getBack();
+    state.transforms.clear();
+    root.collect(state.transforms);
+    states.publish();
+    // in on-demand mode, keep drawing while anything is still changing
+    if (animating || !animator.isIdle()) {
+        mgl::Engine::getInstance().invalidate();
+    }
 }
 
-void MyApp::scrollCallback(GLFWwindow* win, double xoffset, double yoffset) {
-    //std::cout << "scroll: " << xoffset << " " << yoffset << std::endl;
-    Cameras[cameraId]->scroll(xoffset, yoffset);
+void MyApp::displayCallback(GLFWwindow* win, double elapsed) {
+    updateShaderPrograms();
+    if (!ShaderQueue->isIdle()) {
+        mgl::Engine::getInstance().invalidate();
+    }
+    if (resized.exchange(false)) {
+        glViewport(0, 0, 800, 600);
+    }
+    const FrameState& state = states.read();
+    bool moving;
+    {
+        MGL_PROFILE_SCOPE("Camera");
+        moving = latchCamera();
+    }
+    if (moving) {
+        mgl::Engine::getInstance().invalidate();
+    }
+    if (Shaders->isLinked()) {
+        MGL_PROFILE_SCOPE("Draw");
+        MGL_PROFILE_GPU_SCOPE("Draw");
+        MGL_CHECK_SCOPE("Draw");
+        drawScene(state);
+    }
+    Resources.collect();
 }
 
 /////////////////////////////////////////////////////////////////////////// MAIN
 
 int main(int argc, char* argv[]) {
+    MyApp* app = new MyApp();
+    std::string traceFile;
+    unsigned int benchmarkFrames = 0, warmupFrames = 60;
+    std::string reportFile, baselineFile;
+    double tolerance = 10.0;
+    bool checkAllocations = false;
+    bool memoryDump = false;
+    bool pacingReport = false;
+    int framesInFlight = 0;
+    bool latencyReport = false;
+    bool arenaReport = false;
+    int vsync = 1;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--startup-report" && i + 1 < argc) {
+            mgl::Engine::getInstance().setStartupReport(argv[++i]);
+        }
+        else if (arg == "--pack" && i + 1 < argc) {
+            mgl::AssetPack* pack = new mgl::AssetPack();
+            if (!pack->open(argv[++i])) {
+                exit(EXIT_FAILURE);
+            }
+            app->setAssetPack(pack);
+        }
+        else if (arg == "--trace" && i + 1 < argc) {
+            traceFile = argv[++i];
+        }
+        else if (arg == "--record" && i + 1 < argc) {
+            if (!mgl::Engine::getInstance().setInputRecording(argv[++i])) {
+                exit(EXIT_FAILURE);
+            }
+        }
+        else if (arg == "--replay" && i + 1 < argc) {
+            if (!mgl::Engine::getInstance().setInputReplay(argv[++i])) {
+                exit(EXIT_FAILURE);
+            }
+        }
+        else if (arg == "--headless") {
+            mgl::Engine::getInstance().setHeadless(true);
+        }
+        else if (arg == "--frames" && i + 1 < argc) {
+            mgl::Engine::getInstance().setFrameLimit(std::stoi(argv[++i]));
+        }
+        else if (arg == "--benchmark" && i + 1 < argc) {
+            benchmarkFrames = std::stoi(argv[++i]);
+        }
+        else if (arg == "--warmup" && i + 1 < argc) {
+            warmupFrames = std::stoi(argv[++i]);
+        }
+        else if (arg == "--report" && i + 1 < argc) {
+            reportFile = argv[++i];
+        }
+        else if (arg == "--baseline" && i + 1 < argc) {
+            baselineFile = argv[++i];
+        }
+        else if (arg == "--tolerance" && i + 1 < argc) {
+            tolerance = std::stod(argv[++i]);
+        }
+        else if (arg == "--gl-stats" && i + 1 < argc) {
+            mgl::Engine::getInstance().setCallCounting(true);
+            mgl::GLCounters::getInstance().setSummaryInterval(std::stoi(argv[++i]));
+        }
+        else if (arg == "--gl-capture" && i + 2 < argc) {
+            // GL calls of the setup and the given number of frames, for mglreplay
+            std::string filename = argv[++i];
+            if (!mgl::Engine::getInstance().setGLCapture(filename, std::stoi(argv[++i]))) {
+                exit(EXIT_FAILURE);
+            }
+        }
+        else if (arg == "--on-demand") {
+            // draws only on input, resizes and animations, otherwise sleeps
+            mgl::Engine::getInstance().setOnDemand(true);
+        }
+        else if (arg == "--vsync" && i + 1 < argc) {
+            // 0 off, 1 on, -1 adaptive
+            vsync = std::stoi(argv[++i]);
+        }
+        else if (arg == "--fps" && i + 1 < argc) {
+            mgl::Engine::getInstance().getFramePacer().setTargetFps(std::stod(argv[++i]));
+        }
+        else if (arg == "--idle-fps" && i + 1 < argc) {
+            // frame rate while the scene is not changing
+            mgl::Engine::getInstance().getFramePacer().setIdleFps(std::stod(argv[++i]));
+        }
+        else if (arg == "--spin-margin" && i + 1 < argc) {
+            mgl::Engine::getInstance().getFramePacer().setSpinMargin(std::stod(argv[++i]));
+        }
+        else if (arg == "--pacing-report") {
+            pacingReport = true;
+        }
+        else if (arg == "--frames-in-flight" && i + 1 < argc) {
+            // 1 for the lowest input latency, up to 3 for throughput
+            framesInFlight = std::stoi(argv[++i]);
+            mgl::Engine::getInstance().setFramesInFlight(framesInFlight);
+        }
+        else if (arg == "--latency-report") {
+            latencyReport = true;
+        }
+        else if (arg == "--gl-check-interval" && i + 1 < argc) {
+            // glGetError in one frame out of every N, 0 for none (needs MGL_GL_CHECKS)
+            setCheckInterval(std::stoi(argv[++i]));
+        }
+        else if (arg == "--gl-check-scope" && i + 1 < argc) {
+            // glGetError in every frame, but only around the named scope
+            setCheckedScope(argv[++i]);
+        }
+        else if (arg == "--deletion-budget" && i + 1 < argc) {
+            // GL objects deleted per frame once unused, 0 for no limit
+            mgl::DeletionQueue::getInstance().setBudget(std::stoi(argv[++i]));
+        }
+        else if (arg == "--arena-size" && i + 1 < argc) {
+            // per-thread scratch for one frame, in KB; grows to the high-water mark
+            mgl::FrameArena::setDefaultCapacity(std::stoul(argv[++i]) * 1024);
+        }
+        else if (arg == "--arena-report") {
+            arenaReport = true;
+        }
+        else if (arg == "--demo") {
+            // plays the assembly choreography instead of waiting for the arrow keys
+            app->setDemo(true);
+        }
+        else if (arg == "--render-thread") {
+            // draws on its own thread while the main one handles input
+            mgl::Engine::getInstance().setRenderThread(true);
+        }
+        else if (arg == "--hud") {
+            mgl::Engine::getInstance().setHudVisible(true);
+            mgl::Engine::getInstance().setCallCounting(true);
+        }
+        else if (arg == "--check-allocations" && i + 1 < argc) {
+            // fails if any frame after the given number of warm-up frames allocates
+            if (!mgl::Allocations::isTracking()) {
+                std::cerr << "ERROR: --check-allocations needs a build with MGL_TRACK_ALLOCATIONS, e.g. the Profile configuration" << std::endl;
+                exit(EXIT_FAILURE);
+            }
+            mgl::Allocations::getInstance().setSteadyState(std::stoi(argv[++i]));
+            checkAllocations = true;
+        }
+        else if (arg == "--scene-copies" && i + 1 < argc) {
+            app->setSceneCopies(std::stoi(argv[++i]));
+        }
+        else if (arg == "--mesh-retention" && i + 1 < argc) {
+            std::string retention = argv[++i];
+            if (retention == "all") {
+                mgl::Mesh::setDefaultRetention(mgl::RETAIN_ALL);
+            }
+            else if (retention == "positions") {
+                mgl::Mesh::setDefaultRetention(mgl::RETAIN_POSITIONS);
+            }
+            else if (retention == "none") {
+                mgl::Mesh::setDefaultRetention(mgl::RETAIN_NONE);
+            }
+            else {
+                std::cerr << "ERROR: --mesh-retention must be all, positions or none" << std::endl;
+                exit(EXIT_FAILURE);
+            }
+        }
+        else if (arg == "--memory-dump") {
+            memoryDump = true;
+        }
+        else if (arg == "--memory-budget" && i + 2 < argc) {
+            // CPU and GPU budgets in KB, 0 for no limit
+            uint64_t cpu = std::stoull(argv[++i]) * 1024;
+            uint64_t gpu = std::stoull(argv[++i]) * 1024;
+            mgl::MemoryRegistry::getInstance().setBudget(cpu, gpu);
+            memoryDump = true;
+        }
+    }
+
     mgl::Engine& engine = mgl::Engine::getInstance();
-    engine.setApp(new MyApp());
-    engine.setOpenGL(4, 6);
-    engine.setWindow(800, 600, "Assignment 3: 3D Tangram", 0, 1);
+    engine.setApp(app);
+    engine.setLateLatching(true);  // the cameras read the input queue
+    // Headless runs ask only for what the shaders need, so that software
+    // rasterizers such as llvmpipe (OpenGL 4.5) can create the context.
+    if (engine.isHeadless()) {
+        engine.setOpenGL(3, 3);
+    }
+    else {
+        engine.setOpenGL(4, 6);
+    }
+    engine.setWindow(800, 600, "Assignment 3: 3D Tangram", 0, vsync);
+    if (benchmarkFrames) {
+        // a recorded session, if given, drives the benchmark instead of the script
+        engine.setBenchmark(warmupFrames, benchmarkFrames);
+        app->setScripted(!engine.isReplaying());
+    }
     engine.init();
     engine.run();
+    if (!traceFile.empty()) {
+        mgl::Profiler::getInstance().exportTrace(traceFile);
+    }
+    if (benchmarkFrames) {
+        mgl::FrameStats& stats = engine.getFrameStats();
+        std::map<std::string, double> metrics = stats.getMetrics();
+        std::cout << "CPU frame [ms]: p50 " << metrics["cpu_p50_ms"] << ", p95 " << metrics["cpu_p95_ms"]
+            << ", p99 " << metrics["cpu_p99_ms"] << ", max " << metrics["cpu_max_ms"] << std::endl;
+        if (stats.hasGpu()) {
+            std::cout << "GPU frame [ms]: p50 " << metrics["gpu_p50_ms"] << ", p95 " << metrics["gpu_p95_ms"]
+                << ", p99 " << metrics["gpu_p99_ms"] << ", max " << metrics["gpu_max_ms"] << std::endl;
+        }
+        if (!reportFile.empty() && !stats.writeReport(reportFile)) {
+            exit(EXIT_FAILURE);
+        }
+        if (!baselineFile.empty() && !stats.compare(baselineFile, tolerance)) {
+            exit(EXIT_FAILURE);
+        }
+    }
+    if (framesInFlight) {
+        const mgl::TimingTotals& wait = engine.getGpuWait();
+        std::cout << "GPU wait [ms]: total " << wait.total << ", max " << wait.max << " over "
+            << wait.frames << " frame(s)" << std::endl;
+    }
+    if (latencyReport) {
+        const mgl::TimingTotals& latency = engine.getInputLatency();
+        std::cout << "Input to present [ms]: mean " << (latency.frames ? latency.total / latency.frames : 0.0)
+            << ", max " << latency.max << " over " << latency.frames << " frame(s)";
+        if (engine.getInputQueue().getDropped()) {
+            std::cout << ", " << engine.getInputQueue().getDropped() << " event(s) dropped";
+        }
+        std::cout << std::endl;
+    }
+    if (pacingReport) {
+        engine.getFramePacer().report(std::cout);
+    }
+    if (arenaReport) {
+        mgl::FrameArena::report(std::cout);
+    }
+    if (memoryDump) {
+        mgl::MemoryRegistry& memory = mgl::MemoryRegistry::getInstance();
+        memory.dump(std::cout);
+        if (!memory.checkBudget()) {
+            exit(EXIT_FAILURE);
+        }
+    }
+    if (checkAllocations) {
+        mgl::Allocations::getInstance().report();
+        if (!mgl::Allocations::getInstance().passedSteadyState()) {
+            exit(EXIT_FAILURE);
+        }
+    }
     exit(EXIT_SUCCESS);
 }
 
@@ -0,0 +1,274 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Heap Allocation Tracking
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "./mglAllocations.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <new>
+#include <vector>
+
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+namespace mgl {
+
+// Counters are only written by their own thread; relaxed loads and stores
+// are enough for other threads to read them, and cheaper than fetch_add.
+struct ThreadAllocations {
+  uint32_t id = 0;
+  const char *name = "Thread";
+  std::atomic<uint64_t> allocations{0};
+  std::atomic<uint64_t> bytes{0};
+  std::atomic<uint64_t> frees{0};
+};
+
+static thread_local ThreadAllocations *LocalAllocations = nullptr;
+static thread_local bool Registering = false;
+
+// Never destroyed, so that threads still allocating during static
+// destruction find them intact.
+static std::mutex &getRegistryMutex() {
+  static std::mutex *mutex = new std::mutex();
+  return *mutex;
+}
+
+static std::vector<ThreadAllocations *> &getRegistry() {
+  static std::vector<ThreadAllocations *> *registry =
+      new std::vector<ThreadAllocations *>();
+  return *registry;
+}
+
+// The allocations made while registering are not counted, which is also what
+// keeps operator new from recursing into here.
+static ThreadAllocations *getLocal() {
+  if (!LocalAllocations && !Registering) {
+    Registering = true;
+    ThreadAllocations *local = new ThreadAllocations();
+    {
+      std::lock_guard<std::mutex> lock(getRegistryMutex());
+      getRegistry().push_back(local);
+      local->id = static_cast<uint32_t>(getRegistry().size());
+    }
+    LocalAllocations = local;
+    Registering = false;
+  }
+  return LocalAllocations;
+}
+
+static void add(std::atomic<uint64_t> &counter, uint64_t n) {
+  counter.store(counter.load(std::memory_order_relaxed) + n,
+                std::memory_order_relaxed);
+}
+
+static void countAllocation(std::size_t size) {
+  ThreadAllocations *local = getLocal();
+  if (!local) return;
+  add(local->allocations, 1);
+  add(local->bytes, size);
+}
+
+static void countFree() {
+  ThreadAllocations *local = getLocal();
+  if (local) add(local->frees, 1);
+}
+
+static AllocationCounts read(const ThreadAllocations &thread) {
+  AllocationCounts counts;
+  counts.allocations = thread.allocations.load(std::memory_order_relaxed);
+  counts.bytes = thread.bytes.load(std::memory_order_relaxed);
+  counts.frees = thread.frees.load(std::memory_order_relaxed);
+  return counts;
+}
+
+//////////////////////////////////////////////////////////////////// Allocations
+
+Allocations::Allocations()
+    : Frames(0), SteadyFrame(0), Checking(false), FailedFrames(0) {}
+
+Allocations &Allocations::getInstance() {
+  static Allocations instance;
+  return instance;
+}
+
+bool Allocations::isTracking() {
+#ifdef MGL_TRACK_ALLOCATIONS
+  return true;
+#else
+  return false;
+#endif
+}
+
+AllocationCounts Allocations::getThread() {
+  return LocalAllocations ? read(*LocalAllocations) : AllocationCounts();
+}
+
+void Allocations::setThreadName(const char *name) {
+  ThreadAllocations *local = getLocal();
+  if (local) local->name = name;
+}
+
+AllocationCounts Allocations::getTotal() {
+  AllocationCounts total;
+  std::lock_guard<std::mutex> lock(getRegistryMutex());
+  for (const ThreadAllocations *thread : getRegistry()) {
+    const AllocationCounts counts = read(*thread);
+    total.allocations += counts.allocations;
+    total.bytes += counts.bytes;
+    total.frees += counts.frees;
+  }
+  return total;
+}
+
+void Allocations::endFrame() {
+  const AllocationCounts total = getTotal();
+  Frame.allocations = total.allocations - Last.allocations;
+  Frame.bytes = total.bytes - Last.bytes;
+  Frame.frees = total.frees - Last.frees;
+  Last = total;
+  if (Checking && Frames >= SteadyFrame && Frame.allocations > 0) {
+    // only the first few, the report has the count; not through the logger,
+    // whose formatting would allocate in the next frame
+    if (++FailedFrames <= 10) {
+      std::cerr << "ERROR: Frame " << Frames << " allocated "
+                << Frame.allocations << " time(s), " << Frame.bytes
+                << " bytes" << std::endl;
+    }
+  }
+  Frames++;
+}
+
+const AllocationCounts &Allocations::getFrame() { return Frame; }
+
+void Allocations::setSteadyState(uint32_t first_frame) {
+  SteadyFrame = first_frame;
+  Checking = true;
+}
+
+bool Allocations::passedSteadyState() { return FailedFrames == 0; }
+
+void Allocations::report() {
+  {
+    std::lock_guard<std::mutex> lock(getRegistryMutex());
+    for (const ThreadAllocations *thread : getRegistry()) {
+      const AllocationCounts counts = read(*thread);
+      std::cout << "Allocations [" << thread->name << " " << thread->id
+                << "]: " << counts.allocations << " allocation(s), "
+                << counts.bytes / 1024.0 << " KB, " << counts.frees
+                << " free(s)" << std::endl;
+    }
+  }
+  if (Checking) {
+    std::cout << "Steady state from frame " << SteadyFrame << ": "
+              << FailedFrames << " of "
+              << (Frames > SteadyFrame ? Frames - SteadyFrame : 0)
+              << " frame(s) allocated" << std::endl;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+}  // namespace mgl
+
+////////////////////////////////////////////////////////////// GLOBAL OPERATORS
+
+#ifdef MGL_TRACK_ALLOCATIONS
+
+void *operator new(std::size_t size) {
+  mgl::countAllocation(size);
+  for (;;) {
+    if (void *p = std::malloc(size ? size : 1)) return p;
+    std::new_handler handler = std::get_new_handler();
+    if (!handler) throw std::bad_alloc();
+    handler();
+  }
+}
+
+void *operator new[](std::size_t size) { return operator new(size); }
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept {
+  try {
+    return operator new(size);
+  } catch (...) {
+    return nullptr;
+  }
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept {
+  return operator new(size, std::nothrow);
+}
+
+void operator delete(void *p) noexcept {
+  if (!p) return;
+  mgl::countFree();
+  std::free(p);
+}
+
+void operator delete[](void *p) noexcept { operator delete(p); }
+
+void operator delete(void *p, std::size_t) noexcept { operator delete(p); }
+
+void operator delete[](void *p, std::size_t) noexcept { operator delete(p); }
+
+void operator delete(void *p, const std::nothrow_t &) noexcept {
+  operator delete(p);
+}
+
+void operator delete[](void *p, const std::nothrow_t &) noexcept {
+  operator delete(p);
+}
+
+#ifdef __cpp_aligned_new
+
+void *operator new(std::size_t size, std::align_val_t alignment) {
+  mgl::countAllocation(size);
+  const std::size_t align = static_cast<std::size_t>(alignment);
+#ifdef _WIN32
+  void *p = _aligned_malloc(size ? size : 1, align);
+#else
+  void *p = nullptr;
+  if (posix_memalign(&p, align < sizeof(void *) ? sizeof(void *) : align,
+                     size ? size : 1) != 0) {
+    p = nullptr;
+  }
+#endif
+  if (!p) throw std::bad_alloc();
+  return p;
+}
+
+void *operator new[](std::size_t size, std::align_val_t alignment) {
+  return operator new(size, alignment);
+}
+
+void operator delete(void *p, std::align_val_t) noexcept {
+  if (!p) return;
+  mgl::countFree();
+#ifdef _WIN32
+  _aligned_free(p);
+#else
+  std::free(p);
+#endif
+}
+
+void operator delete[](void *p, std::align_val_t alignment) noexcept {
+  operator delete(p, alignment);
+}
+
+void operator delete(void *p, std::size_t,
+                     std::align_val_t alignment) noexcept {
+  operator delete(p, alignment);
+}
+
+void operator delete[](void *p, std::size_t,
+                       std::align_val_t alignment) noexcept {
+  operator delete(p, alignment);
+}
+
+#endif /* __cpp_aligned_new */
+
+#endif /* MGL_TRACK_ALLOCATIONS */
@@ -0,0 +1,243 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Coroutine Animations
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "./mglAnimation.hpp"
+
+#include <algorithm>
+#include <exception>
+
+#include <glm/glm.hpp>
+
+#include "./mglScenegraph.hpp"
+
+namespace mgl {
+
+////////////////////////////////////////////////////////////////// AnimationPool
+
+// Never destroyed, as frames may still be freed by static destructors.
+AnimationPool &AnimationPool::getInstance() {
+  static AnimationPool *instance = new AnimationPool();
+  return *instance;
+}
+
+AnimationPool::AnimationPool() : Free(), Reserved(0), InUse(0), Oversized(0) {}
+
+int AnimationPool::getClass(std::size_t bytes) {
+  int c = 0;
+  for (std::size_t size = MIN_BLOCK; size < bytes; size *= 2) {
+    if (++c == CLASSES) return -1;
+  }
+  return c;
+}
+
+void *AnimationPool::allocate(std::size_t bytes) {
+  const int c = getClass(bytes);
+  std::lock_guard<std::mutex> lock(Mutex);
+  InUse++;
+  if (c < 0) {
+    Oversized++;
+    return ::operator new(bytes);
+  }
+  if (!Free[c]) {
+    const std::size_t size = MIN_BLOCK << c;
+    Chunks.emplace_back(new unsigned char[size * BLOCKS_PER_CHUNK]);
+    for (std::size_t i = 0; i < BLOCKS_PER_CHUNK; i++) {
+      Block *block = reinterpret_cast<Block *>(Chunks.back().get() + i * size);
+      block->next = Free[c];
+      Free[c] = block;
+    }
+    Reserved += size * BLOCKS_PER_CHUNK;
+  }
+  Block *block = Free[c];
+  Free[c] = block->next;
+  return block;
+}
+
+void AnimationPool::deallocate(void *p, std::size_t bytes) {
+  const int c = getClass(bytes);
+  std::lock_guard<std::mutex> lock(Mutex);
+  InUse--;
+  if (c < 0) {
+    ::operator delete(p);
+    return;
+  }
+  Block *block = static_cast<Block *>(p);
+  block->next = Free[c];
+  Free[c] = block;
+}
+
+std::size_t AnimationPool::getReserved() {
+  std::lock_guard<std::mutex> lock(Mutex);
+  return Reserved;
+}
+
+std::size_t AnimationPool::getInUse() {
+  std::lock_guard<std::mutex> lock(Mutex);
+  return InUse;
+}
+
+uint64_t AnimationPool::getOversized() {
+  std::lock_guard<std::mutex> lock(Mutex);
+  return Oversized;
+}
+
+////////////////////////////////////////////////////////////////////// Animation
+
+// An animation that was awaited resumes the one awaiting it, straight away,
+// or once the last of its all() has ended; one that was started is done.
+std::coroutine_handle<> Animation::FinalAwaiter::await_suspend(
+    Handle self) noexcept {
+  promise_type &promise = self.promise();
+  if (!promise.Continuation) {
+    promise.Owner->finish(self);
+    return std::noop_coroutine();
+  }
+  if (promise.Remaining && --*promise.Remaining) {
+    return std::noop_coroutine();
+  }
+  return promise.Continuation;
+}
+
+// Animations run inside the frame loop, with nothing to catch what they throw.
+void Animation::promise_type::unhandled_exception() { std::terminate(); }
+
+std::coroutine_handle<> Animation::Awaiter::await_suspend(Handle parent) {
+  Child.promise().Owner = parent.promise().Owner;
+  Child.promise().Continuation = parent;
+  return Child;
+}
+
+Animation &Animation::operator=(Animation &&other) noexcept {
+  if (this != &other) {
+    if (Coroutine) Coroutine.destroy();
+    Coroutine = other.release();
+  }
+  return *this;
+}
+
+Animation::~Animation() {
+  if (Coroutine) Coroutine.destroy();
+}
+
+Animation::Handle Animation::release() {
+  return std::exchange(Coroutine, nullptr);
+}
+
+/////////////////////////////////////////////////////////////////////// Animator
+
+Animator::Animator()
+    : Time(0.0), Elapsed(0.0), TimerOrder(0), Started(nullptr), Running(0) {}
+
+Animator::~Animator() { clear(); }
+
+void Animator::start(Animation animation) {
+  const Animation::Handle handle = animation.release();
+  if (!handle) return;
+  Animation::promise_type &promise = handle.promise();
+  promise.Owner = this;
+  promise.Next = Started;
+  if (Started) Started->Prev = &promise;
+  Started = &promise;
+  Running++;
+  Ready.push_back(handle);
+}
+
+// Resuming may queue more animations for this frame, e.g. those of an all(),
+// so the queue is walked by index as it grows. The queues keep their
+// capacity, so once they are large enough nothing is allocated.
+void Animator::update(double elapsed) {
+  Elapsed = elapsed;
+  Time += elapsed;
+  while (!Timers.empty() && Timers.front().time <= Time) {
+    std::pop_heap(Timers.begin(), Timers.end(), isLater);
+    Ready.push_back(Timers.back().handle);
+    Timers.pop_back();
+  }
+  Ready.insert(Ready.end(), Deferred.begin(), Deferred.end());
+  Deferred.clear();
+  for (std::size_t i = 0; i < Ready.size(); i++) {
+    const std::coroutine_handle<> handle = Ready[i];
+    handle.resume();
+  }
+  Ready.clear();
+}
+
+// Destroying a started animation destroys those it awaits, as they live in
+// its frame; whatever was queued belonged to one of them.
+void Animator::clear() {
+  while (Started) {
+    Animation::promise_type *promise = Started;
+    Started = promise->Next;
+    Animation::Handle::from_promise(*promise).destroy();
+  }
+  Ready.clear();
+  Deferred.clear();
+  Timers.clear();
+  Running = 0;
+}
+
+bool Animator::isIdle() { return Running == 0; }
+
+std::size_t Animator::getRunning() { return Running; }
+
+double Animator::getTime() { return Time; }
+
+double Animator::getElapsed() { return Elapsed; }
+
+void Animator::resume(std::coroutine_handle<> handle) {
+  Ready.push_back(handle);
+}
+
+void Animator::resumeNextFrame(std::coroutine_handle<> handle) {
+  Deferred.push_back(handle);
+}
+
+void Animator::resumeAt(std::coroutine_handle<> handle, double time) {
+  Timers.push_back({time, TimerOrder++, handle});
+  std::push_heap(Timers.begin(), Timers.end(), isLater);
+}
+
+void Animator::finish(Animation::Handle handle) {
+  Animation::promise_type &promise = handle.promise();
+  if (promise.Prev) {
+    promise.Prev->Next = promise.Next;
+  } else {
+    Started = promise.Next;
+  }
+  if (promise.Next) promise.Next->Prev = promise.Prev;
+  Running--;
+  handle.destroy();
+}
+
+bool Animator::isLater(const Timer &a, const Timer &b) {
+  return a.time > b.time || (a.time == b.time && a.order > b.order);
+}
+
+///////////////////////////////////////////////////////////////////// AWAITABLES
+
+void Wait::await_suspend(Animation::Handle self) {
+  Animator *owner = self.promise().Owner;
+  owner->resumeAt(self, owner->getTime() + Seconds);
+}
+
+void NextFrame::await_suspend(Animation::Handle self) {
+  Owner = self.promise().Owner;
+  Owner->resumeNextFrame(self);
+}
+
+double NextFrame::await_resume() { return Owner->getElapsed(); }
+
+Animation tween(SceneNode &node, float stage, double seconds) {
+  const float from = node.getStage();
+  for (double t = 0.0; t < seconds;) {
+    t += co_await nextFrame();
+    node.setStage(glm::mix(from, stage, float(std::min(t / seconds, 1.0))));
+  }
+  if (seconds <= 0.0) node.setStage(stage);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+}  // namespace mgl
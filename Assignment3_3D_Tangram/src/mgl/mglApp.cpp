@@ -8,49 +8,101 @@
 
 #include "./mglApp.hpp"
 
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <future>
 #include <iostream>
+#include <thread>
 
 #include "./mglError.hpp"
+#include "./mglFrameArena.hpp"
+#include "./mglGLCounters.hpp"
+#include "./mglGLObject.hpp"
+#include "./mglGLTrace.hpp"
+#include "./mglLog.hpp"
+#include "./mglProfiler.hpp"
+
+#ifdef __linux__
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
 
 namespace mgl {
 
+////////////////////////////////////////////////////////////////// STARTUP CLOCK
+
+using StartupClock = std::chrono::steady_clock;
+
+// Taken during static initialization, as close to process start as we get.
+static const StartupClock::time_point PROCESS_START = StartupClock::now();
+
+static double millisecondsSince(StartupClock::time_point start) {
+  return std::chrono::duration<double, std::milli>(StartupClock::now() - start)
+      .count();
+}
+
 /////////////////////////////////////////////////////////////// STATIC CALLBACKS
 
 static void window_close_callback(GLFWwindow *window) {
-  Engine::getInstance().getApp()->windowCloseCallback(window);
+  Engine::getInstance().handleInput(window, {INPUT_WINDOW_CLOSE});
 }
 
 static void window_size_callback(GLFWwindow *window, int width, int height) {
-  Engine::getInstance().getApp()->windowSizeCallback(window, width, height);
+  InputEvent event = {INPUT_WINDOW_SIZE};
+  event.i[0] = width, event.i[1] = height;
+  Engine::getInstance().handleInput(window, event);
+}
+
+// The window was uncovered or needs repainting; not input, so not recorded.
+static void window_refresh_callback(GLFWwindow *window) {
+  Engine::getInstance().invalidate();
 }
 
 static void glfw_error_callback(int error, const char *description) {
-  std::cerr << "GLFW Error: " << description << std::endl;
+  MGL_LOG_ERROR("GLFW: " << description);
 }
 
 static void cursor_pos_callback(GLFWwindow *window, double xpos, double ypos) {
-  Engine::getInstance().getApp()->cursorCallback(window, xpos, ypos);
+  InputEvent event = {INPUT_CURSOR};
+  event.d[0] = xpos, event.d[1] = ypos;
+  Engine::getInstance().handleInput(window, event);
 }
 
 static void key_callback(GLFWwindow *window, int key, int scancode, int action,
                          int mods) {
-  Engine::getInstance().getApp()->keyCallback(window, key, scancode, action,
-                                              mods);
+  InputEvent event = {INPUT_KEY};
+  event.i[0] = key, event.i[1] = scancode, event.i[2] = action;
+  event.i[3] = mods;
+  Engine::getInstance().handleInput(window, event);
 }
 
 static void mouse_button_callback(GLFWwindow *window, int button, int action,
                                   int mods) {
-  Engine::getInstance().getApp()->mouseButtonCallback(window, button, action,
-                                                      mods);
+  InputEvent event = {INPUT_MOUSE_BUTTON};
+  event.i[0] = button, event.i[1] = action, event.i[2] = mods;
+  Engine::getInstance().handleInput(window, event);
 }
 
 static void scroll_callback(GLFWwindow *window, double xoffset,
                             double yoffset) {
-  Engine::getInstance().getApp()->scrollCallback(window, xoffset, yoffset);
+  InputEvent event = {INPUT_SCROLL};
+  event.d[0] = xoffset, event.d[1] = yoffset;
+  Engine::getInstance().handleInput(window, event);
+}
+
+static void joystick_callback(int jid, int event_type) {
+  InputEvent event = {INPUT_JOYSTICK};
+  event.i[0] = jid, event.i[1] = event_type;
+  Engine::getInstance().handleInput(nullptr, event);
 }
 
-static void joystick_callback(int jid, int event) {
-  Engine::getInstance().getApp()->joystickCallback(jid, event);
+/////////////////////////////////////////////////////////////////// TimingTotals
+
+void TimingTotals::add(double milliseconds) {
+  frames++;
+  total += milliseconds;
+  max = std::max(max, milliseconds);
 }
 
 ////////////////////////////////////////////////////////////////////////// SETUP
@@ -62,6 +114,27 @@ Engine::Engine(void) {
   GlMajor = 3, GlMinor = 3;
   Fullscreen = 0, Vsync = 0;
   WindowTitle = "OpenGL App GLFW Window 2023(c) Carlos Martinho";
+  Headless = false;
+  FrameLimit = 0;
+  OnDemand = false;
+  IdleInterval = 0.0;
+  Redraw = true;
+  RenderThreaded = Threaded = false;
+  Running = false;
+  FramesInFlight = 0;
+  std::fill(Fences, Fences + MAX_FRAMES_IN_FLIGHT, nullptr);
+  LateLatching = false;
+  Framebuffer = ColorBuffer = DepthBuffer = 0;
+  EglDisplay = EglContext = EglSurface = nullptr;
+  Recording = Replaying = false;
+  Capturing = false;
+  Frame = 0;
+  RunStart = 0.0;
+  CursorX = CursorY = 0.0;
+  Benchmarking = false;
+  CallCounting = false;
+  HudVisible = false;
+  Overlay = nullptr;
 }
 
 Engine::~Engine(void) {}
@@ -89,6 +162,84 @@ void Engine::setWindow(int width, int height, const char *title, int fullscreen,
   Vsync = vsync;
 }
 
+void Engine::setHeadless(bool headless) { Headless = headless; }
+
+void Engine::setFrameLimit(unsigned int frames) { FrameLimit = frames; }
+
+void Engine::setOnDemand(bool on_demand) { OnDemand = on_demand; }
+
+void Engine::setIdlePoll(std::function<bool()> poll, double seconds) {
+  IdlePoll = std::move(poll);
+  IdleInterval = seconds;
+}
+
+// Wakes up glfwWaitEvents() once per frame at most.
+void Engine::invalidate() {
+  if (!Redraw.exchange(true) && Window &&
+      (OnDemand || Pacer.isIdleEnabled())) {
+    glfwPostEmptyEvent();
+  }
+}
+
+void Engine::setRenderThread(bool threaded) { RenderThreaded = threaded; }
+
+void Engine::setFramesInFlight(int frames) {
+  FramesInFlight = std::min(std::max(frames, 0), MAX_FRAMES_IN_FLIGHT);
+}
+
+const TimingTotals &Engine::getGpuWait() { return GpuWait; }
+
+void Engine::setLateLatching(bool late_latching) {
+  LateLatching = late_latching;
+}
+
+InputQueue &Engine::getInputQueue() { return Latched; }
+
+void Engine::latchInput() {
+  if (!Window || Threaded || Recording || Replaying) return;
+  MGL_PROFILE_SCOPE("LatchInput");
+  glfwPollEvents();
+}
+
+const TimingTotals &Engine::getInputLatency() { return InputLatency; }
+
+bool Engine::isHeadless() { return Headless; }
+
+GLuint Engine::getFramebuffer() { return Framebuffer; }
+
+void Engine::setBenchmark(unsigned int warmup, unsigned int frames) {
+  Benchmarking = true;
+  FrameLimit = warmup + frames;
+  Stats.reset(warmup, frames);
+}
+
+FrameStats &Engine::getFrameStats() { return Stats; }
+
+FramePacer &Engine::getFramePacer() { return Pacer; }
+
+bool Engine::isReplaying() { return Replaying; }
+
+bool Engine::setGLCapture(const std::string &filename, unsigned int frames) {
+  Capturing = GLTraceRecorder::getInstance().open(filename, frames);
+  return Capturing;
+}
+
+void Engine::setCallCounting(bool counting) { CallCounting = counting; }
+
+void Engine::setHudVisible(bool visible) { HudVisible = visible; }
+
+bool Engine::isHudVisible() { return HudVisible; }
+
+bool Engine::setInputRecording(const std::string &filename) {
+  Recording = Recorder.open(filename);
+  return Recording;
+}
+
+bool Engine::setInputReplay(const std::string &filename) {
+  Replaying = Replayer.open(filename);
+  return Replaying;
+}
+
 /////////////////////////////////////////////////////////////////////////// INIT
 
 void Engine::setupWindow() {
@@ -99,7 +250,15 @@ void Engine::setupWindow() {
     exit(EXIT_FAILURE);
   }
   glfwMakeContextCurrent(Window);
-  glfwSwapInterval(Vsync);
+  int interval = Vsync;
+  if (interval < 0 && !glfwExtensionSupported("WGL_EXT_swap_control_tear") &&
+      !glfwExtensionSupported("GLX_EXT_swap_control_tear")) {
+#ifdef DEBUG
+    MGL_LOG_WARNING("Adaptive vsync unsupported, using vsync.");
+#endif
+    interval = 1;
+  }
+  glfwSwapInterval(interval);
 }
 
 void Engine::setupCallbacks() {
@@ -110,6 +269,7 @@ void Engine::setupCallbacks() {
   glfwSetJoystickCallback(joystick_callback);
   glfwSetWindowCloseCallback(Window, window_close_callback);
   glfwSetWindowSizeCallback(Window, window_size_callback);
+  glfwSetWindowRefreshCallback(Window, window_refresh_callback);
 }
 
 void Engine::setupGLFW() {
@@ -122,33 +282,183 @@ void Engine::setupGLFW() {
 #ifdef DEBUG
   glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, GLFW_TRUE);
 #endif
+  if (Headless) {
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+  }
   setupWindow();
   setupCallbacks();
 }
 
+////////////////////////////////////////////////////////////////////// HEADLESS
+
+// Creates an OpenGL context without any window system, either surfaceless or
+// on a 1x1 pbuffer; Mesa's llvmpipe provides both on machines without a GPU.
+bool Engine::setupEGL() {
+#ifdef __linux__
+  EGLDisplay display = EGL_NO_DISPLAY;
+  auto getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+      eglGetProcAddress("eglGetPlatformDisplayEXT"));
+  if (getPlatformDisplay) {
+    display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA,
+                                 EGL_DEFAULT_DISPLAY, nullptr);
+  }
+  if (display == EGL_NO_DISPLAY) {
+    display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+  }
+  if (display == EGL_NO_DISPLAY || !eglInitialize(display, nullptr, nullptr)) {
+    return false;
+  }
+
+  // The framebuffer object owns colour and depth, so any OpenGL config will
+  // do; one with pbuffer support is preferred in case surfaceless fails.
+  EGLint config_attribs[] = {EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+                             EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE};
+  EGLConfig config;
+  EGLint n_configs = 0;
+  if (eglBindAPI(EGL_OPENGL_API)) {
+    eglChooseConfig(display, config_attribs, &config, 1, &n_configs);
+    if (n_configs == 0) {
+      config_attribs[1] = 0;
+      eglChooseConfig(display, config_attribs, &config, 1, &n_configs);
+    }
+  }
+  if (n_configs == 0) {
+    eglTerminate(display);
+    return false;
+  }
+
+  const EGLint context_attribs[] = {
+      EGL_CONTEXT_MAJOR_VERSION, GlMajor,
+      EGL_CONTEXT_MINOR_VERSION, GlMinor,
+      EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+#ifdef DEBUG
+      EGL_CONTEXT_OPENGL_DEBUG, EGL_TRUE,
+#endif
+      EGL_NONE};
+  EGLContext context =
+      eglCreateContext(display, config, EGL_NO_CONTEXT, context_attribs);
+  if (context == EGL_NO_CONTEXT) {
+    eglTerminate(display);
+    return false;
+  }
+
+  EGLSurface surface = EGL_NO_SURFACE;
+  if (!eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context)) {
+    const EGLint pbuffer_attribs[] = {EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE};
+    surface = eglCreatePbufferSurface(display, config, pbuffer_attribs);
+    if (surface == EGL_NO_SURFACE ||
+        !eglMakeCurrent(display, surface, surface, context)) {
+      eglDestroyContext(display, context);
+      eglTerminate(display);
+      return false;
+    }
+  }
+  EglDisplay = display;
+  EglContext = context;
+  EglSurface = surface;
+  return true;
+#else
+  return false;
+#endif
+}
+
+// EGL is preferred as it needs no display server at all; elsewhere, or when
+// EGL fails, a hidden GLFW window provides the context.
+void Engine::setupHeadless() {
+  if (setupEGL()) return;
+#ifdef DEBUG
+  MGL_LOG_WARNING("EGL unavailable, using a hidden window.");
+#endif
+  setupGLFW();
+}
+
+void Engine::setupFramebuffer() {
+  glGenRenderbuffers(1, &ColorBuffer);
+  glBindRenderbuffer(GL_RENDERBUFFER, ColorBuffer);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, WindowWidth, WindowHeight);
+  glGenRenderbuffers(1, &DepthBuffer);
+  glBindRenderbuffer(GL_RENDERBUFFER, DepthBuffer);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, WindowWidth,
+                        WindowHeight);
+  glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+  glGenFramebuffers(1, &Framebuffer);
+  glBindFramebuffer(GL_FRAMEBUFFER, Framebuffer);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                            GL_RENDERBUFFER, ColorBuffer);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT,
+                            GL_RENDERBUFFER, DepthBuffer);
+  if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+    MGL_LOG_ERROR("Offscreen framebuffer is incomplete.");
+    exit(EXIT_FAILURE);
+  }
+}
+
+void Engine::destroyContext() {
+  delete Overlay;
+  Overlay = nullptr;
+  DeletionQueue::getInstance().flush();
+#if MGL_GL_CHECKS
+  releaseDebugOutput();
+  reportDebugOutput(std::cerr);
+#endif
+  if (Framebuffer) {
+    glDeleteFramebuffers(1, &Framebuffer);
+    glDeleteRenderbuffers(1, &ColorBuffer);
+    glDeleteRenderbuffers(1, &DepthBuffer);
+    Framebuffer = ColorBuffer = DepthBuffer = 0;
+  }
+#ifdef __linux__
+  if (EglDisplay) {
+    eglMakeCurrent(EglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (EglSurface) eglDestroySurface(EglDisplay, EglSurface);
+    eglDestroyContext(EglDisplay, EglContext);
+    eglTerminate(EglDisplay);
+    EglDisplay = EglContext = EglSurface = nullptr;
+    return;
+  }
+#endif
+  glfwDestroyWindow(Window);
+  glfwTerminate();
+}
+
+/////////////////////////////////////////////////////////////////////////// GLEW
+
 void Engine::setupGLEW() {
   glewExperimental = GL_TRUE;
   // Allow extension entry points to be loaded even if the extension isn't
   // present in the driver's extensions string.
   GLenum result = glewInit();
+#ifdef GLEW_ERROR_NO_GLX_DISPLAY
+  // A GLX build of GLEW loads the core entry points first and only then fails
+  // looking for an X display, which an EGL context does not have.
+  if (EglDisplay && result == GLEW_ERROR_NO_GLX_DISPLAY) {
+    result = GLEW_OK;
+  }
+#endif
   if (result != GLEW_OK) {
-    std::cerr << "ERROR glewInit: " << glewGetString(result) << std::endl;
+    MGL_LOG_ERROR("glewInit: " << glewGetString(result));
     exit(EXIT_FAILURE);
   }
   glGetError();
+  if (CallCounting) {
+    GLCounters::getInstance().install();
+  }
+  if (Capturing) {
+    GLTraceRecorder::getInstance().install(WindowWidth, WindowHeight);
+  }
   // GLenum err_code = glGetError(); // Full syntax to check
   // You might get GL_INVALID_ENUM when loading GLEW.
 }
 
 void displayInfo() {
-  std::cerr << "OpenGL Renderer: " << glGetString(GL_RENDERER) << " ("
-            << glGetString(GL_VENDOR) << ")" << std::endl;
-  std::cerr << "OpenGL version " << glGetString(GL_VERSION) << std::endl;
-  std::cerr << "GLSL version " << glGetString(GL_SHADING_LANGUAGE_VERSION)
-            << std::endl;
-  std::cout << "GLEW version " << glewGetString(GLEW_VERSION) << std::endl;
-  std::cout << "GLFW version " << glfwGetVersionString() << std::endl;
-  std::cout << GLM_VERSION_MESSAGE << std::endl;
+  MGL_LOG_INFO("OpenGL Renderer: " << glGetString(GL_RENDERER) << " ("
+               << glGetString(GL_VENDOR) << ")");
+  MGL_LOG_INFO("OpenGL version " << glGetString(GL_VERSION));
+  MGL_LOG_INFO("GLSL version " << glGetString(GL_SHADING_LANGUAGE_VERSION));
+  MGL_LOG_INFO("GLEW version " << glewGetString(GLEW_VERSION));
+  MGL_LOG_INFO("GLFW version " << glfwGetVersionString());
+  MGL_LOG_INFO(GLM_VERSION_MESSAGE);
 }
 
 void Engine::setupOpenGL() {
@@ -161,35 +471,490 @@ void Engine::setupOpenGL() {
   glEnable(GL_CULL_FACE);
   glCullFace(GL_BACK);
   glFrontFace(GL_CCW);
+  if (Headless) {
+    setupFramebuffer();
+  }
   glViewport(0, 0, WindowWidth, WindowHeight);
 }
 
 void Engine::init() {
-  setupGLFW();
+  const StartupClock::time_point start = StartupClock::now();
+  MGL_PROFILE_THREAD("Main");
+  Allocations::getInstance().setThreadName("Main");
+  std::future<void> preload = std::async(std::launch::async, [this] {
+    MGL_PROFILE_THREAD("Preload");
+    Allocations::getInstance().setThreadName("Preload");
+    MGL_PROFILE_SCOPE("preloadCallback");
+    const StartupClock::time_point t = StartupClock::now();
+    GlApp->preloadCallback();
+    Startup.preload = millisecondsSince(t);
+  });
+
+  StartupClock::time_point t = StartupClock::now();
+  if (Headless) {
+    setupHeadless();
+  } else {
+    setupGLFW();
+  }
+  Startup.setupGLFW = millisecondsSince(t);
+  t = StartupClock::now();
   setupGLEW();
+  Startup.setupGLEW = millisecondsSince(t);
+  t = StartupClock::now();
   setupOpenGL();
+  Startup.setupOpenGL = millisecondsSince(t);
+
+  t = StartupClock::now();
+  preload.get();
+  Startup.preloadWait = millisecondsSince(t);
+
+  t = StartupClock::now();
   GlApp->initCallback(Window);
+  Startup.initCallback = millisecondsSince(t);
+  Startup.init = millisecondsSince(start);
 #ifdef DEBUG
   displayInfo();
+#endif
+#if MGL_GL_CHECKS
   setupDebugOutput();
 #endif
 }
 
+const StartupTimings &Engine::getStartupTimings() { return Startup; }
+
+void Engine::setStartupReport(const std::string &filename) {
+  StartupReport = filename;
+}
+
+void Engine::reportStartup() {
+#ifdef DEBUG
+  std::cout << "Startup [ms]: preload " << Startup.preload << " | glfw "
+            << Startup.setupGLFW << ", glew " << Startup.setupGLEW
+            << ", opengl " << Startup.setupOpenGL << ", preload wait "
+            << Startup.preloadWait << ", init " << Startup.initCallback
+            << ", first frame " << Startup.firstFrame << std::endl;
+  std::cout << "Time to first frame: " << Startup.timeToFirstFrame << " ms"
+            << std::endl;
+#endif
+  if (StartupReport.empty()) return;
+  std::ofstream ofile(StartupReport);
+  ofile << "{\n"
+        << "  \"preload_ms\": " << Startup.preload << ",\n"
+        << "  \"setup_glfw_ms\": " << Startup.setupGLFW << ",\n"
+        << "  \"setup_glew_ms\": " << Startup.setupGLEW << ",\n"
+        << "  \"setup_opengl_ms\": " << Startup.setupOpenGL << ",\n"
+        << "  \"preload_wait_ms\": " << Startup.preloadWait << ",\n"
+        << "  \"init_callback_ms\": " << Startup.initCallback << ",\n"
+        << "  \"init_ms\": " << Startup.init << ",\n"
+        << "  \"first_frame_ms\": " << Startup.firstFrame << ",\n"
+        << "  \"time_to_first_frame_ms\": " << Startup.timeToFirstFrame
+        << "\n}\n";
+  if (!ofile) {
+    MGL_LOG_WARNING("Cannot write " << StartupReport);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////// INPUT
+
+void Engine::handleInput(GLFWwindow *window, InputEvent event) {
+  if (Replaying && event.type != INPUT_WINDOW_CLOSE) return;
+  event.frame = Frame;
+  event.time = getTime() - RunStart;
+  if (Recording) Recorder.record(event);
+  dispatchInput(event);
+  invalidate();
+}
+
+void Engine::getCursorPos(double *xpos, double *ypos) {
+  *xpos = CursorX;
+  *ypos = CursorY;
+}
+
+void Engine::dispatchInput(const InputEvent &event) {
+  const int32_t *i = event.i;
+  const double *d = event.d;
+  if (LateLatching) {
+    InputEvent queued = event;
+    queued.time = getTime() - RunStart;  // replayed events carry their own
+    Latched.push(queued);
+  }
+  switch (event.type) {
+    case INPUT_WINDOW_CLOSE:
+      GlApp->windowCloseCallback(Window);
+      break;
+    case INPUT_WINDOW_SIZE:
+      GlApp->windowSizeCallback(Window, i[0], i[1]);
+      break;
+    case INPUT_CURSOR:
+      CursorX = d[0], CursorY = d[1];
+      GlApp->cursorCallback(Window, d[0], d[1]);
+      break;
+    case INPUT_KEY:
+      GlApp->keyCallback(Window, i[0], i[1], i[2], i[3]);
+      break;
+    case INPUT_MOUSE_BUTTON:
+      GlApp->mouseButtonCallback(Window, i[0], i[1], i[2]);
+      break;
+    case INPUT_SCROLL:
+      GlApp->scrollCallback(Window, d[0], d[1]);
+      break;
+    case INPUT_JOYSTICK:
+      GlApp->joystickCallback(i[0], i[1]);
+      break;
+    default:
+      break;
+  }
+}
+
 //////////////////////////////////////////////////////////////////////////// RUN
 
+// GL_TIME_ELAPSED results are read GPU_TIMERS frames later, by which time the
+// GPU has long finished, so the read does not stall.
+void Engine::collectGpuTimer(int timer) {
+  if (!GpuTimerPending[timer]) return;
+  GLuint64 elapsed = 0;
+  glGetQueryObjectui64v(GpuTimers[timer], GL_QUERY_RESULT, &elapsed);
+  Stats.addGpu(GpuTimerFrame[timer], elapsed / 1e6);
+  GpuTimerPending[timer] = false;
+}
+
+static double millisecondsBetween(StartupClock::time_point start,
+                                  StartupClock::time_point end) {
+  return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+bool Engine::shouldClose() {
+  return Window ? glfwWindowShouldClose(Window) : false;
+}
+
+bool Engine::shouldWait() {
+  return OnDemand && Window && !Headless && !Replaying && !Benchmarking &&
+         !HudVisible && !Redraw && !shouldClose();
+}
+
+// Until something invalidates the frame; the idle poll wakes up the wait but
+// only ends it when it found a change.
+void Engine::waitForRedraw() {
+  while (shouldWait()) {
+    if (!IdlePoll) {
+      glfwWaitEvents();
+      continue;
+    }
+    glfwWaitEventsTimeout(IdleInterval);
+    if (IdlePoll()) Redraw = true;
+  }
+}
+
+// Nothing invalidated the last frame, so the idle rate applies; a window
+// waits for events rather than sleeping, so that input ends the idle frame.
+void Engine::pace() {
+  MGL_PROFILE_SCOPE("Pace");
+  const bool idle = Pacer.isIdleEnabled() && !Redraw;
+  if (idle && Window && !Threaded) {
+    double remaining;
+    while (!Redraw && (remaining = Pacer.getRemaining(true)) > 0.0) {
+      glfwWaitEventsTimeout(remaining);
+    }
+  }
+  Pacer.wait(idle && !Redraw);
+}
+
+// GLFW's timer needs glfwInit(), which an EGL context never calls.
+double Engine::getTime() {
+  if (Window) return glfwGetTime();
+  return std::chrono::duration<double>(StartupClock::now() - PROCESS_START)
+      .count();
+}
+
+void Engine::drawHud(double elapsed) {
+  MGL_PROFILE_SCOPE("Hud");
+  MGL_CHECK_SCOPE("Hud");
+  const GLCallCounts counted = GLCounters::getInstance().getCurrent();
+  GLTraceRecorder::getInstance().setPaused(true);
+  if (!Overlay) Overlay = new Hud();
+  Overlay->addFrame(elapsed * 1000.0);
+  Overlay->draw();
+  GLTraceRecorder::getInstance().setPaused(false);
+  GLCounters::getInstance().rewind(counted);
+}
+
+void Engine::endFrame() {
+  DeletionQueue::getInstance().endFrame();
+  if (CallCounting) {
+    GLCounters::getInstance().endFrame();
+  }
+  if (Capturing) {
+    GLTraceRecorder::getInstance().endFrame();
+  }
+  if (Allocations::isTracking()) {
+    Allocations::getInstance().endFrame();
+  }
+}
+
+// Fences the frame just swapped, then waits for the one from FramesInFlight
+// frames ago, the slot of which is reused next; with a single frame in flight
+// these are the same. Runs before the events are handled, so that the input
+// of the next frame is read as late as possible.
+void Engine::limitFramesInFlight() {
+  if (!FramesInFlight) return;
+  MGL_PROFILE_SCOPE("WaitGpu");
+  Fences[Frame % FramesInFlight] =
+      glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  GLsync &oldest = Fences[(Frame + 1) % FramesInFlight];
+  if (!oldest) return;
+  const StartupClock::time_point start = StartupClock::now();
+  GLenum result = glClientWaitSync(oldest, 0, 0);
+  if (result == GL_TIMEOUT_EXPIRED) {
+    do {
+      result = glClientWaitSync(oldest, GL_SYNC_FLUSH_COMMANDS_BIT,
+                                1000000000);  // 1 s, in ns
+    } while (result == GL_TIMEOUT_EXPIRED);
+    GpuWait.add(millisecondsSince(start));
+  }
+  glDeleteSync(oldest);
+  oldest = nullptr;
+}
+
+// On the thread consuming the queue, once the frame is swapped and, with a
+// limit on frames in flight, as good as presented.
+void Engine::measureInputLatency() {
+  if (!LateLatching) return;
+  const double oldest = Latched.takeOldest();
+  if (oldest < 0.0) return;
+  const double latency = (getTime() - RunStart - oldest) * 1000.0;
+  InputLatency.add(latency);
+  if (Benchmarking) Stats.addInputLatency(Frame, latency);
+}
+
+void Engine::releaseFences() {
+  for (GLsync &fence : Fences) {
+    if (fence) glDeleteSync(fence);
+    fence = nullptr;
+  }
+}
+
+// While replaying, the recorded input of each frame is dispatched before it
+// is drawn, and the recorded elapsed time replaces the real one.
 void Engine::run() {
-  double last_time = glfwGetTime();
-  while (!glfwWindowShouldClose(Window)) {
-    double time = glfwGetTime();
+  Threaded = RenderThreaded && Window && !Headless && !Recording &&
+             !Replaying && !Benchmarking;
+  if (Threaded) {
+    runRenderThread();
+    return;
+  }
+  RunStart = getTime();
+  FrameArena &arena = FrameArena::getLocal();
+  arena.setName("Main");
+  double last_time = 0.0;
+  bool first_frame = true;
+  const uint32_t replay_frames = Replaying ? Replayer.getFrameCount() : 0;
+  if (Benchmarking) {
+    glGenQueries(GPU_TIMERS, GpuTimers);
+    std::fill(GpuTimerPending, GpuTimerPending + GPU_TIMERS, false);
+  }
+  if (Window) {
+    // GLFW only reports the cursor once it moves, so its starting position is
+    // passed on (and recorded) as if it had.
+    double xpos, ypos;
+    glfwGetCursorPos(Window, &xpos, &ypos);
+    cursor_pos_callback(Window, xpos, ypos);
+  }
+  while (!shouldClose()) {
+    MGL_PROFILE_FRAME();
+    MGL_PROFILE_SCOPE("Frame");
+    arena.reset();
+    MGL_CHECK_FRAME(Frame);
+    MGL_CHECK_SCOPE("Frame");
+    if (Capturing) {
+      GLTraceRecorder::getInstance().beginFrame();
+    }
+    StartupClock::time_point frame_start = StartupClock::now();
+    double time = getTime() - RunStart;
     double elapsed_time = time - last_time;
     last_time = time;
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
-    GlApp->displayCallback(Window, elapsed_time);
-    glfwSwapBuffers(Window);
-    glfwPollEvents();
+    if (Replaying) {
+      if (Frame >= replay_frames) break;
+      InputEvent event;
+      while (Replayer.next(Frame, event)) {
+        if (event.type == INPUT_FRAME) {
+          time = event.time;
+          elapsed_time = event.d[0];
+        } else {
+          dispatchInput(event);
+        }
+      }
+    }
+    if (Recording) {
+      Recorder.record({INPUT_FRAME, Frame, time, {}, {elapsed_time, 0.0}});
+    }
+    Redraw = false;
+    const int timer = Frame % GPU_TIMERS;
+    const StartupClock::time_point display_start = StartupClock::now();
+    {
+      MGL_PROFILE_SCOPE("updateCallback");
+      GlApp->updateCallback(Window, elapsed_time);
+    }
+    {
+      MGL_PROFILE_SCOPE("displayCallback");
+      MGL_PROFILE_GPU_SCOPE("displayCallback");
+      MGL_CHECK_SCOPE("displayCallback");
+      if (Benchmarking) {
+        collectGpuTimer(timer);
+        glBeginQuery(GL_TIME_ELAPSED, GpuTimers[timer]);
+      }
+      glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT |
+              GL_STENCIL_BUFFER_BIT);
+      GlApp->displayCallback(Window, elapsed_time);
+      if (Benchmarking) {
+        glEndQuery(GL_TIME_ELAPSED);
+        GpuTimerFrame[timer] = Frame;
+        GpuTimerPending[timer] = true;
+      }
+    }
+    if (HudVisible) drawHud(elapsed_time);
+    const StartupClock::time_point swap_start = StartupClock::now();
+    {
+      MGL_PROFILE_SCOPE("SwapBuffers");
+      if (Headless) {
+        glFlush();
+      } else {
+        glfwSwapBuffers(Window);
+      }
+    }
+    endFrame();
+    const StartupClock::time_point wait_start = StartupClock::now();
+    limitFramesInFlight();
+    measureInputLatency();
+    const StartupClock::time_point events_start = StartupClock::now();
+    if (first_frame) {
+      first_frame = false;
+      Startup.firstFrame = millisecondsSince(frame_start);
+      Startup.timeToFirstFrame = millisecondsSince(PROCESS_START);
+      reportStartup();
+    }
+    if (Window) {
+      MGL_PROFILE_SCOPE("PollEvents");
+      glfwPollEvents();
+      waitForRedraw();
+    }
+    if (Benchmarking) {
+      const StartupClock::time_point frame_end = StartupClock::now();
+      const double phases[FRAME_PHASES] = {
+          millisecondsBetween(frame_start, display_start) +
+              millisecondsBetween(events_start, frame_end),
+          millisecondsBetween(display_start, swap_start),
+          millisecondsBetween(swap_start, wait_start),
+          millisecondsBetween(wait_start, events_start)};
+      Stats.addCpu(Frame, millisecondsBetween(frame_start, frame_end), phases);
+    }
+    pace();
+    if (++Frame == FrameLimit) break;
   }
-  glfwDestroyWindow(Window);
-  glfwTerminate();
+  if (Benchmarking) {
+    for (int i = 0; i < GPU_TIMERS; i++) collectGpuTimer(i);
+    glDeleteQueries(GPU_TIMERS, GpuTimers);
+  }
+  releaseFences();
+  MGL_PROFILE_FLUSH();
+  Recorder.close();
+  GLTraceRecorder::getInstance().close();
+  destroyContext();
+}
+
+////////////////////////////////////////////////////////////////// RENDER THREAD
+
+// The main thread updates the next frame while the render thread draws the
+// current one, then handles input until the render thread starts another.
+// GLFW requires events to be processed on the main thread, so it is the one
+// giving up the context.
+void Engine::runRenderThread() {
+  RunStart = getTime();
+  double xpos, ypos;
+  glfwGetCursorPos(Window, &xpos, &ypos);
+  cursor_pos_callback(Window, xpos, ypos);
+  GlApp->updateCallback(Window, 0.0);  // so that the first frame has one
+
+  glfwMakeContextCurrent(nullptr);
+  Running = true;
+  std::thread render(&Engine::renderLoop, this);
+  FrameArena &arena = FrameArena::getLocal();
+  arena.setName("Main");
+  double last_time = 0.0;
+  while (Running) {
+    arena.reset();
+    const uint32_t frame = Frame;
+    {
+      MGL_PROFILE_SCOPE("WaitEvents");
+      glfwPollEvents();
+      while (Running && Frame == frame && !glfwWindowShouldClose(Window)) {
+        glfwWaitEvents();
+      }
+    }
+    if (!Running || glfwWindowShouldClose(Window)) break;
+    const double time = getTime() - RunStart;
+    MGL_PROFILE_SCOPE("updateCallback");
+    GlApp->updateCallback(Window, time - last_time);
+    last_time = time;
+  }
+  Running = false;
+  render.join();
+  glfwMakeContextCurrent(Window);
+
+  MGL_PROFILE_FLUSH();
+  GLTraceRecorder::getInstance().close();
+  destroyContext();
+}
+
+void Engine::renderLoop() {
+  MGL_PROFILE_THREAD("Render");
+  Allocations::getInstance().setThreadName("Render");
+  glfwMakeContextCurrent(Window);
+  FrameArena &arena = FrameArena::getLocal();
+  arena.setName("Render");
+  double last_time = 0.0;
+  bool first_frame = true;
+  while (Running) {
+    MGL_PROFILE_FRAME();
+    MGL_PROFILE_SCOPE("Frame");
+    arena.reset();
+    MGL_CHECK_FRAME(Frame);
+    MGL_CHECK_SCOPE("Frame");
+    if (Capturing) {
+      GLTraceRecorder::getInstance().beginFrame();
+    }
+    const StartupClock::time_point frame_start = StartupClock::now();
+    const double time = getTime() - RunStart;
+    const double elapsed_time = time - last_time;
+    last_time = time;
+    Redraw = false;
+    {
+      MGL_PROFILE_SCOPE("displayCallback");
+      MGL_PROFILE_GPU_SCOPE("displayCallback");
+      MGL_CHECK_SCOPE("displayCallback");
+      glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT |
+              GL_STENCIL_BUFFER_BIT);
+      GlApp->displayCallback(Window, elapsed_time);
+    }
+    if (HudVisible) drawHud(elapsed_time);
+    {
+      MGL_PROFILE_SCOPE("SwapBuffers");
+      glfwSwapBuffers(Window);
+    }
+    endFrame();
+    limitFramesInFlight();
+    measureInputLatency();
+    if (first_frame) {
+      first_frame = false;
+      Startup.firstFrame = millisecondsSince(frame_start);
+      Startup.timeToFirstFrame = millisecondsSince(PROCESS_START);
+      reportStartup();
+    }
+    pace();
+    if (++Frame == FrameLimit) Running = false;
+    glfwPostEmptyEvent();  // the main thread may update the next frame
+  }
+  releaseFences();
+  glfwMakeContextCurrent(nullptr);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
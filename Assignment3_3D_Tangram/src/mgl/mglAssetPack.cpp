@@ -0,0 +1,411 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Asset Pack
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "./mglAssetPack.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "./mglLog.hpp"
+
+namespace mgl {
+
+////////////////////////////////////////////////////////////////////////// NAMES
+
+std::string normalizeAssetName(const std::string &name) {
+  std::string result = name;
+  std::replace(result.begin(), result.end(), '\\', '/');
+  while (result.compare(0, 2, "./") == 0) result.erase(0, 2);
+  return result;
+}
+
+/////////////////////////////////////////////////////////// LZ4 (BLOCK FORMAT)
+
+static const std::size_t LZ4_MIN_MATCH = 4;
+static const std::size_t LZ4_LAST_LITERALS = 5;
+static const std::size_t LZ4_MF_LIMIT = 12;
+static const int LZ4_HASH_BITS = 16;
+static const uint64_t LZ4_MAX_RATIO = 255;  // a length byte adds at most 255
+
+static uint32_t read32(const uint8_t *p) {
+  uint32_t v;
+  std::memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+static void writeLength(std::vector<uint8_t> &out, std::size_t length) {
+  while (length >= 255) {
+    out.push_back(255);
+    length -= 255;
+  }
+  out.push_back(static_cast<uint8_t>(length));
+}
+
+static void writeSequence(std::vector<uint8_t> &out, const uint8_t *literals,
+                          std::size_t n_literals, std::size_t offset,
+                          std::size_t match_length) {
+  const std::size_t m = match_length ? match_length - LZ4_MIN_MATCH : 0;
+  uint8_t token = static_cast<uint8_t>(std::min<std::size_t>(n_literals, 15)
+                                       << 4);
+  if (match_length) token |= static_cast<uint8_t>(std::min<std::size_t>(m, 15));
+  out.push_back(token);
+  if (n_literals >= 15) writeLength(out, n_literals - 15);
+  out.insert(out.end(), literals, literals + n_literals);
+  if (match_length) {
+    out.push_back(static_cast<uint8_t>(offset & 0xff));
+    out.push_back(static_cast<uint8_t>(offset >> 8));
+    if (m >= 15) writeLength(out, m - 15);
+  }
+}
+
+// Greedy single-probe compressor; it favours simplicity over ratio.
+std::vector<uint8_t> lz4Compress(const uint8_t *src, std::size_t size) {
+  std::vector<uint8_t> out;
+  out.reserve(size + size / 255 + 16);
+  std::vector<int64_t> table(std::size_t(1) << LZ4_HASH_BITS, -1);
+
+  std::size_t anchor = 0, i = 0;
+  if (size > LZ4_MF_LIMIT) {
+    const std::size_t limit = size - LZ4_MF_LIMIT;
+    const std::size_t match_limit = size - LZ4_LAST_LITERALS;
+    while (i < limit) {
+      const uint32_t sequence = read32(src + i);
+      const uint32_t h = (sequence * 2654435761u) >> (32 - LZ4_HASH_BITS);
+      const int64_t ref = table[h];
+      table[h] = static_cast<int64_t>(i);
+      if (ref >= 0 && i - ref <= 0xffff &&
+          read32(src + ref) == sequence) {
+        std::size_t length = LZ4_MIN_MATCH;
+        while (i + length < match_limit && src[ref + length] == src[i + length])
+          length++;
+        writeSequence(out, src + anchor, i - anchor, i - ref, length);
+        i += length;
+        anchor = i;
+      } else {
+        i++;
+      }
+    }
+  }
+  writeSequence(out, src + anchor, size - anchor, 0, 0);
+  return out;
+}
+
+static bool readLength(const uint8_t *&ip, const uint8_t *iend,
+                       std::size_t &length) {
+  uint8_t b;
+  do {
+    if (ip >= iend) return false;
+    b = *ip++;
+    length += b;
+  } while (b == 255);
+  return true;
+}
+
+bool lz4Decompress(const uint8_t *src, std::size_t size, uint8_t *dst,
+                   std::size_t raw_size) {
+  const uint8_t *ip = src, *iend = src + size;
+  uint8_t *op = dst, *oend = dst + raw_size;
+  while (ip < iend) {
+    const uint8_t token = *ip++;
+    std::size_t n_literals = token >> 4;
+    if (n_literals == 15 && !readLength(ip, iend, n_literals)) return false;
+    if (n_literals > std::size_t(iend - ip) ||
+        n_literals > std::size_t(oend - op))
+      return false;
+    std::memcpy(op, ip, n_literals);
+    op += n_literals;
+    ip += n_literals;
+    if (ip >= iend) break;  // the last sequence has no match
+
+    if (iend - ip < 2) return false;
+    const std::size_t offset = ip[0] | (ip[1] << 8);
+    ip += 2;
+    if (offset == 0 || offset > std::size_t(op - dst)) return false;
+    std::size_t length = token & 15;
+    if (length == 15 && !readLength(ip, iend, length)) return false;
+    length += LZ4_MIN_MATCH;
+    if (length > std::size_t(oend - op)) return false;
+    const uint8_t *match = op - offset;
+    for (std::size_t k = 0; k < length; k++) op[k] = match[k];  // may overlap
+    op += length;
+  }
+  return op == oend;
+}
+
+////////////////////////////////////////////////////////////////////// AssetPack
+
+AssetPack::AssetPack()
+    : Data(nullptr), Size(0), Entries(nullptr), Count(0) {
+#ifdef _WIN32
+  FileHandle = INVALID_HANDLE_VALUE;
+  MappingHandle = nullptr;
+#endif
+}
+
+AssetPack::~AssetPack() { close(); }
+
+bool AssetPack::open(const std::string &filename) {
+  close();
+#ifdef _WIN32
+  FileHandle = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                           nullptr, OPEN_EXISTING,
+                           FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+  if (FileHandle == INVALID_HANDLE_VALUE) {
+    MGL_LOG_ERROR("Cannot open asset pack " << filename);
+    return false;
+  }
+  LARGE_INTEGER size;
+  GetFileSizeEx(FileHandle, &size);
+  Size = static_cast<std::size_t>(size.QuadPart);
+  MappingHandle =
+      CreateFileMappingA(FileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (MappingHandle) {
+    Data = static_cast<const uint8_t *>(
+        MapViewOfFile(MappingHandle, FILE_MAP_READ, 0, 0, 0));
+  }
+#else
+  int fd = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    MGL_LOG_ERROR("Cannot open asset pack " << filename);
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd, &st) == 0 && st.st_size > 0) {
+    Size = static_cast<std::size_t>(st.st_size);
+    void *data = mmap(nullptr, Size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data != MAP_FAILED) {
+      madvise(data, Size, MADV_WILLNEED);
+      Data = static_cast<const uint8_t *>(data);
+    }
+  }
+  ::close(fd);  // the mapping stays valid
+#endif
+  if (!Data) {
+    MGL_LOG_ERROR("Cannot map asset pack " << filename);
+    close();
+    return false;
+  }
+
+  if (!validate()) {
+    MGL_LOG_ERROR("Invalid asset pack " << filename);
+    close();
+    return false;
+  }
+
+#ifdef DEBUG
+  std::cout << "Mapped asset pack [" << filename << "] with " << Count
+            << " entries" << std::endl;
+#endif
+  return true;
+}
+
+void AssetPack::close() {
+  Decompressed.clear();
+#ifdef _WIN32
+  if (Data) UnmapViewOfFile(Data);
+  if (MappingHandle) CloseHandle(MappingHandle);
+  if (FileHandle != INVALID_HANDLE_VALUE) CloseHandle(FileHandle);
+  MappingHandle = nullptr;
+  FileHandle = INVALID_HANDLE_VALUE;
+#else
+  if (Data) munmap(const_cast<uint8_t *>(Data), Size);
+#endif
+  Data = nullptr;
+  Size = 0;
+  Entries = nullptr;
+  Count = 0;
+}
+
+bool AssetPack::isOpen() { return Data != nullptr; }
+
+bool AssetPack::isInside(uint64_t offset, uint64_t length) {
+  return offset <= Size && length <= Size - offset;
+}
+
+// Checks every range the TOC points to once, so that lookups can trust it.
+// Compressed sizes are capped by the best ratio LZ4 can reach, so that a
+// corrupt entry cannot ask for an arbitrarily large buffer.
+bool AssetPack::validate() {
+  if (Size < sizeof(PackHeader)) return false;
+  const PackHeader *header = reinterpret_cast<const PackHeader *>(Data);
+  if (std::memcmp(header->magic, PACK_MAGIC, sizeof(PACK_MAGIC)) != 0 ||
+      header->version != PACK_VERSION ||
+      header->tocOffset % alignof(PackEntry) != 0 ||
+      header->tocOffset > Size ||
+      header->count > (Size - header->tocOffset) / sizeof(PackEntry)) {
+    return false;
+  }
+  const PackEntry *entries =
+      reinterpret_cast<const PackEntry *>(Data + header->tocOffset);
+  for (uint32_t i = 0; i < header->count; i++) {
+    const PackEntry &entry = entries[i];
+    if (!isInside(entry.nameOffset, entry.nameLength) ||
+        !isInside(entry.offset, entry.size)) {
+      return false;
+    }
+    if (entry.flags & PACK_LZ4) {
+      if (entry.rawSize > entry.size * LZ4_MAX_RATIO) return false;
+    } else if (entry.rawSize != entry.size) {
+      return false;
+    }
+  }
+  Entries = entries;
+  Count = header->count;
+  return true;
+}
+
+const PackEntry *AssetPack::find(const std::string &name) {
+  const std::string normalized = normalizeAssetName(name);
+  const uint64_t hash = hashAssetName(normalized.c_str());
+  const PackEntry *end = Entries + Count;
+  const PackEntry *entry = std::lower_bound(
+      Entries, end, hash,
+      [](const PackEntry &e, uint64_t h) { return e.hash < h; });
+  for (; entry != end && entry->hash == hash; ++entry) {
+    const char *entry_name =
+        reinterpret_cast<const char *>(Data) + entry->nameOffset;
+    if (normalized.compare(0, std::string::npos, entry_name,
+                           entry->nameLength) == 0)
+      return entry;
+  }
+  return nullptr;
+}
+
+bool AssetPack::contains(const std::string &name) {
+  return isOpen() && find(name) != nullptr;
+}
+
+AssetPack::Asset AssetPack::get(const std::string &name) {
+  Asset asset;
+  if (!isOpen()) return asset;
+  const PackEntry *entry = find(name);
+  if (!entry) return asset;
+
+  if (!(entry->flags & PACK_LZ4)) {
+    asset.data = reinterpret_cast<const char *>(Data + entry->offset);
+    asset.size = static_cast<std::size_t>(entry->size);
+    return asset;
+  }
+
+  const uint64_t index = static_cast<uint64_t>(entry - Entries);
+  std::unique_ptr<uint8_t[]> &buffer = Decompressed[index];
+  if (!buffer) {
+    buffer.reset(new uint8_t[entry->rawSize + 1]);
+    if (!lz4Decompress(Data + entry->offset, entry->size, buffer.get(),
+                       entry->rawSize)) {
+      MGL_LOG_ERROR("Corrupt asset " << name);
+      Decompressed.erase(index);
+      return asset;
+    }
+    buffer[entry->rawSize] = 0;
+  }
+  asset.data = reinterpret_cast<const char *>(buffer.get());
+  asset.size = static_cast<std::size_t>(entry->rawSize);
+  return asset;
+}
+
+std::vector<std::string> AssetPack::list() {
+  std::vector<std::string> names;
+  for (uint32_t i = 0; i < Count; i++) {
+    names.emplace_back(reinterpret_cast<const char *>(Data) +
+                           Entries[i].nameOffset,
+                       Entries[i].nameLength);
+  }
+  return names;
+}
+
+//////////////////////////////////////////////////////////////// AssetPackWriter
+
+void AssetPackWriter::add(const std::string &name,
+                          const std::vector<uint8_t> &data, bool compress) {
+  Item item{normalizeAssetName(name), data, data.size(), 0};
+  if (compress && !data.empty()) {
+    std::vector<uint8_t> packed = lz4Compress(data.data(), data.size());
+    if (packed.size() < data.size()) {
+      // round trip, so that a codec bug cannot make it into a pack
+      std::vector<uint8_t> unpacked(data.size());
+      if (lz4Decompress(packed.data(), packed.size(), unpacked.data(),
+                        unpacked.size()) &&
+          unpacked == data) {
+        item.data.swap(packed);
+        item.flags |= PACK_LZ4;
+      } else {
+        MGL_LOG_ERROR("LZ4 round trip failed for " << item.name
+                      << ", stored raw");
+      }
+    }
+  }
+  Items.push_back(std::move(item));
+}
+
+static uint64_t alignUp(uint64_t offset) {
+  return (offset + PACK_ALIGNMENT - 1) & ~(PACK_ALIGNMENT - 1);
+}
+
+bool AssetPackWriter::write(const std::string &filename) {
+  std::sort(Items.begin(), Items.end(), [](const Item &a, const Item &b) {
+    return hashAssetName(a.name.c_str()) < hashAssetName(b.name.c_str());
+  });
+
+  PackHeader header = {};
+  std::memcpy(header.magic, PACK_MAGIC, sizeof(PACK_MAGIC));
+  header.version = PACK_VERSION;
+  header.count = static_cast<uint32_t>(Items.size());
+  header.tocOffset = sizeof(PackHeader);
+  header.namesOffset = header.tocOffset + Items.size() * sizeof(PackEntry);
+
+  std::vector<PackEntry> toc(Items.size());
+  std::string names;
+  for (std::size_t i = 0; i < Items.size(); i++) {
+    toc[i].nameOffset = static_cast<uint32_t>(header.namesOffset + names.size());
+    toc[i].nameLength = static_cast<uint32_t>(Items[i].name.size());
+    names += Items[i].name;
+    names += '\0';
+  }
+  uint64_t offset = alignUp(header.namesOffset + names.size());
+  for (std::size_t i = 0; i < Items.size(); i++) {
+    toc[i].hash = hashAssetName(Items[i].name.c_str());
+    toc[i].offset = offset;
+    toc[i].size = Items[i].data.size();
+    toc[i].rawSize = Items[i].rawSize;
+    toc[i].flags = Items[i].flags;
+    offset = alignUp(offset + toc[i].size);
+  }
+
+  std::ofstream ofile(filename, std::ios::binary | std::ios::trunc);
+  if (!ofile) {
+    MGL_LOG_ERROR("Cannot write asset pack " << filename);
+    return false;
+  }
+  const char padding[PACK_ALIGNMENT] = {};
+  ofile.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  ofile.write(reinterpret_cast<const char *>(toc.data()),
+              toc.size() * sizeof(PackEntry));
+  ofile.write(names.data(), names.size());
+  for (std::size_t i = 0; i < Items.size(); i++) {
+    const uint64_t position = static_cast<uint64_t>(ofile.tellp());
+    ofile.write(padding, toc[i].offset - position);
+    ofile.write(reinterpret_cast<const char *>(Items[i].data.data()),
+                Items[i].data.size());
+  }
+  return static_cast<bool>(ofile);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+}  // namespace mgl
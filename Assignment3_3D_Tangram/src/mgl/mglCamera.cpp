@@ -10,30 +10,43 @@
 
 #include "./mglCamera.hpp"
 
-#include <glm/gtc/type_ptr.hpp>
-
 namespace mgl {
 
     ///////////////////////////////////////////////////////////////////////// Camera
 
     Camera::Camera(GLuint bindingpoint)
-        : BindingPoint(bindingpoint), ViewMatrix(glm::mat4(1.0f)), ProjectionMatrix(glm::mat4(1.0f)) {
-        glGenBuffers(1, &UboId);
-        glBindBuffer(GL_UNIFORM_BUFFER, UboId);
+        : Ubo(createBuffer()), BindingPoint(bindingpoint), ViewMatrix(glm::mat4(1.0f)), ProjectionMatrix(glm::mat4(1.0f)),
+          UploadValid(false), Memory(MEMORY_CAMERA) {
+        Memory.setName("camera " + std::to_string(bindingpoint));
+        Memory.setCpu(sizeof(Camera));
+        Memory.setGpu(sizeof(glm::mat4) * 2);
+        glBindBuffer(GL_UNIFORM_BUFFER, Ubo.get());
         glBufferData(GL_UNIFORM_BUFFER, sizeof(glm::mat4) * 2, 0, GL_STREAM_DRAW);
-        glBindBufferBase(GL_UNIFORM_BUFFER, bindingpoint, UboId);
+        glBindBufferBase(GL_UNIFORM_BUFFER, bindingpoint, Ubo.get());
         glBindBuffer(GL_UNIFORM_BUFFER, 0);
     }
 
-    Camera::~Camera() {
-        glBindBuffer(GL_UNIFORM_BUFFER, 0);
-        glDeleteBuffers(1, &UboId);
-    }
+    Camera::~Camera() {}  // the uniform buffer is released by Ubo
 
     void Camera::activate() {
-        glBindBuffer(GL_UNIFORM_BUFFER, UboId);
+        glBindBuffer(GL_UNIFORM_BUFFER, Ubo.get());
         glBufferData(GL_UNIFORM_BUFFER, sizeof(glm::mat4) * 2, 0, GL_STREAM_DRAW);
-        glBindBufferBase(GL_UNIFORM_BUFFER, BindingPoint, UboId);
+        glBindBufferBase(GL_UNIFORM_BUFFER, BindingPoint, Ubo.get());
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        UploadValid = false;  // orphaned above
+    }
+
+    void Camera::upload() { upload(ViewMatrix, ProjectionMatrix); }
+
+    void Camera::upload(const glm::mat4& viewmatrix, const glm::mat4& projectionmatrix) {
+        if (UploadValid && Uploaded[0] == viewmatrix && Uploaded[1] == projectionmatrix) {
+            return;
+        }
+        Uploaded[0] = viewmatrix;
+        Uploaded[1] = projectionmatrix;
+        UploadValid = true;
+        glBindBuffer(GL_UNIFORM_BUFFER, Ubo.get());
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(Uploaded), Uploaded);
         glBindBuffer(GL_UNIFORM_BUFFER, 0);
     }
 
@@ -41,20 +54,12 @@ namespace mgl {
 
     void Camera::setViewMatrix(const glm::mat4& viewmatrix) {
         ViewMatrix = viewmatrix;
-        glBindBuffer(GL_UNIFORM_BUFFER, UboId);
-        glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(glm::mat4),
-            glm::value_ptr(ViewMatrix));
-        glBindBuffer(GL_UNIFORM_BUFFER, 0);
     }
 
     glm::mat4 Camera::getProjectionMatrix() { return ProjectionMatrix; }
 
     void Camera::setProjectionMatrix(const glm::mat4& projectionmatrix) {
         ProjectionMatrix = projectionmatrix;
-        glBindBuffer(GL_UNIFORM_BUFFER, UboId);
-        glBufferSubData(GL_UNIFORM_BUFFER, sizeof(glm::mat4), sizeof(glm::mat4),
-            glm::value_ptr(ProjectionMatrix));
-        glBindBuffer(GL_UNIFORM_BUFFER, 0);
     }
 
     void Camera::yawCamera(float angle) {
@@ -10,6 +10,14 @@
 
 #include <GL/glew.h>
 
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <tuple>
+
+#include "./mglLog.hpp"
+
 //////////////////////////////////////////////////////////// ERRORS (OPENGL 2.0)
 
 const std::string errorString(GLenum error) {
@@ -39,17 +47,61 @@ const std::string errorString(GLenum error) {
   }
 }
 
-void checkOpenGLError(const std::string &function, const std::string &file,
-                      int line) {
+static bool logOpenGLErrors() {
   bool isError = false;
   GLenum errCode;
   while ((errCode = glGetError()) != GL_NO_ERROR) {
     isError = true;
-    std::cerr << "OpenGL ERROR [" << errorString(errCode) << "]." << std::endl;
+    MGL_LOG_ERROR("OpenGL [" << errorString(errCode) << "].");
   }
-  if (isError) {
-    std::cerr << "ERROR @ FN '" << function << "' (" << file << ":" << line
-              << ")" << std::endl;
+  return isError;
+}
+
+void checkOpenGLError(const std::string &function, const std::string &file,
+                      int line) {
+  if (logOpenGLErrors()) {
+    MGL_LOG_ERROR("@ FN '" << function << "' (" << file << ":" << line << ")");
+    exit(EXIT_FAILURE);
+  }
+}
+
+/////////////////////////////////////////////////////////////////////// SAMPLING
+
+static unsigned int CheckInterval = 1;
+static std::string CheckedScope;
+static std::atomic<bool> Sampled{true};
+static thread_local int SelectedDepth = 0;  // checked scopes entered
+
+void setCheckInterval(unsigned int frames) { CheckInterval = frames; }
+
+void setCheckedScope(const std::string &name) { CheckedScope = name; }
+
+void beginCheckedFrame(unsigned int frame) {
+  Sampled = CheckInterval && frame % CheckInterval == 0;
+}
+
+bool isCheckSampled() { return Sampled || SelectedDepth > 0; }
+
+CheckScope::CheckScope(const char *name, const char *function,
+                       const char *file, int line)
+    : Name(name), Function(function), File(file), Line(line) {
+  Selected = !CheckedScope.empty() && CheckedScope == name;
+  Active = Selected || isCheckSampled();
+  if (!Active) return;
+  if (logOpenGLErrors()) {
+    MGL_LOG_ERROR("before scope '" << Name << "' @ FN '" << Function << "' ("
+                                   << File << ":" << Line << ")");
+    exit(EXIT_FAILURE);
+  }
+  if (Selected) SelectedDepth++;
+}
+
+CheckScope::~CheckScope() {
+  if (!Active) return;
+  if (Selected) SelectedDepth--;
+  if (logOpenGLErrors()) {
+    MGL_LOG_ERROR("in scope '" << Name << "' @ FN '" << Function << "' ("
+                               << File << ":" << Line << ")");
     exit(EXIT_FAILURE);
   }
 }
@@ -115,32 +167,70 @@ const std::string errorSeverity(GLenum severity) {
   }
 }
 
-void error(GLenum source, GLenum type, GLuint id, GLenum severity,
-           GLsizei length, const GLchar *message, const void *userParam) {
-  std::cerr << "GL ERROR:" << std::endl;
-  std::cerr << "  source:     " << errorSource(source) << std::endl;
-  std::cerr << "  type:       " << errorType(type) << std::endl;
-  std::cerr << "  severity:   " << errorSeverity(severity) << std::endl;
-  std::cerr << "  debug call: " << std::endl
-            << message << std::endl
-            << std::endl;
-  exit(EXIT_FAILURE);
+struct DebugMessage {
+  GLenum severity;
+  uint64_t count;
+  std::string text;
+};
+using DebugKey = std::tuple<GLenum, GLenum, GLuint>;  // source, type and id
+
+static std::mutex DebugMutex;  // the driver may call back from any thread
+static std::map<DebugKey, DebugMessage> DebugMessages;
+
+static std::string describe(const DebugKey &key, GLenum severity) {
+  return "GL " + errorType(std::get<1>(key)) + " [" +
+         errorSource(std::get<0>(key)) + " " +
+         std::to_string(std::get<2>(key)) + ", " + errorSeverity(severity) +
+         "]";
+}
+
+static void GLAPIENTRY debugOutput(GLenum source, GLenum type, GLuint id,
+                                   GLenum severity, GLsizei length,
+                                   const GLchar *message,
+                                   const void *userParam) {
+  const DebugKey key(source, type, id);
+  {
+    std::lock_guard<std::mutex> lock(DebugMutex);
+    DebugMessage &known = DebugMessages[key];
+    if (known.count++) return;
+    known.severity = severity;
+    known.text = message;
+  }
+  if (severity == GL_DEBUG_SEVERITY_HIGH || type == GL_DEBUG_TYPE_ERROR) {
+    MGL_LOG_ERROR(describe(key, severity) << ": " << message);
+  } else {
+    MGL_LOG_WARNING(describe(key, severity) << ": " << message);
+  }
 }
 
 void setupDebugOutput() {
   int context_flags = 0;
   glGetIntegerv(GL_CONTEXT_FLAGS, &context_flags);
-  if (context_flags & GL_CONTEXT_FLAG_DEBUG_BIT) {
-    std::cout << "Debug context created." << std::endl;
-  }
+  if (!(context_flags & GL_CONTEXT_FLAG_DEBUG_BIT)) return;
+  MGL_LOG_INFO("Debug context created.");
+  if (!GLEW_VERSION_4_3 && !GLEW_KHR_debug) return;
   glEnable(GL_DEBUG_OUTPUT);
-  glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
-  glDebugMessageCallback(error, NULL);
-  glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DONT_CARE, 0, NULL,
-                        GL_TRUE);
+  glDisable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+  glDebugMessageCallback(debugOutput, nullptr);
   glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE,
-                        GL_DEBUG_SEVERITY_NOTIFICATION, 0, NULL, GL_FALSE);
-  // params: source, type, severity, count, ids, enabled
+                        GL_DEBUG_SEVERITY_NOTIFICATION, 0, nullptr, GL_FALSE);
+}
+
+void releaseDebugOutput() {
+  if (!GLEW_VERSION_4_3 && !GLEW_KHR_debug) return;
+  glDebugMessageCallback(nullptr, nullptr);
+}
+
+void reportDebugOutput(std::ostream &os) {
+  std::lock_guard<std::mutex> lock(DebugMutex);
+  if (DebugMessages.empty()) return;
+  os << "GL debug output: " << DebugMessages.size() << " message(s)"
+     << std::endl;
+  for (auto &i : DebugMessages) {
+    os << "  " << i.second.count << "x "
+       << describe(i.first, i.second.severity) << ": " << i.second.text
+       << std::endl;
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
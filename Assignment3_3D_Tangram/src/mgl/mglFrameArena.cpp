@@ -0,0 +1,125 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Frame Arenas
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "./mglFrameArena.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <iomanip>
+#include <mutex>
+
+namespace mgl {
+
+static thread_local FrameArena *LocalArena = nullptr;
+
+// Arenas outlive their threads, so that report() still sees them at exit.
+static std::mutex &getRegistryMutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+
+static std::vector<std::unique_ptr<FrameArena>> &getRegistry() {
+  static std::vector<std::unique_ptr<FrameArena>> arenas;
+  return arenas;
+}
+
+static std::atomic<std::size_t> DefaultCapacity{FrameArena::DEFAULT_CAPACITY};
+
+static std::size_t alignUp(std::size_t n, std::size_t alignment) {
+  return (n + alignment - 1) & ~(alignment - 1);
+}
+
+///////////////////////////////////////////////////////////////////// FrameArena
+
+FrameArena::FrameArena(const std::string &name, std::size_t capacity)
+    : Name(name),
+      Capacity(capacity),
+      Top(0),
+      OverflowBytes(0),
+      HighWater(0),
+      Overflows(0) {}
+
+FrameArena *FrameArena::create() {
+  std::lock_guard<std::mutex> lock(getRegistryMutex());
+  std::vector<std::unique_ptr<FrameArena>> &arenas = getRegistry();
+  arenas.push_back(std::unique_ptr<FrameArena>(new FrameArena(
+      "Thread " + std::to_string(arenas.size() + 1), DefaultCapacity)));
+  return arenas.back().get();
+}
+
+FrameArena &FrameArena::getLocal() {
+  if (!LocalArena) LocalArena = create();
+  return *LocalArena;
+}
+
+void FrameArena::setDefaultCapacity(std::size_t bytes) {
+  DefaultCapacity = bytes;
+}
+
+void FrameArena::setName(const char *name) {
+  std::lock_guard<std::mutex> lock(getRegistryMutex());
+  Name = name;
+}
+
+// The block is only allocated when first needed, so that threads that never
+// use their arena cost nothing.
+void *FrameArena::allocate(std::size_t bytes, std::size_t alignment) {
+  if (!Block && Capacity) Block.reset(new unsigned char[Capacity]);
+  const uintptr_t base = reinterpret_cast<uintptr_t>(Block.get());
+  const std::size_t start = alignUp(base + Top, alignment) - base;
+  if (Block && start + bytes <= Capacity) {
+    Top = start + bytes;
+    HighWater = std::max(HighWater, Top + OverflowBytes);
+    return Block.get() + start;
+  }
+  Overflow.emplace_back(new unsigned char[bytes + alignment]);
+  OverflowBytes += bytes + alignment;
+  HighWater = std::max(HighWater, Top + OverflowBytes);
+  const uintptr_t block = reinterpret_cast<uintptr_t>(Overflow.back().get());
+  return reinterpret_cast<void *>(alignUp(block, alignment));
+}
+
+// Only the most recent allocation can be given back, e.g. a temporary freed
+// straight away; a growing vector leaves its old buffers behind until reset().
+void FrameArena::deallocate(void *p, std::size_t bytes) {
+  unsigned char *const start = static_cast<unsigned char *>(p);
+  if (start >= Block.get() && start + bytes == Block.get() + Top) {
+    Top = start - Block.get();
+  }
+}
+
+void FrameArena::reset() {
+  if (!Overflow.empty()) {
+    Overflows++;
+    Overflow.clear();
+    Capacity = std::max(Capacity, alignUp(HighWater, 4096));
+    Block.reset();
+  }
+  Top = OverflowBytes = 0;
+}
+
+std::size_t FrameArena::getCapacity() { return Capacity; }
+
+std::size_t FrameArena::getUsed() { return Top + OverflowBytes; }
+
+std::size_t FrameArena::getHighWater() { return HighWater; }
+
+uint32_t FrameArena::getOverflows() { return Overflows; }
+
+void FrameArena::report(std::ostream &os) {
+  std::lock_guard<std::mutex> lock(getRegistryMutex());
+  os << std::left << std::setw(16) << "Frame arena" << std::right
+     << std::setw(12) << "capacity" << std::setw(12) << "high water"
+     << std::setw(11) << "overflows" << std::endl;
+  for (const std::unique_ptr<FrameArena> &arena : getRegistry()) {
+    os << std::left << std::setw(16) << arena->Name << std::right
+       << std::setw(12) << arena->Capacity << std::setw(12)
+       << arena->HighWater << std::setw(11) << arena->Overflows << std::endl;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+}  // namespace mgl
@@ -0,0 +1,115 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Frame Pacing
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "./mglFramePacer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+namespace mgl {
+
+////////////////////////////////////////////////////////////////////////// SETUP
+
+FramePacer::FramePacer()
+    : TargetPeriod(0.0), IdlePeriod(0.0), SpinMargin(0.002) {
+  reset();
+}
+
+void FramePacer::setTargetFps(double fps) {
+  TargetPeriod = fps > 0.0 ? 1.0 / fps : 0.0;
+}
+
+void FramePacer::setIdleFps(double fps) {
+  IdlePeriod = fps > 0.0 ? 1.0 / fps : 0.0;
+}
+
+void FramePacer::setSpinMargin(double milliseconds) {
+  SpinMargin = std::max(0.0, milliseconds / 1000.0);
+}
+
+bool FramePacer::isIdleEnabled() { return IdlePeriod > 0.0; }
+
+void FramePacer::reset() {
+  Started = LastIdle = false;
+  Frames = Late = 0;
+  Mean = M2 = Min = Max = 0.0;
+}
+
+///////////////////////////////////////////////////////////////////////// PACING
+
+double FramePacer::getPeriod(bool idle) {
+  return idle && IdlePeriod > 0.0 ? IdlePeriod : TargetPeriod;
+}
+
+double FramePacer::getRemaining(bool idle) {
+  const double period = getPeriod(idle);
+  if (!Started || period == 0.0) return 0.0;
+  const std::chrono::duration<double> left =
+      Scheduled + std::chrono::duration<double>(period) - Clock::now();
+  return std::max(0.0, left.count());
+}
+
+void FramePacer::wait(bool idle) {
+  const double period = getPeriod(idle);
+  Clock::time_point now = Clock::now();
+  Clock::time_point due = now;
+  if (Started && period > 0.0) {
+    due = Scheduled + std::chrono::duration_cast<Clock::duration>(
+                          std::chrono::duration<double>(period));
+    const Clock::duration margin = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(SpinMargin));
+    if (due - now > margin) std::this_thread::sleep_for(due - now - margin);
+    while ((now = Clock::now()) < due) std::this_thread::yield();
+    if (now - due >= due - Scheduled) due = now;  // a whole period late
+  }
+  if (Started && !idle && !LastIdle) {
+    addInterval(std::chrono::duration<double>(now - LastStart).count());
+  }
+  Started = true;
+  LastIdle = idle;
+  Scheduled = due;
+  LastStart = now;
+}
+
+///////////////////////////////////////////////////////////////////////// JITTER
+
+// Welford's running mean and variance, so that nothing is stored per frame.
+void FramePacer::addInterval(double seconds) {
+  Frames++;
+  const double delta = seconds - Mean;
+  Mean += delta / Frames;
+  M2 += delta * (seconds - Mean);
+  Min = Frames == 1 ? seconds : std::min(Min, seconds);
+  Max = std::max(Max, seconds);
+  if (TargetPeriod > 0.0 && seconds > 1.5 * TargetPeriod) Late++;
+}
+
+FramePacer::Jitter FramePacer::getJitter() {
+  Jitter jitter;
+  jitter.frames = Frames;
+  jitter.mean = Mean * 1000.0;
+  jitter.stddev = Frames > 1 ? std::sqrt(M2 / (Frames - 1)) * 1000.0 : 0.0;
+  jitter.min = Min * 1000.0;
+  jitter.max = Max * 1000.0;
+  jitter.late = Late;
+  return jitter;
+}
+
+void FramePacer::report(std::ostream &os) {
+  const Jitter jitter = getJitter();
+  os << "Frame interval [ms]: mean " << jitter.mean << ", jitter (stddev) "
+     << jitter.stddev << ", min " << jitter.min << ", max " << jitter.max
+     << " over " << jitter.frames << " frame(s)";
+  if (TargetPeriod > 0.0) {
+    os << ", target " << TargetPeriod * 1000.0 << ", " << jitter.late
+       << " late";
+  }
+  os << std::endl;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+}  // namespace mgl
@@ -0,0 +1,205 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Frame Statistics and Baselines
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "./mglFrameStats.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+
+#include "./mglLog.hpp"
+
+namespace mgl {
+
+static const char *SERIES_NAMES[] = {"cpu",     "gpu",  "events",
+                                     "display", "swap", "gpu_wait",
+                                     "input_latency"};
+
+// Upper bounds of the histogram buckets in milliseconds; the last is open.
+static const double HISTOGRAM_BOUNDS[] = {0.25, 0.5, 1.0,  2.0,
+                                          4.0,  8.0, 16.7, 33.3, 66.7};
+static const int HISTOGRAM_BUCKETS =
+    sizeof(HISTOGRAM_BOUNDS) / sizeof(HISTOGRAM_BOUNDS[0]) + 1;
+
+/////////////////////////////////////////////////////////////////// FrameStats
+
+void FrameStats::reset(uint32_t first_frame, uint32_t frames) {
+  FirstFrame = first_frame;
+  for (std::vector<double> &series : Series) {
+    series.clear();
+    series.reserve(frames);
+  }
+  GpuValid.assign(frames, false);
+  Series[1].assign(frames, 0.0);
+}
+
+void FrameStats::addCpu(uint32_t frame, double cpu,
+                        const double (&phases)[FRAME_PHASES]) {
+  if (frame < FirstFrame || frame - FirstFrame >= GpuValid.size()) return;
+  Series[0].push_back(cpu);
+  for (int i = 0; i < FRAME_PHASES; i++) Series[2 + i].push_back(phases[i]);
+}
+
+void FrameStats::addGpu(uint32_t frame, double gpu) {
+  if (frame < FirstFrame || frame - FirstFrame >= GpuValid.size()) return;
+  Series[1][frame - FirstFrame] = gpu;
+  GpuValid[frame - FirstFrame] = true;
+}
+
+void FrameStats::addInputLatency(uint32_t frame, double latency) {
+  if (frame < FirstFrame || frame - FirstFrame >= GpuValid.size()) return;
+  Series[SERIES - 1].push_back(latency);
+}
+
+bool FrameStats::hasGpu() {
+  return std::find(GpuValid.begin(), GpuValid.end(), true) != GpuValid.end();
+}
+
+// Nearest-rank percentiles.
+FrameStats::Summary FrameStats::summarize(std::vector<double> values) {
+  Summary s;
+  if (values.empty()) return s;
+  std::sort(values.begin(), values.end());
+  const std::size_t n = values.size();
+  auto rank = [&](double p) {
+    const std::size_t r = static_cast<std::size_t>(std::ceil(p * n));
+    return values[std::min(n, std::max<std::size_t>(r, 1)) - 1];
+  };
+  s.p50 = rank(0.50);
+  s.p95 = rank(0.95);
+  s.p99 = rank(0.99);
+  s.max = values.back();
+  for (double v : values) s.mean += v / n;
+  return s;
+}
+
+std::map<std::string, double> FrameStats::getMetrics() {
+  std::map<std::string, double> metrics;
+  for (int i = 0; i < SERIES; i++) {
+    std::vector<double> values;
+    if (i == 1) {
+      for (std::size_t f = 0; f < GpuValid.size(); f++) {
+        if (GpuValid[f]) values.push_back(Series[1][f]);
+      }
+    } else {
+      values = Series[i];
+    }
+    if (values.empty()) continue;
+    const Summary s = summarize(values);
+    const std::string name = SERIES_NAMES[i];
+    metrics[name + "_p50_ms"] = s.p50;
+    metrics[name + "_p95_ms"] = s.p95;
+    metrics[name + "_p99_ms"] = s.p99;
+    metrics[name + "_max_ms"] = s.max;
+    metrics[name + "_mean_ms"] = s.mean;
+  }
+  return metrics;
+}
+
+///////////////////////////////////////////////////////////////////////// REPORT
+
+bool FrameStats::writeReport(const std::string &filename) {
+  std::ofstream ofile(filename);
+  if (!ofile) {
+    MGL_LOG_ERROR("Cannot write " << filename);
+    return false;
+  }
+  ofile << std::fixed << std::setprecision(4);
+  ofile << "{\n  \"frames\": " << Series[0].size() << ",\n  \"metrics\": {";
+  bool first = true;
+  for (const auto &m : getMetrics()) {
+    ofile << (first ? "" : ",") << "\n    \"" << m.first << "\": " << m.second;
+    first = false;
+  }
+  ofile << "\n  },\n  \"histograms\": {";
+  for (int i = 0; i < 2; i++) {
+    int counts[HISTOGRAM_BUCKETS] = {};
+    for (std::size_t f = 0; f < Series[i].size(); f++) {
+      if (i == 1 && !GpuValid[f]) continue;
+      const double *bound =
+          std::lower_bound(std::begin(HISTOGRAM_BOUNDS),
+                           std::end(HISTOGRAM_BOUNDS), Series[i][f]);
+      counts[bound - std::begin(HISTOGRAM_BOUNDS)]++;
+    }
+    ofile << (i ? "," : "") << "\n    \"" << SERIES_NAMES[i] << "\": [";
+    for (int b = 0; b < HISTOGRAM_BUCKETS; b++) {
+      ofile << (b ? ", " : "") << "{\"le_ms\": ";
+      if (b < HISTOGRAM_BUCKETS - 1) {
+        ofile << HISTOGRAM_BOUNDS[b];
+      } else {
+        ofile << "null";
+      }
+      ofile << ", \"count\": " << counts[b] << "}";
+    }
+    ofile << "]";
+  }
+  ofile << "\n  }\n}\n";
+  return static_cast<bool>(ofile);
+}
+
+/////////////////////////////////////////////////////////////////////// BASELINE
+
+// Reads the flat object of numbers under "key"; enough for our own reports.
+static std::map<std::string, double> readNumbers(const std::string &text,
+                                                 const std::string &key) {
+  std::map<std::string, double> numbers;
+  std::size_t p = text.find("\"" + key + "\"");
+  if (p == std::string::npos) return numbers;
+  p = text.find('{', p);
+  while (p != std::string::npos) {
+    const std::size_t name_start = text.find_first_of("\"}", p + 1);
+    if (name_start == std::string::npos || text[name_start] == '}') break;
+    const std::size_t name_end = text.find('"', name_start + 1);
+    const std::size_t colon = text.find(':', name_end);
+    if (name_end == std::string::npos || colon == std::string::npos) break;
+    char *end = nullptr;
+    const double value = std::strtod(text.c_str() + colon + 1, &end);
+    numbers[text.substr(name_start + 1, name_end - name_start - 1)] = value;
+    p = end - text.c_str();
+  }
+  return numbers;
+}
+
+bool FrameStats::compare(const std::string &baseline, double tolerance) {
+  std::ifstream ifile(baseline);
+  if (!ifile) {
+    MGL_LOG_ERROR("Cannot read baseline " << baseline);
+    return false;
+  }
+  std::stringstream buffer;
+  buffer << ifile.rdbuf();
+  const std::map<std::string, double> expected =
+      readNumbers(buffer.str(), "metrics");
+  const std::map<std::string, double> tolerances =
+      readNumbers(buffer.str(), "tolerances");
+
+  bool passed = true;
+  for (const auto &m : getMetrics()) {
+    auto base = expected.find(m.first);
+    if (base == expected.end()) continue;
+    auto t = tolerances.find(m.first);
+    const bool is_max = m.first.find("_max_") != std::string::npos;
+    if (is_max && t == tolerances.end()) continue;
+    const double allowed = t != tolerances.end() ? t->second : tolerance;
+    const double change =
+        base->second > 0.0 ? 100.0 * (m.second / base->second - 1.0) : 0.0;
+    const bool regressed = change > allowed;
+    std::cout << (regressed ? "REGRESSION " : "ok         ") << m.first << " "
+              << m.second << " ms (baseline " << base->second << " ms, "
+              << (change >= 0 ? "+" : "") << change << "%, allowed +"
+              << allowed << "%)" << std::endl;
+    passed = passed && !regressed;
+  }
+  return passed;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+}  // namespace mgl
@@ -0,0 +1,307 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// OpenGL Call Counters
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "./mglGLCounters.hpp"
+
+#include <GL/glew.h>
+
+#include <iomanip>
+#include <iostream>
+
+namespace mgl {
+
+// Written by the wrappers on the GL thread only, hence not atomic.
+static GLCallCounts Current;
+
+static uint64_t countTriangles(GLenum mode, GLsizei count) {
+  switch (mode) {
+    case GL_TRIANGLES:
+      return count / 3;
+    case GL_TRIANGLE_STRIP:
+    case GL_TRIANGLE_FAN:
+      return count > 2 ? count - 2 : 0;
+    default:
+      return 0;
+  }
+}
+
+/////////////////////////////////////////////////////////////////////// WRAPPERS
+
+static PFNGLDRAWELEMENTSBASEVERTEXPROC RealDrawElementsBaseVertex;
+static PFNGLDRAWRANGEELEMENTSPROC RealDrawRangeElements;
+static PFNGLDRAWELEMENTSINSTANCEDPROC RealDrawElementsInstanced;
+static PFNGLDRAWELEMENTSINSTANCEDBASEVERTEXPROC
+    RealDrawElementsInstancedBaseVertex;
+static PFNGLDRAWARRAYSINSTANCEDPROC RealDrawArraysInstanced;
+static PFNGLUSEPROGRAMPROC RealUseProgram;
+static PFNGLUNIFORM1IPROC RealUniform1i;
+static PFNGLUNIFORM1FPROC RealUniform1f;
+static PFNGLUNIFORM3FPROC RealUniform3f;
+static PFNGLUNIFORM3FVPROC RealUniform3fv;
+static PFNGLUNIFORM4FVPROC RealUniform4fv;
+static PFNGLUNIFORMMATRIX3FVPROC RealUniformMatrix3fv;
+static PFNGLUNIFORMMATRIX4FVPROC RealUniformMatrix4fv;
+static PFNGLBINDBUFFERPROC RealBindBuffer;
+static PFNGLBINDBUFFERBASEPROC RealBindBufferBase;
+static PFNGLBINDBUFFERRANGEPROC RealBindBufferRange;
+static PFNGLBINDVERTEXARRAYPROC RealBindVertexArray;
+static PFNGLBINDFRAMEBUFFERPROC RealBindFramebuffer;
+static PFNGLACTIVETEXTUREPROC RealActiveTexture;
+static PFNGLBINDSAMPLERPROC RealBindSampler;
+static PFNGLBUFFERDATAPROC RealBufferData;
+static PFNGLBUFFERSUBDATAPROC RealBufferSubData;
+
+// GLEW declares the indices of this one as non-const.
+static void GLAPIENTRY countedDrawElementsBaseVertex(GLenum mode,
+                                                     GLsizei count,
+                                                     GLenum type, void *indices,
+                                                     GLint basevertex) {
+  Current.calls[GL_CALL_DRAW]++;
+  Current.triangles += countTriangles(mode, count);
+  RealDrawElementsBaseVertex(mode, count, type, indices, basevertex);
+}
+
+static void GLAPIENTRY countedDrawRangeElements(GLenum mode, GLuint start,
+                                                GLuint end, GLsizei count,
+                                                GLenum type,
+                                                const void *indices) {
+  Current.calls[GL_CALL_DRAW]++;
+  Current.triangles += countTriangles(mode, count);
+  RealDrawRangeElements(mode, start, end, count, type, indices);
+}
+
+static void GLAPIENTRY countedDrawElementsInstanced(GLenum mode,
+                                                    GLsizei count,
+                                                    GLenum type,
+                                                    const void *indices,
+                                                    GLsizei instances) {
+  Current.calls[GL_CALL_DRAW]++;
+  Current.triangles += countTriangles(mode, count) * instances;
+  RealDrawElementsInstanced(mode, count, type, indices, instances);
+}
+
+static void GLAPIENTRY countedDrawElementsInstancedBaseVertex(
+    GLenum mode, GLsizei count, GLenum type, const void *indices,
+    GLsizei instances, GLint basevertex) {
+  Current.calls[GL_CALL_DRAW]++;
+  Current.triangles += countTriangles(mode, count) * instances;
+  RealDrawElementsInstancedBaseVertex(mode, count, type, indices, instances,
+                                      basevertex);
+}
+
+static void GLAPIENTRY countedDrawArraysInstanced(GLenum mode, GLint first,
+                                                  GLsizei count,
+                                                  GLsizei instances) {
+  Current.calls[GL_CALL_DRAW]++;
+  Current.triangles += countTriangles(mode, count) * instances;
+  RealDrawArraysInstanced(mode, first, count, instances);
+}
+
+static void GLAPIENTRY countedUseProgram(GLuint program) {
+  Current.calls[GL_CALL_PROGRAM]++;
+  RealUseProgram(program);
+}
+
+static void GLAPIENTRY countedUniform1i(GLint location, GLint v0) {
+  Current.calls[GL_CALL_UNIFORM]++;
+  RealUniform1i(location, v0);
+}
+
+static void GLAPIENTRY countedUniform1f(GLint location, GLfloat v0) {
+  Current.calls[GL_CALL_UNIFORM]++;
+  RealUniform1f(location, v0);
+}
+
+static void GLAPIENTRY countedUniform3f(GLint location, GLfloat v0,
+                                        GLfloat v1, GLfloat v2) {
+  Current.calls[GL_CALL_UNIFORM]++;
+  RealUniform3f(location, v0, v1, v2);
+}
+
+static void GLAPIENTRY countedUniform3fv(GLint location, GLsizei count,
+                                         const GLfloat *value) {
+  Current.calls[GL_CALL_UNIFORM]++;
+  RealUniform3fv(location, count, value);
+}
+
+static void GLAPIENTRY countedUniform4fv(GLint location, GLsizei count,
+                                         const GLfloat *value) {
+  Current.calls[GL_CALL_UNIFORM]++;
+  RealUniform4fv(location, count, value);
+}
+
+static void GLAPIENTRY countedUniformMatrix3fv(GLint location, GLsizei count,
+                                               GLboolean transpose,
+                                               const GLfloat *value) {
+  Current.calls[GL_CALL_UNIFORM]++;
+  RealUniformMatrix3fv(location, count, transpose, value);
+}
+
+static void GLAPIENTRY countedUniformMatrix4fv(GLint location, GLsizei count,
+                                               GLboolean transpose,
+                                               const GLfloat *value) {
+  Current.calls[GL_CALL_UNIFORM]++;
+  RealUniformMatrix4fv(location, count, transpose, value);
+}
+
+static void GLAPIENTRY countedBindBuffer(GLenum target, GLuint buffer) {
+  Current.calls[GL_CALL_BIND]++;
+  RealBindBuffer(target, buffer);
+}
+
+static void GLAPIENTRY countedBindBufferBase(GLenum target, GLuint index,
+                                             GLuint buffer) {
+  Current.calls[GL_CALL_BIND]++;
+  RealBindBufferBase(target, index, buffer);
+}
+
+static void GLAPIENTRY countedBindBufferRange(GLenum target, GLuint index,
+                                              GLuint buffer, GLintptr offset,
+                                              GLsizeiptr size) {
+  Current.calls[GL_CALL_BIND]++;
+  RealBindBufferRange(target, index, buffer, offset, size);
+}
+
+static void GLAPIENTRY countedBindVertexArray(GLuint array) {
+  Current.calls[GL_CALL_BIND]++;
+  RealBindVertexArray(array);
+}
+
+static void GLAPIENTRY countedBindFramebuffer(GLenum target,
+                                              GLuint framebuffer) {
+  Current.calls[GL_CALL_BIND]++;
+  RealBindFramebuffer(target, framebuffer);
+}
+
+static void GLAPIENTRY countedActiveTexture(GLenum texture) {
+  Current.calls[GL_CALL_BIND]++;
+  RealActiveTexture(texture);
+}
+
+static void GLAPIENTRY countedBindSampler(GLuint unit, GLuint sampler) {
+  Current.calls[GL_CALL_BIND]++;
+  RealBindSampler(unit, sampler);
+}
+
+// Orphaning a buffer with a null pointer allocates but uploads nothing.
+static void GLAPIENTRY countedBufferData(GLenum target, GLsizeiptr size,
+                                         const void *data, GLenum usage) {
+  Current.calls[GL_CALL_UPLOAD]++;
+  if (data) Current.bytes += size;
+  RealBufferData(target, size, data, usage);
+}
+
+static void GLAPIENTRY countedBufferSubData(GLenum target, GLintptr offset,
+                                            GLsizeiptr size,
+                                            const void *data) {
+  Current.calls[GL_CALL_UPLOAD]++;
+  Current.bytes += size;
+  RealBufferSubData(target, offset, size, data);
+}
+
+// Entry points the driver does not provide are left alone.
+#define MGL_INTERCEPT(name)       \
+  Real##name = __glew##name;      \
+  if (Real##name) {               \
+    __glew##name = counted##name; \
+  }
+
+///////////////////////////////////////////////////////////////////// GLCounters
+
+GLCounters::GLCounters()
+    : Installed(false), SummaryInterval(0), Frames(0), IntervalFrames(0) {}
+
+GLCounters &GLCounters::getInstance() {
+  static GLCounters instance;
+  return instance;
+}
+
+void GLCounters::install() {
+  if (Installed) return;
+  MGL_INTERCEPT(DrawElementsBaseVertex);
+  MGL_INTERCEPT(DrawRangeElements);
+  MGL_INTERCEPT(DrawElementsInstanced);
+  MGL_INTERCEPT(DrawElementsInstancedBaseVertex);
+  MGL_INTERCEPT(DrawArraysInstanced);
+  MGL_INTERCEPT(UseProgram);
+  MGL_INTERCEPT(Uniform1i);
+  MGL_INTERCEPT(Uniform1f);
+  MGL_INTERCEPT(Uniform3f);
+  MGL_INTERCEPT(Uniform3fv);
+  MGL_INTERCEPT(Uniform4fv);
+  MGL_INTERCEPT(UniformMatrix3fv);
+  MGL_INTERCEPT(UniformMatrix4fv);
+  MGL_INTERCEPT(BindBuffer);
+  MGL_INTERCEPT(BindBufferBase);
+  MGL_INTERCEPT(BindBufferRange);
+  MGL_INTERCEPT(BindVertexArray);
+  MGL_INTERCEPT(BindFramebuffer);
+  MGL_INTERCEPT(ActiveTexture);
+  MGL_INTERCEPT(BindSampler);
+  MGL_INTERCEPT(BufferData);
+  MGL_INTERCEPT(BufferSubData);
+  Installed = true;
+}
+
+bool GLCounters::isInstalled() { return Installed; }
+
+void GLCounters::setSummaryInterval(unsigned int frames) {
+  SummaryInterval = frames;
+}
+
+static void accumulate(GLCallCounts &sum, const GLCallCounts &counts) {
+  for (int i = 0; i < GL_CALL_CATEGORIES; i++) sum.calls[i] += counts.calls[i];
+  sum.bytes += counts.bytes;
+  sum.triangles += counts.triangles;
+}
+
+void GLCounters::endFrame() {
+  if (!Installed) return;
+  Frame = Current;
+  Current = GLCallCounts();
+  accumulate(Total, Frame);
+  accumulate(Interval, Frame);
+  Frames++;
+  if (SummaryInterval && ++IntervalFrames == SummaryInterval) {
+    printSummary();
+    Interval = GLCallCounts();
+    IntervalFrames = 0;
+  }
+}
+
+const GLCallCounts &GLCounters::getFrame() { return Frame; }
+
+const GLCallCounts &GLCounters::getCurrent() { return Current; }
+
+void GLCounters::rewind(const GLCallCounts &counts) { Current = counts; }
+
+const GLCallCounts &GLCounters::getTotal() { return Total; }
+
+uint64_t GLCounters::getFrames() { return Frames; }
+
+const char *GLCounters::getCategoryName(GLCallCategory category) {
+  static const char *names[GL_CALL_CATEGORIES] = {"draw", "program", "uniform",
+                                                  "bind", "upload"};
+  return names[category];
+}
+
+// Per-frame averages over the last interval.
+void GLCounters::printSummary() {
+  const double n = IntervalFrames;
+  std::cout << std::fixed << std::setprecision(1) << "GL calls/frame:";
+  for (int i = 0; i < GL_CALL_CATEGORIES; i++) {
+    std::cout << (i ? ", " : " ")
+              << getCategoryName(static_cast<GLCallCategory>(i)) << " "
+              << Interval.calls[i] / n;
+  }
+  std::cout << "; " << Interval.bytes / n / 1024.0 << " KB uploaded, "
+            << Interval.triangles / n << " triangles" << std::endl;
+  std::cout.unsetf(std::ios::floatfield);
+  std::cout << std::setprecision(6);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+}  // namespace mgl
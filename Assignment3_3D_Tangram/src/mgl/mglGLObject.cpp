@@ -0,0 +1,134 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// OpenGL Object Handles
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "./mglGLObject.hpp"
+
+namespace mgl {
+
+////////////////////////////////////////////////////////////////// DeletionQueue
+
+DeletionQueue &DeletionQueue::getInstance() {
+  static DeletionQueue instance;
+  return instance;
+}
+
+DeletionQueue::DeletionQueue() : Budget(DEFAULT_BUDGET), Deleted(0) {}
+
+void DeletionQueue::release(GLObjectType type, GLuint id) {
+  std::lock_guard<std::mutex> lock(Mutex);
+  Released.push_back({type, id});
+}
+
+void DeletionQueue::setBudget(unsigned int objects) { Budget = objects; }
+
+// A fence is only checked, never waited for: batches not yet done are left
+// for a later frame. The swap of the next frame flushes it. Swapping leaves
+// Released with the emptied vector of a spare batch, capacity and all.
+void DeletionQueue::endFrame() {
+  {
+    std::lock_guard<std::mutex> lock(Mutex);
+    if (!Released.empty()) {
+      if (Spare.empty()) Spare.emplace_back();
+      Retired.splice(Retired.end(), Spare, Spare.begin());
+      Batch &batch = Retired.back();
+      batch.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+      batch.next = 0;
+      batch.objects.swap(Released);
+    }
+  }
+  unsigned int budget = Budget;
+  while (!Retired.empty()) {
+    Batch &batch = Retired.front();
+    if (batch.fence) {
+      if (glClientWaitSync(batch.fence, 0, 0) == GL_TIMEOUT_EXPIRED) return;
+      glDeleteSync(batch.fence);
+      batch.fence = nullptr;
+    }
+    for (; batch.next < batch.objects.size(); batch.next++) {
+      if (Budget && !budget--) return;
+      destroy(batch.objects[batch.next]);
+      Deleted++;
+    }
+    batch.objects.clear();
+    Spare.splice(Spare.end(), Retired, Retired.begin());
+  }
+}
+
+void DeletionQueue::flush() {
+  std::lock_guard<std::mutex> lock(Mutex);
+  for (Batch &batch : Retired) {
+    if (batch.fence) glDeleteSync(batch.fence);
+    for (; batch.next < batch.objects.size(); batch.next++) {
+      destroy(batch.objects[batch.next]);
+      Deleted++;
+    }
+    batch.objects.clear();
+  }
+  Spare.splice(Spare.end(), Retired);
+  for (const Object &object : Released) destroy(object);
+  Deleted += Released.size();
+  Released.clear();
+}
+
+std::size_t DeletionQueue::getPending() {
+  std::lock_guard<std::mutex> lock(Mutex);
+  std::size_t pending = Released.size();
+  for (const Batch &batch : Retired) {
+    pending += batch.objects.size() - batch.next;
+  }
+  return pending;
+}
+
+uint64_t DeletionQueue::getDeleted() { return Deleted; }
+
+void DeletionQueue::destroy(const Object &object) {
+  switch (object.type) {
+    case GL_OBJECT_BUFFER:
+      glDeleteBuffers(1, &object.id);
+      break;
+    case GL_OBJECT_VERTEX_ARRAY:
+      glDeleteVertexArrays(1, &object.id);
+      break;
+    case GL_OBJECT_TEXTURE:
+      glDeleteTextures(1, &object.id);
+      break;
+    case GL_OBJECT_PROGRAM:
+      glDeleteProgram(object.id);
+      break;
+    case GL_OBJECT_FRAMEBUFFER:
+      glDeleteFramebuffers(1, &object.id);
+      break;
+    case GL_OBJECT_RENDERBUFFER:
+      glDeleteRenderbuffers(1, &object.id);
+      break;
+    case GL_OBJECT_QUERY:
+      glDeleteQueries(1, &object.id);
+      break;
+  }
+}
+
+/////////////////////////////////////////////////////////////////////// CREATION
+
+GLBuffer createBuffer() {
+  GLuint id;
+  glGenBuffers(1, &id);
+  return GLBuffer(id);
+}
+
+GLVertexArray createVertexArray() {
+  GLuint id;
+  glGenVertexArrays(1, &id);
+  return GLVertexArray(id);
+}
+
+GLTexture createTexture() {
+  GLuint id;
+  glGenTextures(1, &id);
+  return GLTexture(id);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+}  // namespace mgl
@@ -0,0 +1,940 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// OpenGL Command Trace
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "./mglGLTrace.hpp"
+
+#include <cstring>
+#include <iostream>
+#include <iterator>
+
+#include "./mglLog.hpp"
+
+namespace mgl {
+
+static const char TRACE_MAGIC[8] = {'M', 'G', 'L', 'T', 'R', 'A', 'C', 'E'};
+static const uint32_t TRACE_VERSION = 1;
+
+enum GLTraceOp : uint16_t {
+  GL_TRACE_FRAME,
+  GL_TRACE_GEN_BUFFERS,  // n, names
+  GL_TRACE_DELETE_BUFFERS,
+  GL_TRACE_BIND_BUFFER,
+  GL_TRACE_BIND_BUFFER_BASE,
+  GL_TRACE_BIND_BUFFER_RANGE,
+  GL_TRACE_BUFFER_DATA,  // target, usage, size, data (empty if none)
+  GL_TRACE_BUFFER_SUB_DATA,
+  GL_TRACE_GEN_VERTEX_ARRAYS,
+  GL_TRACE_DELETE_VERTEX_ARRAYS,
+  GL_TRACE_BIND_VERTEX_ARRAY,
+  GL_TRACE_ENABLE_VERTEX_ATTRIB_ARRAY,
+  GL_TRACE_DISABLE_VERTEX_ATTRIB_ARRAY,
+  GL_TRACE_VERTEX_ATTRIB_POINTER,
+  GL_TRACE_CREATE_SHADER,  // type, name
+  GL_TRACE_DELETE_SHADER,
+  GL_TRACE_SHADER_SOURCE,  // shader, all strings joined
+  GL_TRACE_COMPILE_SHADER,
+  GL_TRACE_CREATE_PROGRAM,
+  GL_TRACE_DELETE_PROGRAM,
+  GL_TRACE_ATTACH_SHADER,
+  GL_TRACE_DETACH_SHADER,
+  GL_TRACE_BIND_ATTRIB_LOCATION,
+  GL_TRACE_LINK_PROGRAM,
+  GL_TRACE_USE_PROGRAM,
+  GL_TRACE_GET_UNIFORM_LOCATION,  // program, result, name
+  GL_TRACE_GET_UNIFORM_BLOCK_INDEX,
+  GL_TRACE_UNIFORM_BLOCK_BINDING,
+  GL_TRACE_UNIFORM_1I,
+  GL_TRACE_UNIFORM_1F,
+  GL_TRACE_UNIFORM_2F,
+  GL_TRACE_UNIFORM_3F,
+  GL_TRACE_UNIFORM_3FV,
+  GL_TRACE_UNIFORM_4FV,
+  GL_TRACE_UNIFORM_MATRIX_3FV,
+  GL_TRACE_UNIFORM_MATRIX_4FV,
+  GL_TRACE_DRAW_ELEMENTS_BASE_VERTEX,
+  GL_TRACE_DRAW_RANGE_ELEMENTS,
+  GL_TRACE_DRAW_ELEMENTS_INSTANCED,
+  GL_TRACE_DRAW_ELEMENTS_INSTANCED_BASE_VERTEX,
+  GL_TRACE_DRAW_ARRAYS_INSTANCED,
+  GL_TRACE_OPS
+};
+
+/////////////////////////////////////////////////////////////////////// WRITING
+
+struct Blob {
+  const void *data;
+  uint32_t size;
+};
+
+// Written by the wrappers on the GL thread only. Records go to memory and
+// reach the file once per frame, so the capture does not stall the calls.
+static std::vector<char> Buffer;
+static bool Capturing = false;
+
+template <typename T>
+static void put(const T &value) {
+  const char *p = reinterpret_cast<const char *>(&value);
+  Buffer.insert(Buffer.end(), p, p + sizeof(T));
+}
+
+static void put(const Blob &blob) {
+  put(blob.size);
+  const char *p = static_cast<const char *>(blob.data);
+  if (blob.size) Buffer.insert(Buffer.end(), p, p + blob.size);
+}
+
+// Pointers into bound buffers are offsets and are stored as such.
+static void put(const void *offset) {
+  put(static_cast<uint64_t>(reinterpret_cast<uintptr_t>(offset)));
+}
+
+template <typename... T>
+static void record(GLTraceOp op, const T &...args) {
+  if (!Capturing) return;
+  put(static_cast<uint16_t>(op));
+  const std::size_t size_at = Buffer.size();
+  put(uint32_t(0));
+  (put(args), ...);
+  const uint32_t size =
+      static_cast<uint32_t>(Buffer.size() - size_at - sizeof(uint32_t));
+  std::memcpy(&Buffer[size_at], &size, sizeof(size));
+}
+
+static Blob text(const GLchar *s) {
+  return {s, static_cast<uint32_t>(std::strlen(s) + 1)};
+}
+
+/////////////////////////////////////////////////////////////////////// WRAPPERS
+
+static PFNGLGENBUFFERSPROC RealGenBuffers;
+static PFNGLDELETEBUFFERSPROC RealDeleteBuffers;
+static PFNGLBINDBUFFERPROC RealBindBuffer;
+static PFNGLBINDBUFFERBASEPROC RealBindBufferBase;
+static PFNGLBINDBUFFERRANGEPROC RealBindBufferRange;
+static PFNGLBUFFERDATAPROC RealBufferData;
+static PFNGLBUFFERSUBDATAPROC RealBufferSubData;
+static PFNGLGENVERTEXARRAYSPROC RealGenVertexArrays;
+static PFNGLDELETEVERTEXARRAYSPROC RealDeleteVertexArrays;
+static PFNGLBINDVERTEXARRAYPROC RealBindVertexArray;
+static PFNGLENABLEVERTEXATTRIBARRAYPROC RealEnableVertexAttribArray;
+static PFNGLDISABLEVERTEXATTRIBARRAYPROC RealDisableVertexAttribArray;
+static PFNGLVERTEXATTRIBPOINTERPROC RealVertexAttribPointer;
+static PFNGLCREATESHADERPROC RealCreateShader;
+static PFNGLDELETESHADERPROC RealDeleteShader;
+static PFNGLSHADERSOURCEPROC RealShaderSource;
+static PFNGLCOMPILESHADERPROC RealCompileShader;
+static PFNGLCREATEPROGRAMPROC RealCreateProgram;
+static PFNGLDELETEPROGRAMPROC RealDeleteProgram;
+static PFNGLATTACHSHADERPROC RealAttachShader;
+static PFNGLDETACHSHADERPROC RealDetachShader;
+static PFNGLBINDATTRIBLOCATIONPROC RealBindAttribLocation;
+static PFNGLLINKPROGRAMPROC RealLinkProgram;
+static PFNGLUSEPROGRAMPROC RealUseProgram;
+static PFNGLGETUNIFORMLOCATIONPROC RealGetUniformLocation;
+static PFNGLGETUNIFORMBLOCKINDEXPROC RealGetUniformBlockIndex;
+static PFNGLUNIFORMBLOCKBINDINGPROC RealUniformBlockBinding;
+static PFNGLUNIFORM1IPROC RealUniform1i;
+static PFNGLUNIFORM1FPROC RealUniform1f;
+static PFNGLUNIFORM2FPROC RealUniform2f;
+static PFNGLUNIFORM3FPROC RealUniform3f;
+static PFNGLUNIFORM3FVPROC RealUniform3fv;
+static PFNGLUNIFORM4FVPROC RealUniform4fv;
+static PFNGLUNIFORMMATRIX3FVPROC RealUniformMatrix3fv;
+static PFNGLUNIFORMMATRIX4FVPROC RealUniformMatrix4fv;
+static PFNGLDRAWELEMENTSBASEVERTEXPROC RealDrawElementsBaseVertex;
+static PFNGLDRAWRANGEELEMENTSPROC RealDrawRangeElements;
+static PFNGLDRAWELEMENTSINSTANCEDPROC RealDrawElementsInstanced;
+static PFNGLDRAWELEMENTSINSTANCEDBASEVERTEXPROC
+    RealDrawElementsInstancedBaseVertex;
+static PFNGLDRAWARRAYSINSTANCEDPROC RealDrawArraysInstanced;
+
+static Blob names(GLsizei n, const GLuint *ids) {
+  return {ids, static_cast<uint32_t>(n * sizeof(GLuint))};
+}
+
+static void GLAPIENTRY tracedGenBuffers(GLsizei n, GLuint *buffers) {
+  RealGenBuffers(n, buffers);
+  record(GL_TRACE_GEN_BUFFERS, names(n, buffers));
+}
+
+static void GLAPIENTRY tracedDeleteBuffers(GLsizei n, const GLuint *buffers) {
+  record(GL_TRACE_DELETE_BUFFERS, names(n, buffers));
+  RealDeleteBuffers(n, buffers);
+}
+
+static void GLAPIENTRY tracedBindBuffer(GLenum target, GLuint buffer) {
+  record(GL_TRACE_BIND_BUFFER, target, buffer);
+  RealBindBuffer(target, buffer);
+}
+
+static void GLAPIENTRY tracedBindBufferBase(GLenum target, GLuint index,
+                                            GLuint buffer) {
+  record(GL_TRACE_BIND_BUFFER_BASE, target, index, buffer);
+  RealBindBufferBase(target, index, buffer);
+}
+
+static void GLAPIENTRY tracedBindBufferRange(GLenum target, GLuint index,
+                                             GLuint buffer, GLintptr offset,
+                                             GLsizeiptr size) {
+  record(GL_TRACE_BIND_BUFFER_RANGE, target, index, buffer,
+         static_cast<int64_t>(offset), static_cast<int64_t>(size));
+  RealBindBufferRange(target, index, buffer, offset, size);
+}
+
+static void GLAPIENTRY tracedBufferData(GLenum target, GLsizeiptr size,
+                                        const void *data, GLenum usage) {
+  record(GL_TRACE_BUFFER_DATA, target, usage, static_cast<int64_t>(size),
+         Blob{data, data ? static_cast<uint32_t>(size) : 0});
+  RealBufferData(target, size, data, usage);
+}
+
+static void GLAPIENTRY tracedBufferSubData(GLenum target, GLintptr offset,
+                                           GLsizeiptr size, const void *data) {
+  record(GL_TRACE_BUFFER_SUB_DATA, target, static_cast<int64_t>(offset),
+         Blob{data, static_cast<uint32_t>(size)});
+  RealBufferSubData(target, offset, size, data);
+}
+
+static void GLAPIENTRY tracedGenVertexArrays(GLsizei n, GLuint *arrays) {
+  RealGenVertexArrays(n, arrays);
+  record(GL_TRACE_GEN_VERTEX_ARRAYS, names(n, arrays));
+}
+
+static void GLAPIENTRY tracedDeleteVertexArrays(GLsizei n,
+                                                const GLuint *arrays) {
+  record(GL_TRACE_DELETE_VERTEX_ARRAYS, names(n, arrays));
+  RealDeleteVertexArrays(n, arrays);
+}
+
+static void GLAPIENTRY tracedBindVertexArray(GLuint array) {
+  record(GL_TRACE_BIND_VERTEX_ARRAY, array);
+  RealBindVertexArray(array);
+}
+
+static void GLAPIENTRY tracedEnableVertexAttribArray(GLuint index) {
+  record(GL_TRACE_ENABLE_VERTEX_ATTRIB_ARRAY, index);
+  RealEnableVertexAttribArray(index);
+}
+
+static void GLAPIENTRY tracedDisableVertexAttribArray(GLuint index) {
+  record(GL_TRACE_DISABLE_VERTEX_ATTRIB_ARRAY, index);
+  RealDisableVertexAttribArray(index);
+}
+
+static void GLAPIENTRY tracedVertexAttribPointer(GLuint index, GLint size,
+                                                 GLenum type,
+                                                 GLboolean normalized,
+                                                 GLsizei stride,
+                                                 const void *pointer) {
+  record(GL_TRACE_VERTEX_ATTRIB_POINTER, index, size, type, normalized, stride,
+         pointer);
+  RealVertexAttribPointer(index, size, type, normalized, stride, pointer);
+}
+
+static GLuint GLAPIENTRY tracedCreateShader(GLenum type) {
+  const GLuint shader = RealCreateShader(type);
+  record(GL_TRACE_CREATE_SHADER, type, shader);
+  return shader;
+}
+
+static void GLAPIENTRY tracedDeleteShader(GLuint shader) {
+  record(GL_TRACE_DELETE_SHADER, shader);
+  RealDeleteShader(shader);
+}
+
+static void GLAPIENTRY tracedShaderSource(GLuint shader, GLsizei count,
+                                          const GLchar *const *strings,
+                                          const GLint *lengths) {
+  if (Capturing) {
+    std::string source;
+    for (GLsizei i = 0; i < count; i++) {
+      if (lengths && lengths[i] >= 0) {
+        source.append(strings[i], lengths[i]);
+      } else {
+        source.append(strings[i]);
+      }
+    }
+    record(GL_TRACE_SHADER_SOURCE, shader, text(source.c_str()));
+  }
+  RealShaderSource(shader, count, strings, lengths);
+}
+
+static void GLAPIENTRY tracedCompileShader(GLuint shader) {
+  record(GL_TRACE_COMPILE_SHADER, shader);
+  RealCompileShader(shader);
+}
+
+static GLuint GLAPIENTRY tracedCreateProgram() {
+  const GLuint program = RealCreateProgram();
+  record(GL_TRACE_CREATE_PROGRAM, program);
+  return program;
+}
+
+static void GLAPIENTRY tracedDeleteProgram(GLuint program) {
+  record(GL_TRACE_DELETE_PROGRAM, program);
+  RealDeleteProgram(program);
+}
+
+static void GLAPIENTRY tracedAttachShader(GLuint program, GLuint shader) {
+  record(GL_TRACE_ATTACH_SHADER, program, shader);
+  RealAttachShader(program, shader);
+}
+
+static void GLAPIENTRY tracedDetachShader(GLuint program, GLuint shader) {
+  record(GL_TRACE_DETACH_SHADER, program, shader);
+  RealDetachShader(program, shader);
+}
+
+static void GLAPIENTRY tracedBindAttribLocation(GLuint program, GLuint index,
+                                                const GLchar *name) {
+  record(GL_TRACE_BIND_ATTRIB_LOCATION, program, index, text(name));
+  RealBindAttribLocation(program, index, name);
+}
+
+static void GLAPIENTRY tracedLinkProgram(GLuint program) {
+  record(GL_TRACE_LINK_PROGRAM, program);
+  RealLinkProgram(program);
+}
+
+static void GLAPIENTRY tracedUseProgram(GLuint program) {
+  record(GL_TRACE_USE_PROGRAM, program);
+  RealUseProgram(program);
+}
+
+static GLint GLAPIENTRY tracedGetUniformLocation(GLuint program,
+                                                 const GLchar *name) {
+  const GLint location = RealGetUniformLocation(program, name);
+  record(GL_TRACE_GET_UNIFORM_LOCATION, program, location, text(name));
+  return location;
+}
+
+static GLuint GLAPIENTRY tracedGetUniformBlockIndex(GLuint program,
+                                                    const GLchar *name) {
+  const GLuint index = RealGetUniformBlockIndex(program, name);
+  record(GL_TRACE_GET_UNIFORM_BLOCK_INDEX, program, index, text(name));
+  return index;
+}
+
+static void GLAPIENTRY tracedUniformBlockBinding(GLuint program, GLuint index,
+                                                 GLuint binding) {
+  record(GL_TRACE_UNIFORM_BLOCK_BINDING, program, index, binding);
+  RealUniformBlockBinding(program, index, binding);
+}
+
+static void GLAPIENTRY tracedUniform1i(GLint location, GLint v0) {
+  record(GL_TRACE_UNIFORM_1I, location, v0);
+  RealUniform1i(location, v0);
+}
+
+static void GLAPIENTRY tracedUniform1f(GLint location, GLfloat v0) {
+  record(GL_TRACE_UNIFORM_1F, location, v0);
+  RealUniform1f(location, v0);
+}
+
+static void GLAPIENTRY tracedUniform2f(GLint location, GLfloat v0,
+                                       GLfloat v1) {
+  record(GL_TRACE_UNIFORM_2F, location, v0, v1);
+  RealUniform2f(location, v0, v1);
+}
+
+static void GLAPIENTRY tracedUniform3f(GLint location, GLfloat v0, GLfloat v1,
+                                       GLfloat v2) {
+  record(GL_TRACE_UNIFORM_3F, location, v0, v1, v2);
+  RealUniform3f(location, v0, v1, v2);
+}
+
+static Blob floats(GLsizei count, int components, const GLfloat *value) {
+  return {value, static_cast<uint32_t>(count * components * sizeof(GLfloat))};
+}
+
+static void GLAPIENTRY tracedUniform3fv(GLint location, GLsizei count,
+                                        const GLfloat *value) {
+  record(GL_TRACE_UNIFORM_3FV, location, floats(count, 3, value));
+  RealUniform3fv(location, count, value);
+}
+
+static void GLAPIENTRY tracedUniform4fv(GLint location, GLsizei count,
+                                        const GLfloat *value) {
+  record(GL_TRACE_UNIFORM_4FV, location, floats(count, 4, value));
+  RealUniform4fv(location, count, value);
+}
+
+static void GLAPIENTRY tracedUniformMatrix3fv(GLint location, GLsizei count,
+                                              GLboolean transpose,
+                                              const GLfloat *value) {
+  record(GL_TRACE_UNIFORM_MATRIX_3FV, location, transpose,
+         floats(count, 9, value));
+  RealUniformMatrix3fv(location, count, transpose, value);
+}
+
+static void GLAPIENTRY tracedUniformMatrix4fv(GLint location, GLsizei count,
+                                              GLboolean transpose,
+                                              const GLfloat *value) {
+  record(GL_TRACE_UNIFORM_MATRIX_4FV, location, transpose,
+         floats(count, 16, value));
+  RealUniformMatrix4fv(location, count, transpose, value);
+}
+
+// GLEW declares the indices of this one as non-const.
+static void GLAPIENTRY tracedDrawElementsBaseVertex(GLenum mode, GLsizei count,
+                                                    GLenum type, void *indices,
+                                                    GLint basevertex) {
+  record(GL_TRACE_DRAW_ELEMENTS_BASE_VERTEX, mode, count, type,
+         static_cast<const void *>(indices), basevertex);
+  RealDrawElementsBaseVertex(mode, count, type, indices, basevertex);
+}
+
+static void GLAPIENTRY tracedDrawRangeElements(GLenum mode, GLuint start,
+                                               GLuint end, GLsizei count,
+                                               GLenum type,
+                                               const void *indices) {
+  record(GL_TRACE_DRAW_RANGE_ELEMENTS, mode, start, end, count, type, indices);
+  RealDrawRangeElements(mode, start, end, count, type, indices);
+}
+
+static void GLAPIENTRY tracedDrawElementsInstanced(GLenum mode, GLsizei count,
+                                                   GLenum type,
+                                                   const void *indices,
+                                                   GLsizei instances) {
+  record(GL_TRACE_DRAW_ELEMENTS_INSTANCED, mode, count, type, indices,
+         instances);
+  RealDrawElementsInstanced(mode, count, type, indices, instances);
+}
+
+static void GLAPIENTRY tracedDrawElementsInstancedBaseVertex(
+    GLenum mode, GLsizei count, GLenum type, const void *indices,
+    GLsizei instances, GLint basevertex) {
+  record(GL_TRACE_DRAW_ELEMENTS_INSTANCED_BASE_VERTEX, mode, count, type,
+         indices, instances, basevertex);
+  RealDrawElementsInstancedBaseVertex(mode, count, type, indices, instances,
+                                      basevertex);
+}
+
+static void GLAPIENTRY tracedDrawArraysInstanced(GLenum mode, GLint first,
+                                                 GLsizei count,
+                                                 GLsizei instances) {
+  record(GL_TRACE_DRAW_ARRAYS_INSTANCED, mode, first, count, instances);
+  RealDrawArraysInstanced(mode, first, count, instances);
+}
+
+// Entry points the driver does not provide are left alone. Installed after
+// GLCounters, the wrappers call through to the counting ones.
+#define MGL_TRACE(name)          \
+  Real##name = __glew##name;     \
+  if (Real##name) {              \
+    __glew##name = traced##name; \
+  }
+
+//////////////////////////////////////////////////////////////// GLTraceRecorder
+
+GLTraceRecorder::GLTraceRecorder()
+    : FrameLimit(0), Frames(0), Installed(false) {}
+
+GLTraceRecorder &GLTraceRecorder::getInstance() {
+  static GLTraceRecorder instance;
+  return instance;
+}
+
+bool GLTraceRecorder::open(const std::string &filename, uint32_t frames) {
+  File.open(filename, std::ios::binary | std::ios::trunc);
+  if (!File) {
+    MGL_LOG_ERROR("Cannot write " << filename);
+    return false;
+  }
+  Filename = filename;
+  FrameLimit = frames;
+  return true;
+}
+
+bool GLTraceRecorder::isOpen() { return File.is_open(); }
+
+void GLTraceRecorder::install(uint16_t width, uint16_t height) {
+  if (Installed || !File.is_open()) return;
+  File.write(TRACE_MAGIC, sizeof(TRACE_MAGIC));
+  File.write(reinterpret_cast<const char *>(&TRACE_VERSION),
+             sizeof(TRACE_VERSION));
+  File.write(reinterpret_cast<const char *>(&width), sizeof(width));
+  File.write(reinterpret_cast<const char *>(&height), sizeof(height));
+
+  MGL_TRACE(GenBuffers);
+  MGL_TRACE(DeleteBuffers);
+  MGL_TRACE(BindBuffer);
+  MGL_TRACE(BindBufferBase);
+  MGL_TRACE(BindBufferRange);
+  MGL_TRACE(BufferData);
+  MGL_TRACE(BufferSubData);
+  MGL_TRACE(GenVertexArrays);
+  MGL_TRACE(DeleteVertexArrays);
+  MGL_TRACE(BindVertexArray);
+  MGL_TRACE(EnableVertexAttribArray);
+  MGL_TRACE(DisableVertexAttribArray);
+  MGL_TRACE(VertexAttribPointer);
+  MGL_TRACE(CreateShader);
+  MGL_TRACE(DeleteShader);
+  MGL_TRACE(ShaderSource);
+  MGL_TRACE(CompileShader);
+  MGL_TRACE(CreateProgram);
+  MGL_TRACE(DeleteProgram);
+  MGL_TRACE(AttachShader);
+  MGL_TRACE(DetachShader);
+  MGL_TRACE(BindAttribLocation);
+  MGL_TRACE(LinkProgram);
+  MGL_TRACE(UseProgram);
+  MGL_TRACE(GetUniformLocation);
+  MGL_TRACE(GetUniformBlockIndex);
+  MGL_TRACE(UniformBlockBinding);
+  MGL_TRACE(Uniform1i);
+  MGL_TRACE(Uniform1f);
+  MGL_TRACE(Uniform2f);
+  MGL_TRACE(Uniform3f);
+  MGL_TRACE(Uniform3fv);
+  MGL_TRACE(Uniform4fv);
+  MGL_TRACE(UniformMatrix3fv);
+  MGL_TRACE(UniformMatrix4fv);
+  MGL_TRACE(DrawElementsBaseVertex);
+  MGL_TRACE(DrawRangeElements);
+  MGL_TRACE(DrawElementsInstanced);
+  MGL_TRACE(DrawElementsInstancedBaseVertex);
+  MGL_TRACE(DrawArraysInstanced);
+  Installed = true;
+  Capturing = true;
+}
+
+void GLTraceRecorder::setPaused(bool paused) {
+  Capturing = Installed && File.is_open() && !paused;
+}
+
+void GLTraceRecorder::beginFrame() { record(GL_TRACE_FRAME); }
+
+void GLTraceRecorder::endFrame() {
+  if (!File.is_open()) return;
+  File.write(Buffer.data(), Buffer.size());
+  Buffer.clear();
+  if (++Frames == FrameLimit) close();
+}
+
+// The wrappers stay installed and keep calling through.
+void GLTraceRecorder::close() {
+  if (!File.is_open()) return;
+  File.write(Buffer.data(), Buffer.size());
+  Buffer.clear();
+  Buffer.shrink_to_fit();
+  Capturing = false;
+  File.close();
+  if (!File) {
+    MGL_LOG_ERROR("Cannot write " << Filename);
+    return;
+  }
+  std::cout << "GL trace: " << Frames << " frame(s) written to " << Filename
+            << std::endl;
+}
+
+////////////////////////////////////////////////////////////////// GLTracePlayer
+
+struct TraceReader {
+  const char *p;
+
+  template <typename T>
+  T get() {
+    T value;
+    std::memcpy(&value, p, sizeof(T));
+    p += sizeof(T);
+    return value;
+  }
+
+  const void *offset() {
+    return reinterpret_cast<const void *>(
+        static_cast<uintptr_t>(get<uint64_t>()));
+  }
+
+  const char *blob(uint32_t &size) {
+    size = get<uint32_t>();
+    const char *data = p;
+    p += size;
+    return data;
+  }
+};
+
+static const std::size_t RECORD_HEADER = sizeof(uint16_t) + sizeof(uint32_t);
+
+bool GLTracePlayer::open(const std::string &filename) {
+  std::ifstream ifile(filename, std::ios::binary);
+  Data.assign(std::istreambuf_iterator<char>(ifile),
+              std::istreambuf_iterator<char>());
+  const std::size_t header = sizeof(TRACE_MAGIC) + sizeof(TRACE_VERSION) +
+                             sizeof(Width) + sizeof(Height);
+  uint32_t version = 0;
+  if (Data.size() >= header) {
+    std::memcpy(&version, Data.data() + sizeof(TRACE_MAGIC), sizeof(version));
+  }
+  if (Data.size() < header ||
+      std::memcmp(Data.data(), TRACE_MAGIC, sizeof(TRACE_MAGIC)) != 0 ||
+      version != TRACE_VERSION) {
+    MGL_LOG_ERROR(filename << " is not a GL trace");
+    return false;
+  }
+  std::memcpy(&Width, &Data[header - 4], sizeof(Width));
+  std::memcpy(&Height, &Data[header - 2], sizeof(Height));
+
+  // A record cut short by a crash ends the trace.
+  FrameStarts.clear();
+  FrameCommands.clear();
+  std::size_t p = header;
+  while (p + RECORD_HEADER <= Data.size()) {
+    uint16_t op;
+    uint32_t size;
+    std::memcpy(&op, &Data[p], sizeof(op));
+    std::memcpy(&size, &Data[p + sizeof(op)], sizeof(size));
+    if (p + RECORD_HEADER + size > Data.size()) break;
+    if (op == GL_TRACE_FRAME) {
+      FrameStarts.push_back(p);
+      FrameCommands.push_back(0);
+    } else if (!FrameCommands.empty()) {
+      FrameCommands.back()++;
+    }
+    p += RECORD_HEADER + size;
+  }
+  Data.resize(p);
+  SetupEnd = FrameStarts.empty() ? p : FrameStarts.front();
+  FrameStarts.push_back(p);
+  return true;
+}
+
+uint16_t GLTracePlayer::getWidth() { return Width; }
+
+uint16_t GLTracePlayer::getHeight() { return Height; }
+
+uint32_t GLTracePlayer::getFrameCount() {
+  return static_cast<uint32_t>(FrameStarts.size() - 1);
+}
+
+std::size_t GLTracePlayer::getCommandCount(uint32_t frame) {
+  return FrameCommands[frame];
+}
+
+void GLTracePlayer::setup() {
+  const std::size_t header = sizeof(TRACE_MAGIC) + sizeof(TRACE_VERSION) +
+                             sizeof(Width) + sizeof(Height);
+  execute(header, SetupEnd);
+}
+
+void GLTracePlayer::play(uint32_t frame) {
+  execute(FrameStarts[frame], FrameStarts[frame + 1]);
+}
+
+GLuint &GLTracePlayer::name(ObjectType type, GLuint captured) {
+  std::vector<GLuint> &names = Names[type];
+  if (captured >= names.size()) names.resize(captured + 1, 0);
+  return names[captured];
+}
+
+GLint GLTracePlayer::location(GLint captured) {
+  if (captured < 0 || Program >= Locations.size()) return -1;
+  const std::vector<GLint> &locations = Locations[Program];
+  return static_cast<std::size_t>(captured) < locations.size()
+             ? locations[captured]
+             : -1;
+}
+
+template <typename T>
+static void store(std::vector<std::vector<T>> &table, GLuint program,
+                  std::size_t captured, T value, T missing) {
+  if (program >= table.size()) table.resize(program + 1);
+  std::vector<T> &values = table[program];
+  if (captured >= values.size()) values.resize(captured + 1, missing);
+  values[captured] = value;
+}
+
+void GLTracePlayer::execute(std::size_t begin, std::size_t end) {
+  TraceReader r{Data.data() + begin};
+  const char *const last = Data.data() + end;
+  std::vector<GLuint> generated;
+  uint32_t size;
+  while (r.p < last) {
+    const GLTraceOp op = static_cast<GLTraceOp>(r.get<uint16_t>());
+    const uint32_t record_size = r.get<uint32_t>();
+    const char *const next = r.p + record_size;
+    switch (op) {
+      case GL_TRACE_FRAME:
+        break;
+      case GL_TRACE_GEN_BUFFERS:
+      case GL_TRACE_GEN_VERTEX_ARRAYS: {
+        const char *data = r.blob(size);
+        const GLsizei n = size / sizeof(GLuint);
+        generated.resize(n);
+        const ObjectType type =
+            op == GL_TRACE_GEN_BUFFERS ? BUFFER : VERTEX_ARRAY;
+        if (type == BUFFER) {
+          glGenBuffers(n, generated.data());
+        } else {
+          glGenVertexArrays(n, generated.data());
+        }
+        for (GLsizei i = 0; i < n; i++) {
+          GLuint captured;
+          std::memcpy(&captured, data + i * sizeof(GLuint), sizeof(captured));
+          name(type, captured) = generated[i];
+        }
+        break;
+      }
+      case GL_TRACE_DELETE_BUFFERS:
+      case GL_TRACE_DELETE_VERTEX_ARRAYS: {
+        const char *data = r.blob(size);
+        const GLsizei n = size / sizeof(GLuint);
+        generated.resize(n);
+        const ObjectType type =
+            op == GL_TRACE_DELETE_BUFFERS ? BUFFER : VERTEX_ARRAY;
+        for (GLsizei i = 0; i < n; i++) {
+          GLuint captured;
+          std::memcpy(&captured, data + i * sizeof(GLuint), sizeof(captured));
+          generated[i] = name(type, captured);
+          name(type, captured) = 0;
+        }
+        if (type == BUFFER) {
+          glDeleteBuffers(n, generated.data());
+        } else {
+          glDeleteVertexArrays(n, generated.data());
+        }
+        break;
+      }
+      case GL_TRACE_BIND_BUFFER: {
+        const GLenum target = r.get<GLenum>();
+        glBindBuffer(target, name(BUFFER, r.get<GLuint>()));
+        break;
+      }
+      case GL_TRACE_BIND_BUFFER_BASE: {
+        const GLenum target = r.get<GLenum>();
+        const GLuint index = r.get<GLuint>();
+        glBindBufferBase(target, index, name(BUFFER, r.get<GLuint>()));
+        break;
+      }
+      case GL_TRACE_BIND_BUFFER_RANGE: {
+        const GLenum target = r.get<GLenum>();
+        const GLuint index = r.get<GLuint>();
+        const GLuint buffer = name(BUFFER, r.get<GLuint>());
+        const int64_t offset = r.get<int64_t>();
+        glBindBufferRange(target, index, buffer, offset, r.get<int64_t>());
+        break;
+      }
+      case GL_TRACE_BUFFER_DATA: {
+        const GLenum target = r.get<GLenum>();
+        const GLenum usage = r.get<GLenum>();
+        const int64_t buffer_size = r.get<int64_t>();
+        const char *data = r.blob(size);
+        glBufferData(target, buffer_size, size ? data : nullptr, usage);
+        break;
+      }
+      case GL_TRACE_BUFFER_SUB_DATA: {
+        const GLenum target = r.get<GLenum>();
+        const int64_t offset = r.get<int64_t>();
+        const char *data = r.blob(size);
+        glBufferSubData(target, offset, size, data);
+        break;
+      }
+      case GL_TRACE_BIND_VERTEX_ARRAY:
+        glBindVertexArray(name(VERTEX_ARRAY, r.get<GLuint>()));
+        break;
+      case GL_TRACE_ENABLE_VERTEX_ATTRIB_ARRAY:
+        glEnableVertexAttribArray(r.get<GLuint>());
+        break;
+      case GL_TRACE_DISABLE_VERTEX_ATTRIB_ARRAY:
+        glDisableVertexAttribArray(r.get<GLuint>());
+        break;
+      case GL_TRACE_VERTEX_ATTRIB_POINTER: {
+        const GLuint index = r.get<GLuint>();
+        const GLint components = r.get<GLint>();
+        const GLenum type = r.get<GLenum>();
+        const GLboolean normalized = r.get<GLboolean>();
+        const GLsizei stride = r.get<GLsizei>();
+        glVertexAttribPointer(index, components, type, normalized, stride,
+                              r.offset());
+        break;
+      }
+      case GL_TRACE_CREATE_SHADER: {
+        const GLenum type = r.get<GLenum>();
+        name(SHADER, r.get<GLuint>()) = glCreateShader(type);
+        break;
+      }
+      case GL_TRACE_DELETE_SHADER: {
+        GLuint &shader = name(SHADER, r.get<GLuint>());
+        glDeleteShader(shader);
+        shader = 0;
+        break;
+      }
+      case GL_TRACE_SHADER_SOURCE: {
+        const GLuint shader = name(SHADER, r.get<GLuint>());
+        const GLchar *source = r.blob(size);
+        glShaderSource(shader, 1, &source, nullptr);
+        break;
+      }
+      case GL_TRACE_COMPILE_SHADER:
+        glCompileShader(name(SHADER, r.get<GLuint>()));
+        break;
+      case GL_TRACE_CREATE_PROGRAM:
+        name(PROGRAM, r.get<GLuint>()) = glCreateProgram();
+        break;
+      case GL_TRACE_DELETE_PROGRAM: {
+        const GLuint captured = r.get<GLuint>();
+        glDeleteProgram(name(PROGRAM, captured));
+        name(PROGRAM, captured) = 0;
+        if (captured < Locations.size()) Locations[captured].clear();
+        if (captured < BlockIndices.size()) BlockIndices[captured].clear();
+        break;
+      }
+      case GL_TRACE_ATTACH_SHADER:
+      case GL_TRACE_DETACH_SHADER: {
+        const GLuint program = name(PROGRAM, r.get<GLuint>());
+        const GLuint shader = name(SHADER, r.get<GLuint>());
+        if (op == GL_TRACE_ATTACH_SHADER) {
+          glAttachShader(program, shader);
+        } else {
+          glDetachShader(program, shader);
+        }
+        break;
+      }
+      case GL_TRACE_BIND_ATTRIB_LOCATION: {
+        const GLuint program = name(PROGRAM, r.get<GLuint>());
+        const GLuint index = r.get<GLuint>();
+        glBindAttribLocation(program, index, r.blob(size));
+        break;
+      }
+      case GL_TRACE_LINK_PROGRAM:
+        glLinkProgram(name(PROGRAM, r.get<GLuint>()));
+        break;
+      case GL_TRACE_USE_PROGRAM:
+        Program = r.get<GLuint>();
+        glUseProgram(name(PROGRAM, Program));
+        break;
+      case GL_TRACE_GET_UNIFORM_LOCATION: {
+        const GLuint captured = r.get<GLuint>();
+        const GLint captured_location = r.get<GLint>();
+        const GLint actual =
+            glGetUniformLocation(name(PROGRAM, captured), r.blob(size));
+        if (captured_location >= 0) {
+          store(Locations, captured, captured_location, actual, GLint(-1));
+        }
+        break;
+      }
+      case GL_TRACE_GET_UNIFORM_BLOCK_INDEX: {
+        const GLuint captured = r.get<GLuint>();
+        const GLuint captured_index = r.get<GLuint>();
+        const GLuint actual =
+            glGetUniformBlockIndex(name(PROGRAM, captured), r.blob(size));
+        if (captured_index != GL_INVALID_INDEX) {
+          store(BlockIndices, captured, captured_index, actual,
+                GLuint(GL_INVALID_INDEX));
+        }
+        break;
+      }
+      case GL_TRACE_UNIFORM_BLOCK_BINDING: {
+        const GLuint captured = r.get<GLuint>();
+        GLuint index = r.get<GLuint>();
+        if (captured < BlockIndices.size() &&
+            index < BlockIndices[captured].size()) {
+          index = BlockIndices[captured][index];
+        }
+        glUniformBlockBinding(name(PROGRAM, captured), index, r.get<GLuint>());
+        break;
+      }
+      case GL_TRACE_UNIFORM_1I: {
+        const GLint loc = location(r.get<GLint>());
+        glUniform1i(loc, r.get<GLint>());
+        break;
+      }
+      case GL_TRACE_UNIFORM_1F: {
+        const GLint loc = location(r.get<GLint>());
+        glUniform1f(loc, r.get<GLfloat>());
+        break;
+      }
+      case GL_TRACE_UNIFORM_2F: {
+        const GLint loc = location(r.get<GLint>());
+        const GLfloat v0 = r.get<GLfloat>();
+        glUniform2f(loc, v0, r.get<GLfloat>());
+        break;
+      }
+      case GL_TRACE_UNIFORM_3F: {
+        const GLint loc = location(r.get<GLint>());
+        const GLfloat v0 = r.get<GLfloat>();
+        const GLfloat v1 = r.get<GLfloat>();
+        glUniform3f(loc, v0, v1, r.get<GLfloat>());
+        break;
+      }
+      // Uniform values are passed in place, unaligned, for the driver to copy.
+      case GL_TRACE_UNIFORM_3FV:
+      case GL_TRACE_UNIFORM_4FV: {
+        const GLint loc = location(r.get<GLint>());
+        const GLfloat *value = reinterpret_cast<const GLfloat *>(r.blob(size));
+        if (op == GL_TRACE_UNIFORM_3FV) {
+          glUniform3fv(loc, size / (3 * sizeof(GLfloat)), value);
+        } else {
+          glUniform4fv(loc, size / (4 * sizeof(GLfloat)), value);
+        }
+        break;
+      }
+      case GL_TRACE_UNIFORM_MATRIX_3FV:
+      case GL_TRACE_UNIFORM_MATRIX_4FV: {
+        const GLint loc = location(r.get<GLint>());
+        const GLboolean transpose = r.get<GLboolean>();
+        const GLfloat *value = reinterpret_cast<const GLfloat *>(r.blob(size));
+        if (op == GL_TRACE_UNIFORM_MATRIX_3FV) {
+          glUniformMatrix3fv(loc, size / (9 * sizeof(GLfloat)), transpose,
+                             value);
+        } else {
+          glUniformMatrix4fv(loc, size / (16 * sizeof(GLfloat)), transpose,
+                             value);
+        }
+        break;
+      }
+      case GL_TRACE_DRAW_ELEMENTS_BASE_VERTEX: {
+        const GLenum mode = r.get<GLenum>();
+        const GLsizei count = r.get<GLsizei>();
+        const GLenum type = r.get<GLenum>();
+        void *indices = const_cast<void *>(r.offset());
+        glDrawElementsBaseVertex(mode, count, type, indices, r.get<GLint>());
+        break;
+      }
+      case GL_TRACE_DRAW_RANGE_ELEMENTS: {
+        const GLenum mode = r.get<GLenum>();
+        const GLuint start = r.get<GLuint>();
+        const GLuint end = r.get<GLuint>();
+        const GLsizei count = r.get<GLsizei>();
+        const GLenum type = r.get<GLenum>();
+        glDrawRangeElements(mode, start, end, count, type, r.offset());
+        break;
+      }
+      case GL_TRACE_DRAW_ELEMENTS_INSTANCED: {
+        const GLenum mode = r.get<GLenum>();
+        const GLsizei count = r.get<GLsizei>();
+        const GLenum type = r.get<GLenum>();
+        const void *indices = r.offset();
+        glDrawElementsInstanced(mode, count, type, indices, r.get<GLsizei>());
+        break;
+      }
+      case GL_TRACE_DRAW_ELEMENTS_INSTANCED_BASE_VERTEX: {
+        const GLenum mode = r.get<GLenum>();
+        const GLsizei count = r.get<GLsizei>();
+        const GLenum type = r.get<GLenum>();
+        const void *indices = r.offset();
+        const GLsizei instances = r.get<GLsizei>();
+        glDrawElementsInstancedBaseVertex(mode, count, type, indices,
+                                          instances, r.get<GLint>());
+        break;
+      }
+      case GL_TRACE_DRAW_ARRAYS_INSTANCED: {
+        const GLenum mode = r.get<GLenum>();
+        const GLint first = r.get<GLint>();
+        const GLsizei count = r.get<GLsizei>();
+        glDrawArraysInstanced(mode, first, count, r.get<GLsizei>());
+        break;
+      }
+      default:  // from a newer version, skipped
+        break;
+    }
+    r.p = next;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+}  // namespace mgl
@@ -0,0 +1,389 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Performance HUD
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "./mglHud.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "./mglGLCounters.hpp"
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#elif defined(__linux__)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace mgl {
+
+/////////////////////////////////////////////////////////////////////////// FONT
+
+// 5x7 glyphs for ASCII 32 to 95, one byte per row with the leftmost pixel in
+// bit 4. Lowercase letters are drawn as uppercase.
+static const int FIRST_GLYPH = 32;
+static const int GLYPHS = 64;
+static const uint8_t FONT[GLYPHS][7] = {
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00},  // space
+    {0x04, 0x04, 0x04, 0x04, 0x04, 0x00, 0x04},  // !
+    {0x0A, 0x0A, 0x0A, 0x00, 0x00, 0x00, 0x00},  // "
+    {0x0A, 0x0A, 0x1F, 0x0A, 0x1F, 0x0A, 0x0A},  // #
+    {0x04, 0x0F, 0x14, 0x0E, 0x05, 0x1E, 0x04},  // $
+    {0x18, 0x19, 0x02, 0x04, 0x08, 0x13, 0x03},  // %
+    {0x0C, 0x12, 0x14, 0x08, 0x15, 0x12, 0x0D},  // &
+    {0x04, 0x04, 0x04, 0x00, 0x00, 0x00, 0x00},  // '
+    {0x02, 0x04, 0x08, 0x08, 0x08, 0x04, 0x02},  // (
+    {0x08, 0x04, 0x02, 0x02, 0x02, 0x04, 0x08},  // )
+    {0x00, 0x04, 0x15, 0x0E, 0x15, 0x04, 0x00},  // *
+    {0x00, 0x04, 0x04, 0x1F, 0x04, 0x04, 0x00},  // +
+    {0x00, 0x00, 0x00, 0x00, 0x0C, 0x04, 0x08},  // ,
+    {0x00, 0x00, 0x00, 0x1F, 0x00, 0x00, 0x00},  // -
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C},  // .
+    {0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x00},  // /
+    {0x0E, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0E},  // 0
+    {0x04, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x0E},  // 1
+    {0x0E, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1F},  // 2
+    {0x1F, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0E},  // 3
+    {0x02, 0x06, 0x0A, 0x12, 0x1F, 0x02, 0x02},  // 4
+    {0x1F, 0x10, 0x1E, 0x01, 0x01, 0x11, 0x0E},  // 5
+    {0x06, 0x08, 0x10, 0x1E, 0x11, 0x11, 0x0E},  // 6
+    {0x1F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08},  // 7
+    {0x0E, 0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E},  // 8
+    {0x0E, 0x11, 0x11, 0x0F, 0x01, 0x02, 0x0C},  // 9
+    {0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x0C, 0x00},  // :
+    {0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x04, 0x08},  // ;
+    {0x02, 0x04, 0x08, 0x10, 0x08, 0x04, 0x02},  // <
+    {0x00, 0x00, 0x1F, 0x00, 0x1F, 0x00, 0x00},  // =
+    {0x08, 0x04, 0x02, 0x01, 0x02, 0x04, 0x08},  // >
+    {0x0E, 0x11, 0x01, 0x02, 0x04, 0x00, 0x04},  // ?
+    {0x0E, 0x11, 0x01, 0x0D, 0x15, 0x15, 0x0E},  // @
+    {0x0E, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11},  // A
+    {0x1E, 0x11, 0x11, 0x1E, 0x11, 0x11, 0x1E},  // B
+    {0x0E, 0x11, 0x10, 0x10, 0x10, 0x11, 0x0E},  // C
+    {0x1C, 0x12, 0x11, 0x11, 0x11, 0x12, 0x1C},  // D
+    {0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x1F},  // E
+    {0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x10},  // F
+    {0x0E, 0x11, 0x10, 0x17, 0x11, 0x11, 0x0F},  // G
+    {0x11, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11},  // H
+    {0x0E, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0E},  // I
+    {0x07, 0x02, 0x02, 0x02, 0x02, 0x12, 0x0C},  // J
+    {0x11, 0x12, 0x14, 0x18, 0x14, 0x12, 0x11},  // K
+    {0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x1F},  // L
+    {0x11, 0x1B, 0x15, 0x15, 0x11, 0x11, 0x11},  // M
+    {0x11, 0x11, 0x19, 0x15, 0x13, 0x11, 0x11},  // N
+    {0x0E, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E},  // O
+    {0x1E, 0x11, 0x11, 0x1E, 0x10, 0x10, 0x10},  // P
+    {0x0E, 0x11, 0x11, 0x11, 0x15, 0x12, 0x0D},  // Q
+    {0x1E, 0x11, 0x11, 0x1E, 0x14, 0x12, 0x11},  // R
+    {0x0F, 0x10, 0x10, 0x0E, 0x01, 0x01, 0x1E},  // S
+    {0x1F, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04},  // T
+    {0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E},  // U
+    {0x11, 0x11, 0x11, 0x11, 0x11, 0x0A, 0x04},  // V
+    {0x11, 0x11, 0x11, 0x15, 0x15, 0x15, 0x0A},  // W
+    {0x11, 0x11, 0x0A, 0x04, 0x0A, 0x11, 0x11},  // X
+    {0x11, 0x11, 0x11, 0x0A, 0x04, 0x04, 0x04},  // Y
+    {0x1F, 0x01, 0x02, 0x04, 0x08, 0x10, 0x1F},  // Z
+    {0x0E, 0x08, 0x08, 0x08, 0x08, 0x08, 0x0E},  // [
+    {0x00, 0x10, 0x08, 0x04, 0x02, 0x01, 0x00},  // backslash
+    {0x0E, 0x02, 0x02, 0x02, 0x02, 0x02, 0x0E},  // ]
+    {0x04, 0x0A, 0x11, 0x00, 0x00, 0x00, 0x00},  // ^
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1F},  // _
+};
+
+// The atlas holds the glyphs in cells of 6x8 texels, 16 per row, followed by
+// a solid cell that the graph and the panel sample.
+static const int CELL_WIDTH = 6, CELL_HEIGHT = 8, CELLS_PER_ROW = 16;
+static const int ATLAS_WIDTH = CELL_WIDTH * CELLS_PER_ROW;
+static const int ATLAS_HEIGHT = CELL_HEIGHT * (GLYPHS / CELLS_PER_ROW + 1);
+static const int SOLID_CELL = GLYPHS;
+
+////////////////////////////////////////////////////////////////////////// STYLE
+
+static const float SCALE = 2.0f;  // screen pixels per texel
+static const float MARGIN = 8.0f, PADDING = 6.0f;
+static const float LINE_HEIGHT = CELL_HEIGHT * SCALE + 2.0f;
+static const float BAR_WIDTH = 2.0f;
+static const float GRAPH_WIDTH = BAR_WIDTH * Hud::GRAPH_SAMPLES;
+static const float GRAPH_HEIGHT = 60.0f;
+static const double GRAPH_RANGE = 100.0 / 3.0;  // milliseconds at the top
+static const double TARGET = 50.0 / 3.0;        // drawn as a line
+
+static const GLubyte PANEL[4] = {0, 0, 0, 160};
+static const GLubyte TEXT[4] = {255, 255, 255, 255};
+static const GLubyte GOOD[4] = {80, 220, 80, 255};
+static const GLubyte SLOW[4] = {240, 200, 40, 255};
+static const GLubyte BAD[4] = {240, 60, 40, 255};
+static const GLubyte LINE[4] = {255, 255, 255, 96};
+
+static const GLuint POSITION = 0, TEXCOORD = 1, COLOR = 2;
+
+static const char *VERTEX_SHADER = R"(#version 330 core
+in vec2 inPosition;
+in vec2 inTexcoord;
+in vec4 inColor;
+out vec2 exTexcoord;
+out vec4 exColor;
+uniform vec2 Viewport;
+void main(void) {
+  exTexcoord = inTexcoord;
+  exColor = inColor;
+  vec2 ndc = inPosition / Viewport * vec2(2.0, -2.0) + vec2(-1.0, 1.0);
+  gl_Position = vec4(ndc, 0.0, 1.0);
+}
+)";
+
+static const char *FRAGMENT_SHADER = R"(#version 330 core
+in vec2 exTexcoord;
+in vec4 exColor;
+out vec4 outColor;
+uniform sampler2D Atlas;
+void main(void) {
+  outColor = vec4(exColor.rgb, exColor.a * texture(Atlas, exTexcoord).r);
+}
+)";
+
+// Resident memory of the process; read with the text, not every frame, and
+// without streams, which would allocate.
+static double residentMegabytes() {
+#ifdef _WIN32
+  PROCESS_MEMORY_COUNTERS counters;
+  if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+    return counters.WorkingSetSize / 1048576.0;
+  }
+#elif defined(__linux__)
+  char statm[128];
+  const int fd = open("/proc/self/statm", O_RDONLY);
+  if (fd >= 0) {
+    const ssize_t length = read(fd, statm, sizeof(statm) - 1);
+    close(fd);
+    if (length > 0) {
+      statm[length] = '\0';
+      char *resident = nullptr;
+      std::strtol(statm, &resident, 10);  // total pages
+      return std::strtol(resident, nullptr, 10) *
+             static_cast<double>(sysconf(_SC_PAGESIZE)) / 1048576.0;
+    }
+  }
+#endif
+  return 0.0;
+}
+
+//////////////////////////////////////////////////////////////////////////// Hud
+
+Hud::Hud()
+    : Shaders(nullptr),
+      ViewportId(-1),
+      FrameTimes(),
+      NextFrame(0),
+      TextTime(0.0),
+      TextFrames(0.0),
+      TextMax(0.0) {
+  Text.reserve(6 * MAX_QUADS);
+  Vertices.reserve(6 * MAX_QUADS);
+  createAtlas();
+  createShaders();
+  createBuffers();
+}
+
+Hud::~Hud() {
+  delete Shaders;
+}
+
+void Hud::createAtlas() {
+  std::vector<GLubyte> texels(ATLAS_WIDTH * ATLAS_HEIGHT, 0);
+  for (int glyph = 0; glyph <= GLYPHS; glyph++) {
+    const int x0 = (glyph % CELLS_PER_ROW) * CELL_WIDTH;
+    const int y0 = (glyph / CELLS_PER_ROW) * CELL_HEIGHT;
+    for (int y = 0; y < CELL_HEIGHT; y++) {
+      for (int x = 0; x < CELL_WIDTH; x++) {
+        const bool set = glyph == SOLID_CELL ||
+                         (y < 7 && x < 5 && (FONT[glyph][y] >> (4 - x)) & 1);
+        texels[(y0 + y) * ATLAS_WIDTH + x0 + x] = set ? 255 : 0;
+      }
+    }
+  }
+  Texture = createTexture();
+  glBindTexture(GL_TEXTURE_2D, Texture.get());
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, ATLAS_WIDTH, ATLAS_HEIGHT, 0, GL_RED,
+               GL_UNSIGNED_BYTE, texels.data());
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void Hud::createShaders() {
+  Shaders = new ShaderProgram();
+  Shaders->addShader(GL_VERTEX_SHADER, "hud-vs", VERTEX_SHADER);
+  Shaders->addShader(GL_FRAGMENT_SHADER, "hud-fs", FRAGMENT_SHADER);
+  Shaders->addAttribute("inPosition", POSITION);
+  Shaders->addAttribute("inTexcoord", TEXCOORD);
+  Shaders->addAttribute("inColor", COLOR);
+  Shaders->addUniform("Viewport");
+  Shaders->create();
+  ViewportId = Shaders->Uniforms["Viewport"].index;
+}
+
+void Hud::createBuffers() {
+  Vao = createVertexArray();
+  glBindVertexArray(Vao.get());
+  {
+    Vbo = createBuffer();
+    glBindBuffer(GL_ARRAY_BUFFER, Vbo.get());
+    glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * 6 * MAX_QUADS, 0,
+                 GL_STREAM_DRAW);
+    glEnableVertexAttribArray(POSITION);
+    glVertexAttribPointer(POSITION, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex),
+                          reinterpret_cast<void *>(offsetof(Vertex, x)));
+    glEnableVertexAttribArray(TEXCOORD);
+    glVertexAttribPointer(TEXCOORD, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex),
+                          reinterpret_cast<void *>(offsetof(Vertex, u)));
+    glEnableVertexAttribArray(COLOR);
+    glVertexAttribPointer(COLOR, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Vertex),
+                          reinterpret_cast<void *>(offsetof(Vertex, color)));
+  }
+  glBindVertexArray(0);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void Hud::addQuad(std::vector<Vertex> &vertices, float x, float y, float w,
+                  float h, float u0, float v0, float u1, float v1,
+                  const GLubyte (&c)[4]) {
+  if (vertices.size() + 6 > 6 * MAX_QUADS) return;
+  const Vertex a = {x, y, u0, v0, {c[0], c[1], c[2], c[3]}};
+  const Vertex b = {x, y + h, u0, v1, {c[0], c[1], c[2], c[3]}};
+  const Vertex d = {x + w, y + h, u1, v1, {c[0], c[1], c[2], c[3]}};
+  const Vertex e = {x + w, y, u1, v0, {c[0], c[1], c[2], c[3]}};
+  vertices.insert(vertices.end(), {a, b, d, a, d, e});
+}
+
+void Hud::addSolid(std::vector<Vertex> &vertices, float x, float y, float w,
+                   float h, const GLubyte (&color)[4]) {
+  const float u =
+      (SOLID_CELL % CELLS_PER_ROW + 0.5f) * CELL_WIDTH / ATLAS_WIDTH;
+  const float v =
+      (SOLID_CELL / CELLS_PER_ROW + 0.5f) * CELL_HEIGHT / ATLAS_HEIGHT;
+  addQuad(vertices, x, y, w, h, u, v, u, v, color);
+}
+
+void Hud::addText(std::vector<Vertex> &vertices, float x, float y,
+                  const char *text) {
+  for (const char *c = text; *c; c++, x += CELL_WIDTH * SCALE) {
+    int glyph = *c >= 'a' && *c <= 'z' ? *c - 'a' + 'A' : *c;
+    if (glyph == ' ') continue;
+    glyph -= FIRST_GLYPH;
+    if (glyph < 0 || glyph >= GLYPHS) glyph = '?' - FIRST_GLYPH;
+    const float u0 = static_cast<float>(glyph % CELLS_PER_ROW * CELL_WIDTH);
+    const float v0 = static_cast<float>(glyph / CELLS_PER_ROW * CELL_HEIGHT);
+    addQuad(vertices, x, y, 5 * SCALE, 7 * SCALE, u0 / ATLAS_WIDTH,
+            v0 / ATLAS_HEIGHT, (u0 + 5) / ATLAS_WIDTH, (v0 + 7) / ATLAS_HEIGHT,
+            TEXT);
+  }
+}
+
+void Hud::buildText() {
+  char lines[3][64];
+  const double average = TextTime / TextFrames;
+  std::snprintf(lines[0], sizeof(lines[0]),
+                "frame %.2f ms  %.0f fps  max %.1f", average,
+                average > 0.0 ? 1000.0 / average : 0.0, TextMax);
+  GLCounters &counters = GLCounters::getInstance();
+  if (counters.isInstalled()) {
+    const GLCallCounts &frame = counters.getFrame();
+    std::snprintf(lines[1], sizeof(lines[1]),
+                  "draws %llu  tris %llu  up %.1f kb",
+                  static_cast<unsigned long long>(frame.calls[GL_CALL_DRAW]),
+                  static_cast<unsigned long long>(frame.triangles),
+                  frame.bytes / 1024.0);
+  } else {
+    std::snprintf(lines[1], sizeof(lines[1]), "draws -  (gl counters off)");
+  }
+  std::snprintf(lines[2], sizeof(lines[2]), "memory %.1f mb",
+                residentMegabytes());
+
+  std::size_t columns = 0;
+  for (const char *line : lines) columns = std::max(columns, std::strlen(line));
+  const float width =
+      std::max(GRAPH_WIDTH, columns * CELL_WIDTH * SCALE) + 2 * PADDING;
+  const float height = 3 * LINE_HEIGHT + GRAPH_HEIGHT + 3 * PADDING;
+  Text.clear();
+  addSolid(Text, MARGIN, MARGIN, width, height, PANEL);
+  for (int i = 0; i < 3; i++) {
+    addText(Text, MARGIN + PADDING, MARGIN + PADDING + i * LINE_HEIGHT,
+            lines[i]);
+  }
+}
+
+void Hud::addFrame(double milliseconds) {
+  FrameTimes[NextFrame] = milliseconds;
+  NextFrame = (NextFrame + 1) % GRAPH_SAMPLES;
+  TextTime += milliseconds;
+  TextFrames += 1.0;
+  TextMax = std::max(TextMax, milliseconds);
+  if (TextTime >= TEXT_INTERVAL || Text.empty()) {
+    buildText();
+    TextTime = TextFrames = TextMax = 0.0;
+  }
+}
+
+// Everything is drawn from one buffer in one call, blended over the frame
+// with depth testing and culling off; the state changed is restored after.
+void Hud::draw() {
+  Vertices.assign(Text.begin(), Text.end());
+  const float x0 = MARGIN + PADDING;
+  const float bottom = MARGIN + 2 * PADDING + 3 * LINE_HEIGHT + GRAPH_HEIGHT;
+  for (int i = 0; i < GRAPH_SAMPLES; i++) {
+    const double ms = FrameTimes[(NextFrame + i) % GRAPH_SAMPLES];
+    const float h = static_cast<float>(std::min(ms / GRAPH_RANGE, 1.0)) *
+                    GRAPH_HEIGHT;
+    addSolid(Vertices, x0 + i * BAR_WIDTH, bottom - h, BAR_WIDTH, h,
+             ms <= TARGET ? GOOD : ms <= GRAPH_RANGE ? SLOW : BAD);
+  }
+  addSolid(Vertices, x0,
+           bottom - static_cast<float>(TARGET / GRAPH_RANGE) * GRAPH_HEIGHT,
+           GRAPH_WIDTH, 1.0f, LINE);
+
+  GLint viewport[4];
+  glGetIntegerv(GL_VIEWPORT, viewport);
+  const GLboolean depth_test = glIsEnabled(GL_DEPTH_TEST);
+  const GLboolean cull_face = glIsEnabled(GL_CULL_FACE);
+  const GLboolean blend = glIsEnabled(GL_BLEND);
+  glDisable(GL_DEPTH_TEST);
+  glDisable(GL_CULL_FACE);
+  glEnable(GL_BLEND);
+  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+  Shaders->bind();
+  glUniform2f(ViewportId, static_cast<GLfloat>(viewport[2]),
+              static_cast<GLfloat>(viewport[3]));
+  glActiveTexture(GL_TEXTURE0);
+  glBindTexture(GL_TEXTURE_2D, Texture.get());
+  glBindVertexArray(Vao.get());
+  glBindBuffer(GL_ARRAY_BUFFER, Vbo.get());
+  // respecifying the store orphans the one the GPU may still be reading
+  glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * Vertices.size(),
+               Vertices.data(), GL_STREAM_DRAW);
+  glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(Vertices.size()));
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  glBindVertexArray(0);
+  glBindTexture(GL_TEXTURE_2D, 0);
+  Shaders->unbind();
+
+  if (!blend) glDisable(GL_BLEND);
+  if (cull_face) glEnable(GL_CULL_FACE);
+  if (depth_test) glEnable(GL_DEPTH_TEST);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+}  // namespace mgl
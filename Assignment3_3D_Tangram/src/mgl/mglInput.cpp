@@ -0,0 +1,143 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Input Recording and Replay
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "./mglInput.hpp"
+
+#include <cstring>
+#include <iterator>
+
+#include "./mglLog.hpp"
+
+namespace mgl {
+
+static const char INPUT_MAGIC[8] = {'M', 'G', 'L', 'I', 'N', 'P', 'U', 'T'};
+static const uint32_t INPUT_VERSION = 1;
+
+// Payload layout per event type: number of int32 and float64 fields.
+static const uint8_t INPUT_INTS[INPUT_EVENT_TYPES] = {0, 0, 2, 0, 4, 3, 0, 2};
+static const uint8_t INPUT_DOUBLES[INPUT_EVENT_TYPES] = {1, 0, 0, 2,
+                                                         0, 0, 2, 0};
+
+////////////////////////////////////////////////////////////////// InputRecorder
+
+bool InputRecorder::open(const std::string &filename) {
+  File.open(filename, std::ios::binary | std::ios::trunc);
+  if (!File) {
+    MGL_LOG_ERROR("Cannot write " << filename);
+    return false;
+  }
+  File.write(INPUT_MAGIC, sizeof(INPUT_MAGIC));
+  File.write(reinterpret_cast<const char *>(&INPUT_VERSION),
+             sizeof(INPUT_VERSION));
+  return true;
+}
+
+void InputRecorder::record(const InputEvent &event) {
+  if (!File.is_open()) return;
+  const uint8_t type = event.type;
+  File.write(reinterpret_cast<const char *>(&type), sizeof(type));
+  File.write(reinterpret_cast<const char *>(&event.frame), sizeof(event.frame));
+  File.write(reinterpret_cast<const char *>(&event.time), sizeof(event.time));
+  File.write(reinterpret_cast<const char *>(event.i),
+             INPUT_INTS[type] * sizeof(int32_t));
+  File.write(reinterpret_cast<const char *>(event.d),
+             INPUT_DOUBLES[type] * sizeof(double));
+}
+
+void InputRecorder::close() {
+  if (File.is_open()) File.close();
+}
+
+////////////////////////////////////////////////////////////////// InputReplayer
+
+bool InputReplayer::open(const std::string &filename) {
+  std::ifstream ifile(filename, std::ios::binary);
+  const std::vector<char> data((std::istreambuf_iterator<char>(ifile)),
+                               std::istreambuf_iterator<char>());
+  const std::size_t header = sizeof(INPUT_MAGIC) + sizeof(INPUT_VERSION);
+  uint32_t version = 0;
+  if (data.size() >= header) {
+    std::memcpy(&version, data.data() + sizeof(INPUT_MAGIC), sizeof(version));
+  }
+  if (data.size() < header ||
+      std::memcmp(data.data(), INPUT_MAGIC, sizeof(INPUT_MAGIC)) != 0 ||
+      version != INPUT_VERSION) {
+    MGL_LOG_ERROR(filename << " is not an input log");
+    return false;
+  }
+
+  Events.clear();
+  Next = 0;
+  const std::size_t fixed = 1 + sizeof(uint32_t) + sizeof(double);
+  for (std::size_t p = header; p < data.size();) {
+    InputEvent event = {};
+    const uint8_t type = static_cast<uint8_t>(data[p]);
+    if (type >= INPUT_EVENT_TYPES) break;
+    const std::size_t ints = INPUT_INTS[type] * sizeof(int32_t);
+    const std::size_t doubles = INPUT_DOUBLES[type] * sizeof(double);
+    if (p + fixed + ints + doubles > data.size()) break;
+    event.type = static_cast<InputEventType>(type);
+    std::memcpy(&event.frame, &data[p + 1], sizeof(event.frame));
+    std::memcpy(&event.time, &data[p + 1 + sizeof(uint32_t)],
+                sizeof(event.time));
+    std::memcpy(event.i, &data[p + fixed], ints);
+    std::memcpy(event.d, &data[p + fixed + ints], doubles);
+    Events.push_back(event);
+    p += fixed + ints + doubles;
+  }
+  return true;
+}
+
+bool InputReplayer::next(uint32_t frame, InputEvent &event) {
+  if (Next == Events.size() || Events[Next].frame != frame) return false;
+  event = Events[Next++];
+  return true;
+}
+
+uint32_t InputReplayer::getFrameCount() {
+  uint32_t frames = 0;
+  for (const InputEvent &event : Events) {
+    if (event.type == INPUT_FRAME) frames++;
+  }
+  return frames;
+}
+
+bool InputReplayer::isDone() { return Next == Events.size(); }
+
+///////////////////////////////////////////////////////////////////// InputQueue
+
+bool InputQueue::push(const InputEvent &event) {
+  const uint32_t tail = Tail.load(std::memory_order_relaxed);
+  if (tail - Head.load(std::memory_order_acquire) == CAPACITY) {
+    Dropped.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  Events[tail % CAPACITY] = event;
+  Tail.store(tail + 1, std::memory_order_release);
+  return true;
+}
+
+bool InputQueue::pop(InputEvent &event) {
+  const uint32_t head = Head.load(std::memory_order_relaxed);
+  if (head == Tail.load(std::memory_order_acquire)) return false;
+  event = Events[head % CAPACITY];
+  Head.store(head + 1, std::memory_order_release);
+  if (Oldest < 0.0) Oldest = event.time;
+  return true;
+}
+
+double InputQueue::takeOldest() {
+  const double oldest = Oldest;
+  Oldest = -1.0;
+  return oldest;
+}
+
+uint32_t InputQueue::getDropped() {
+  return Dropped.load(std::memory_order_relaxed);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+}  // namespace mgl
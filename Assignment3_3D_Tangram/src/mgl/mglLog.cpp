@@ -0,0 +1,148 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Asynchronous Logging
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "./mglLog.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+namespace mgl {
+
+//////////////////////////////////////////////////////////////////////// LogSite
+
+bool LogSite::allow() {
+  const int64_t now = std::chrono::duration_cast<std::chrono::milliseconds>(
+                          std::chrono::steady_clock::now().time_since_epoch())
+                          .count();
+  int64_t start = WindowStart.load(std::memory_order_relaxed);
+  if (now - start >= 1000 &&
+      WindowStart.compare_exchange_strong(start, now,
+                                          std::memory_order_relaxed)) {
+    Count.store(0, std::memory_order_relaxed);
+  }
+  if (Count.fetch_add(1, std::memory_order_relaxed) < RATE_LIMIT) return true;
+  Suppressed.fetch_add(1, std::memory_order_relaxed);
+  return false;
+}
+
+uint32_t LogSite::takeSuppressed() {
+  return Suppressed.exchange(0, std::memory_order_relaxed);
+}
+
+/////////////////////////////////////////////////////////////////////// LogQueue
+
+bool LogQueue::push(Entry &entry) {
+  const uint32_t tail = Tail.load(std::memory_order_relaxed);
+  if (tail - Head.load(std::memory_order_acquire) == CAPACITY) return false;
+  Entry &slot = Entries[tail % CAPACITY];
+  slot.sequence = entry.sequence;
+  slot.level = entry.level;
+  slot.text.swap(entry.text);
+  Tail.store(tail + 1, std::memory_order_release);
+  return true;
+}
+
+bool LogQueue::pop(Entry &entry) {
+  const uint32_t head = Head.load(std::memory_order_relaxed);
+  if (head == Tail.load(std::memory_order_acquire)) return false;
+  Entry &slot = Entries[head % CAPACITY];
+  entry.sequence = slot.sequence;
+  entry.level = slot.level;
+  entry.text.swap(slot.text);
+  Head.store(head + 1, std::memory_order_release);
+  return true;
+}
+
+///////////////////////////////////////////////////////////////////////// Logger
+
+// Never destroyed, so that static destructors may still log; the atexit
+// handler stops the writer and from then on messages are written directly.
+Logger &Logger::getInstance() {
+  static Logger *instance = new Logger();
+  return *instance;
+}
+
+Logger::Logger() {
+  Writer = std::thread(&Logger::run, this);
+  std::atexit(stop);
+}
+
+void Logger::stop() {
+  Logger &logger = getInstance();
+  logger.Stopping = true;
+  if (logger.Writer.joinable()) logger.Writer.join();
+  logger.drain();
+  logger.Stopped = true;
+}
+
+LogQueue &Logger::getQueue() {
+  thread_local LogQueue *queue = nullptr;
+  if (!queue) {
+    std::lock_guard<std::mutex> lock(QueuesMutex);
+    Queues.push_back(std::make_unique<LogQueue>());
+    queue = Queues.back().get();
+  }
+  return *queue;
+}
+
+void Logger::write(LogLevel level, LogSite &site, std::string text) {
+  const uint32_t suppressed = site.takeSuppressed();
+  if (suppressed) {
+    text += " (" + std::to_string(suppressed) + " similar suppressed)";
+  }
+  if (Stopped) {
+    std::lock_guard<std::mutex> lock(DrainMutex);
+    print(level, text);
+    std::cerr.flush();
+    return;
+  }
+  LogQueue::Entry entry = {Sequence++, level, std::move(text)};
+  if (!getQueue().push(entry)) Dropped++;
+}
+
+void Logger::flush() { drain(); }
+
+void Logger::run() {
+  while (!Stopping) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    drain();
+  }
+}
+
+// Pops every queue and prints the lot in the order it was logged, with a
+// single flush.
+void Logger::drain() {
+  std::lock_guard<std::mutex> lock(DrainMutex);
+  {
+    std::lock_guard<std::mutex> queues_lock(QueuesMutex);
+    LogQueue::Entry entry;
+    for (std::unique_ptr<LogQueue> &queue : Queues) {
+      while (queue->pop(entry)) Batch.push_back(std::move(entry));
+    }
+  }
+  const uint32_t dropped = Dropped.exchange(0);
+  if (Batch.empty() && !dropped) return;
+  std::sort(Batch.begin(), Batch.end(),
+            [](const LogQueue::Entry &a, const LogQueue::Entry &b) {
+              return a.sequence < b.sequence;
+            });
+  for (const LogQueue::Entry &entry : Batch) print(entry.level, entry.text);
+  if (dropped) {
+    print(LOG_WARNING, std::to_string(dropped) + " log message(s) dropped");
+  }
+  std::cerr.flush();
+  Batch.clear();
+}
+
+void Logger::print(LogLevel level, const std::string &text) {
+  static const char *prefixes[] = {"", "", "WARNING: ", "ERROR: "};
+  std::cerr << prefixes[level] << text << '\n';
+}
+
+////////////////////////////////////////////////////////////////////////////////
+}  // namespace mgl
@@ -0,0 +1,159 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Memory Accounting
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "./mglMemory.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+
+#include "./mglLog.hpp"
+
+namespace mgl {
+
+////////////////////////////////////////////////////////////////// MemoryAccount
+
+MemoryAccount::MemoryAccount(MemoryKind kind)
+    : Id(MemoryRegistry::getInstance().add(kind)) {}
+
+MemoryAccount::~MemoryAccount() { MemoryRegistry::getInstance().remove(Id); }
+
+void MemoryAccount::setName(const std::string &name) {
+  MemoryRegistry::getInstance().change(Id,
+                                       [&](MemoryUsage &u) { u.name = name; });
+}
+
+void MemoryAccount::setCpu(uint64_t bytes) {
+  MemoryRegistry::getInstance().change(Id,
+                                       [=](MemoryUsage &u) { u.cpu = bytes; });
+}
+
+void MemoryAccount::setGpu(uint64_t bytes) {
+  MemoryRegistry::getInstance().change(Id,
+                                       [=](MemoryUsage &u) { u.gpu = bytes; });
+}
+
+///////////////////////////////////////////////////////////////// MemoryRegistry
+
+MemoryRegistry::MemoryRegistry() : NextId(0), CpuBudget(0), GpuBudget(0) {}
+
+MemoryRegistry &MemoryRegistry::getInstance() {
+  static MemoryRegistry instance;
+  return instance;
+}
+
+const char *MemoryRegistry::getKindName(MemoryKind kind) {
+  static const char *names[MEMORY_KINDS] = {"mesh", "program", "camera"};
+  return names[kind];
+}
+
+uint32_t MemoryRegistry::add(MemoryKind kind) {
+  std::lock_guard<std::mutex> lock(Mutex);
+  const uint32_t id = NextId++;
+  Accounts[id].kind = kind;
+  return id;
+}
+
+void MemoryRegistry::remove(uint32_t id) {
+  std::lock_guard<std::mutex> lock(Mutex);
+  Accounts.erase(id);
+}
+
+template <typename F>
+void MemoryRegistry::change(uint32_t id, F f) {
+  std::lock_guard<std::mutex> lock(Mutex);
+  auto i = Accounts.find(id);
+  if (i != Accounts.end()) f(i->second);
+}
+
+std::vector<MemoryUsage> MemoryRegistry::getUsage() {
+  std::vector<MemoryUsage> usage;
+  {
+    std::lock_guard<std::mutex> lock(Mutex);
+    usage.reserve(Accounts.size());
+    for (const auto &i : Accounts) usage.push_back(i.second);
+  }
+  std::stable_sort(usage.begin(), usage.end(),
+                   [](const MemoryUsage &a, const MemoryUsage &b) {
+                     return a.cpu + a.gpu > b.cpu + b.gpu;
+                   });
+  return usage;
+}
+
+MemoryUsage MemoryRegistry::getTotal() {
+  MemoryUsage total;
+  total.kind = MEMORY_KINDS;
+  std::lock_guard<std::mutex> lock(Mutex);
+  for (const auto &i : Accounts) {
+    total.cpu += i.second.cpu;
+    total.gpu += i.second.gpu;
+  }
+  return total;
+}
+
+MemoryUsage MemoryRegistry::getTotal(MemoryKind kind) {
+  MemoryUsage total;
+  total.kind = kind;
+  total.name = getKindName(kind);
+  std::lock_guard<std::mutex> lock(Mutex);
+  for (const auto &i : Accounts) {
+    if (i.second.kind != kind) continue;
+    total.cpu += i.second.cpu;
+    total.gpu += i.second.gpu;
+  }
+  return total;
+}
+
+void MemoryRegistry::setBudget(uint64_t cpu, uint64_t gpu) {
+  CpuBudget = cpu;
+  GpuBudget = gpu;
+}
+
+bool MemoryRegistry::checkBudget() {
+  const MemoryUsage total = getTotal();
+  bool ok = true;
+  if (CpuBudget && total.cpu > CpuBudget) {
+    MGL_LOG_ERROR("CPU memory " << total.cpu << " bytes exceeds budget of "
+                  << CpuBudget << " bytes");
+    ok = false;
+  }
+  if (GpuBudget && total.gpu > GpuBudget) {
+    MGL_LOG_ERROR("GPU memory " << total.gpu << " bytes exceeds budget of "
+                  << GpuBudget << " bytes");
+    ok = false;
+  }
+  return ok;
+}
+
+void MemoryRegistry::dump(std::ostream &os) {
+  const std::ios::fmtflags flags = os.flags();
+  os << std::left << std::setw(8) << "KIND" << std::setw(40) << "NAME"
+     << std::right << std::setw(12) << "CPU" << std::setw(12) << "GPU"
+     << std::endl;
+  for (const MemoryUsage &u : getUsage()) {
+    os << std::left << std::setw(8) << getKindName(u.kind) << std::setw(40)
+       << (u.name.empty() ? "-" : u.name) << std::right << std::setw(12)
+       << u.cpu << std::setw(12) << u.gpu << std::endl;
+  }
+  for (int kind = 0; kind < MEMORY_KINDS; kind++) {
+    const MemoryUsage t = getTotal(static_cast<MemoryKind>(kind));
+    os << std::left << std::setw(48) << std::string("total ") + t.name
+       << std::right << std::setw(12) << t.cpu << std::setw(12) << t.gpu
+       << std::endl;
+  }
+  const MemoryUsage total = getTotal();
+  os << std::left << std::setw(48) << "total" << std::right << std::setw(12)
+     << total.cpu << std::setw(12) << total.gpu << std::endl;
+  if (CpuBudget || GpuBudget) {
+    os << std::left << std::setw(48) << "budget" << std::right
+       << std::setw(12) << CpuBudget << std::setw(12) << GpuBudget
+       << std::endl;
+  }
+  os.flags(flags);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+}  // namespace mgl
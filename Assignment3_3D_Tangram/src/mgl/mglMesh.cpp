@@ -8,19 +8,39 @@
 
 #include "./mglMesh.hpp"
 
+#include "./mglLog.hpp"
+
 namespace mgl {
 
 ////////////////////////////////////////////////////////////////////////////////
 
-Mesh::Mesh() {
+MeshRetention Mesh::DefaultRetention = RETAIN_ALL;
+
+Mesh::Mesh() : Memory(MEMORY_MESH) {
+  Retention = DefaultRetention;
   NormalsLoaded = false;
   TexcoordsLoaded = false;
   TangentsAndBitangentsLoaded = false;
-  VaoId = -1;
+  NormalsUploaded = false;
+  TexcoordsUploaded = false;
+  TangentsAndBitangentsUploaded = false;
   AssimpFlags = aiProcess_Triangulate;
 }
 
-Mesh::~Mesh() { destroyBufferObjects(); }
+Mesh::~Mesh() {
+  if (isUploaded()) destroyBufferObjects();
+}
+
+void Mesh::setDefaultRetention(MeshRetention retention) {
+  DefaultRetention = retention;
+}
+
+void Mesh::setRetention(MeshRetention retention) {
+  Retention = retention;
+  if (isUploaded()) applyRetention();
+}
+
+void Mesh::setName(const std::string &name) { Memory.setName(name); }
 
 void Mesh::setAssimpFlags(unsigned int flags) { AssimpFlags = flags; }
 
@@ -42,11 +62,18 @@ void Mesh::calculateTangentSpace() {
 
 void Mesh::flipUVs() { AssimpFlags |= aiProcess_FlipUVs; }
 
-bool Mesh::hasNormals() { return NormalsLoaded; }
+// Loaded or uploaded, as the retention may have released them since.
+bool Mesh::hasNormals() { return NormalsLoaded || NormalsUploaded; }
 
-bool Mesh::hasTexcoords() { return TexcoordsLoaded; }
+bool Mesh::hasTexcoords() { return TexcoordsLoaded || TexcoordsUploaded; }
 
-bool Mesh::hasTangentsAndBitangents() { return TangentsAndBitangentsLoaded; }
+bool Mesh::hasTangentsAndBitangents() {
+  return TangentsAndBitangentsLoaded || TangentsAndBitangentsUploaded;
+}
+
+const std::vector<glm::vec3> &Mesh::getPositions() { return Positions; }
+
+const std::vector<unsigned int> &Mesh::getIndices() { return Indices; }
 
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -105,6 +132,7 @@ void Mesh::processScene(const aiScene *scene) {
   for (unsigned int i = 0; i < Meshes.size(); i++) {
     processMesh(scene->mMeshes[i]);
   }
+  updateMemory();
 
 #ifdef DEBUG
   std::cout << "Loaded " << Meshes.size() << " mesh(es) [" << n_vertices
@@ -113,9 +141,8 @@ void Mesh::processScene(const aiScene *scene) {
 #endif
 }
 
-void Mesh::create(const std::string &filename) {
-  Assimp::Importer importer;
-  const aiScene *scene = importer.ReadFile(filename, AssimpFlags);
+void Mesh::processImport(Assimp::Importer &importer, const aiScene *scene,
+                         const std::string &name) {
   if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE ||
       !scene->mRootNode) {
     std::cout << "Error while loading:" << importer.GetErrorString()
@@ -124,18 +151,138 @@ void Mesh::create(const std::string &filename) {
   }
 
 #ifdef DEBUG
-  std::cout << "Processing [" << filename << "]" << std::endl;
+  std::cout << "Processing [" << name << "]" << std::endl;
 #endif
 
+  Memory.setName(name);
+  processScene(scene);
+}
+
+void Mesh::load(const std::string &filename) {
+  Assimp::Importer importer;
+  const aiScene *scene = importer.ReadFile(filename, AssimpFlags);
+  processImport(importer, scene, filename);
+}
+
+// The hint is the file extension (e.g. "obj") that selects the importer.
+void Mesh::load(const void *data, std::size_t size, const std::string &hint) {
+  Assimp::Importer importer;
+  const aiScene *scene =
+      importer.ReadFileFromMemory(data, size, AssimpFlags, hint.c_str());
+  processImport(importer, scene, "<memory>." + hint);
+}
+
+void Mesh::load(const aiScene *scene) {
+  Memory.setName("scene");
   processScene(scene);
+}
+
+void Mesh::load(const float (*positions)[3], const float (*normals)[3],
+                unsigned int n_vertices, const unsigned int *indices,
+                unsigned int n_indices) {
+  NormalsLoaded = normals != nullptr;
+  TexcoordsLoaded = false;
+  TangentsAndBitangentsLoaded = false;
+
+  Meshes.resize(1);
+  Meshes[0].nIndices = n_indices;
+  Positions.reserve(n_vertices);
+  Normals.reserve(NormalsLoaded ? n_vertices : 0);
+  for (unsigned int i = 0; i < n_vertices; i++) {
+    Positions.push_back(
+        glm::vec3(positions[i][0], positions[i][1], positions[i][2]));
+    if (NormalsLoaded) {
+      Normals.push_back(glm::vec3(normals[i][0], normals[i][1], normals[i][2]));
+    }
+  }
+  Indices.assign(indices, indices + n_indices);
+  Memory.setName("geometry");
+  updateMemory();
+
+#ifdef DEBUG
+  std::cout << "Loaded 1 mesh(es) from memory [" << n_vertices << " vertices, "
+            << n_indices << " indices, " << n_indices / 3 << " triangles]"
+            << std::endl;
+#endif
+}
+
+void Mesh::upload() {
+  if (isUploaded()) return;
+  if (Positions.empty() || Indices.empty()) {
+    MGL_LOG_ERROR("Cannot upload mesh, its geometry was not loaded or has "
+                  "been released.");
+    return;
+  }
   createBufferObjects();
 }
 
+// Swapping with an empty vector is what actually releases the memory.
+template <typename T>
+static void release(std::vector<T> &v) {
+  std::vector<T>().swap(v);
+}
+
+void Mesh::applyRetention() {
+  if (Retention != RETAIN_ALL) {
+    release(Normals);
+    release(Texcoords);
+    release(Tangents);
+#ifdef CREATE_BITANGENT
+    release(Bitangents);
+#endif
+    NormalsLoaded = false;
+    TexcoordsLoaded = false;
+    TangentsAndBitangentsLoaded = false;
+  }
+  if (Retention == RETAIN_NONE) {
+    release(Positions);
+    release(Indices);
+  }
+  updateMemory();
+}
+
+template <typename T>
+static uint64_t capacityBytes(const std::vector<T> &v) {
+  return sizeof(T) * v.capacity();
+}
+
+void Mesh::updateMemory() {
+  uint64_t bytes = sizeof(Mesh) + capacityBytes(Meshes) +
+                   capacityBytes(Positions) + capacityBytes(Normals) +
+                   capacityBytes(Texcoords) + capacityBytes(Tangents) +
+                   capacityBytes(Indices);
+#ifdef CREATE_BITANGENT
+  bytes += capacityBytes(Bitangents);
+#endif
+  Memory.setCpu(bytes);
+}
+
+bool Mesh::isUploaded() { return static_cast<bool>(Vao); }
+
+void Mesh::create(const std::string &filename) {
+  load(filename);
+  upload();
+}
+
+void Mesh::create(const void *data, std::size_t size, const std::string &hint) {
+  load(data, size, hint);
+  upload();
+}
+
+void Mesh::create(const float (*positions)[3], const float (*normals)[3],
+                  unsigned int n_vertices, const unsigned int *indices,
+                  unsigned int n_indices) {
+  load(positions, normals, n_vertices, indices, n_indices);
+  upload();
+}
+
 void Mesh::createBufferObjects() {
   GLuint boId[6];
+  uint64_t gpu_bytes = sizeof(Positions[0]) * Positions.size() +
+                       sizeof(Indices[0]) * Indices.size();
 
-  glGenVertexArrays(1, &VaoId);
-  glBindVertexArray(VaoId);
+  Vao = createVertexArray();
+  glBindVertexArray(Vao.get());
   {
     glGenBuffers(6, boId);
 
@@ -151,6 +298,7 @@ void Mesh::createBufferObjects() {
                    &Normals[0], GL_STATIC_DRAW);
       glEnableVertexAttribArray(NORMAL);
       glVertexAttribPointer(NORMAL, 3, GL_FLOAT, GL_FALSE, 0, 0);
+      gpu_bytes += sizeof(Normals[0]) * Normals.size();
     }
 
     if (TexcoordsLoaded) {
@@ -159,6 +307,7 @@ void Mesh::createBufferObjects() {
                    &Texcoords[0], GL_STATIC_DRAW);
       glEnableVertexAttribArray(TEXCOORD);
       glVertexAttribPointer(TEXCOORD, 2, GL_FLOAT, GL_FALSE, 0, 0);
+      gpu_bytes += sizeof(Texcoords[0]) * Texcoords.size();
     }
 
     if (TangentsAndBitangentsLoaded) {
@@ -167,6 +316,7 @@ void Mesh::createBufferObjects() {
                    &Tangents[0], GL_STATIC_DRAW);
       glEnableVertexAttribArray(TANGENT);
       glVertexAttribPointer(TANGENT, 3, GL_FLOAT, GL_FALSE, 0, 0);
+      gpu_bytes += sizeof(Tangents[0]) * Tangents.size();
 
 #ifdef CREATE_BITANGENT
       glBindBuffer(GL_ARRAY_BUFFER, boId[BITANGENT]);
@@ -174,6 +324,7 @@ void Mesh::createBufferObjects() {
                    &Bitangents[0], GL_STATIC_DRAW);
       glEnableVertexAttribArray(BITANGENT);
       glVertexAttribPointer(BITANGENT, 3, GL_FLOAT, GL_FALSE, 0, 0);
+      gpu_bytes += sizeof(Bitangents[0]) * Bitangents.size();
 #endif
     }
 
@@ -184,23 +335,22 @@ void Mesh::createBufferObjects() {
   glBindVertexArray(0);
   glBindBuffer(GL_ARRAY_BUFFER, 0);
   glDeleteBuffers(6, boId);
+  Memory.setGpu(gpu_bytes);
+  NormalsUploaded = NormalsLoaded;
+  TexcoordsUploaded = TexcoordsLoaded;
+  TangentsAndBitangentsUploaded = TangentsAndBitangentsLoaded;
+  applyRetention();
 }
 
+// The vertex array, and with it the buffers it holds, is only deleted once
+// the frames that may still draw it are done.
 void Mesh::destroyBufferObjects() {
-  glBindVertexArray(VaoId);
-  glDisableVertexAttribArray(POSITION);
-  glDisableVertexAttribArray(NORMAL);
-  glDisableVertexAttribArray(TEXCOORD);
-  glDisableVertexAttribArray(TANGENT);
-#ifdef CREATE_BITANGENT
-  glDisableVertexAttribArray(BITANGENT);
-#endif
-  glDeleteVertexArrays(1, &VaoId);
-  glBindVertexArray(0);
+  Vao.reset();
+  Memory.setGpu(0);
 }
 
 void Mesh::draw() {
-  glBindVertexArray(VaoId);
+  glBindVertexArray(Vao.get());
   for (MeshData &mesh : Meshes) {
     glDrawElementsBaseVertex(
         GL_TRIANGLES, mesh.nIndices, GL_UNSIGNED_INT,
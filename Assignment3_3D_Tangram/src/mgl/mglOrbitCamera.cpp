@@ -44,7 +44,8 @@ namespace mgl {
         setProjectionMatrix(projections[projectionId]);
     }
 
-    void OrbitCamera::update() {
+    bool OrbitCamera::update() {
+        const bool moved = deltaX != 0.0f || deltaY != 0.0f || deltaScroll != 0.0f;
 
         d += deltaScroll;
         d = d < minZoom ? minZoom : d > maxZoom ? maxZoom : d;
@@ -55,11 +56,11 @@ namespace mgl {
         q = qX * qY * q;
 
         Camera::setViewMatrix(glm::translate(T) * glm::toMat4(q));
-        setProjectionMatrix(getProjectionMatrix());
 
         deltaScroll = 0.0f;
         deltaX = 0.0f;
         deltaY = 0.0f;
+        return moved;
     }
 
     void OrbitCamera::cursor(double xpos, double ypos) {
@@ -78,9 +79,18 @@ namespace mgl {
         //std::cout << "button: " << button << " " << action << std::endl;
         //std::cout << "camera(" << name << ")" << std::endl;
 
+        // the Engine's cursor position, rather than the window's, so that
+        // replayed input behaves exactly as recorded
+        double xpos, ypos;
+        Engine::getInstance().getCursorPos(&xpos, &ypos);
+        mouseButton(button, action, xpos, ypos);
+    }
+
+    void OrbitCamera::mouseButton(int button, int action, double xpos, double ypos) {
         leftClick = button == GLFW_MOUSE_BUTTON_1 && action == GLFW_PRESS;
         if (leftClick) {
-            glfwGetCursorPos(win, &prevXpos, &prevYpos);
+            prevXpos = xpos;
+            prevYpos = ypos;
         }
     }
 
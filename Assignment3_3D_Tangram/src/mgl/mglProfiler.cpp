@@ -0,0 +1,229 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Frame Profiler
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "./mglProfiler.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+#include "./mglLog.hpp"
+
+namespace mgl {
+
+static thread_local void *LocalBuffer = nullptr;
+static thread_local uint32_t LocalDepth = 0;
+
+static int64_t steadyNanoseconds() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+/////////////////////////////////////////////////////////////////////// Profiler
+
+Profiler::Profiler()
+    : Epoch(steadyNanoseconds()),
+      Gpu(nullptr),
+      GpuFrameIndex(0),
+      GpuDepth(0),
+      GpuReady(false),
+      GpuOffset(0),
+      DroppedGpuFrames(0) {}
+
+Profiler &Profiler::getInstance() {
+  static Profiler instance;
+  return instance;
+}
+
+int64_t Profiler::now() { return steadyNanoseconds() - Epoch; }
+
+Profiler::ThreadBuffer *Profiler::createBuffer(const char *name) {
+  std::lock_guard<std::mutex> lock(BuffersMutex);
+  Buffers.push_back(std::make_unique<ThreadBuffer>());
+  ThreadBuffer *buffer = Buffers.back().get();
+  buffer->id = static_cast<uint32_t>(Buffers.size());
+  buffer->name = name;
+  buffer->events = std::make_unique<ProfileEvent[]>(EVENTS_PER_THREAD);
+  return buffer;
+}
+
+Profiler::ThreadBuffer &Profiler::getBuffer() {
+  if (!LocalBuffer) {
+    LocalBuffer = createBuffer("Thread");
+  }
+  return *static_cast<ThreadBuffer *>(LocalBuffer);
+}
+
+void Profiler::setThreadName(const char *name) {
+  ThreadBuffer &buffer = getBuffer();
+  std::lock_guard<std::mutex> lock(BuffersMutex);
+  buffer.name = name;
+}
+
+// Only the owning thread writes to a buffer; the release store publishes the
+// event to exportTrace() on whichever thread calls it.
+void Profiler::push(ThreadBuffer &buffer, const ProfileEvent &event) {
+  const uint64_t count = buffer.count.load(std::memory_order_relaxed);
+  buffer.events[count % EVENTS_PER_THREAD] = event;
+  buffer.count.store(count + 1, std::memory_order_release);
+}
+
+uint32_t Profiler::enter() { return LocalDepth++; }
+
+void Profiler::leave() { LocalDepth--; }
+
+void Profiler::record(const char *name, int64_t start, uint32_t depth,
+                      uint32_t allocations, uint64_t bytes) {
+  push(getBuffer(), {name, start, now() - start, depth, allocations, bytes});
+}
+
+//////////////////////////////////////////////////////////////////////////// GPU
+
+// Timestamps are converted to the CPU clock with an offset measured once;
+// drift over the length of a profiling session is well below a microsecond.
+void Profiler::beginFrame() {
+  if (!GpuReady) {
+    for (GpuFrame &frame : GpuFrames) {
+      glGenQueries(2 * GPU_SCOPES, frame.queries);
+    }
+    GLint64 gpu_time = 0;
+    glGetInteger64v(GL_TIMESTAMP, &gpu_time);
+    GpuOffset = now() - gpu_time;
+    Gpu = createBuffer("GPU");
+    GpuReady = true;
+  }
+  GpuFrameIndex = (GpuFrameIndex + 1) % GPU_FRAMES;
+  GpuFrame &frame = GpuFrames[GpuFrameIndex];
+  if (frame.count > 0 && !collect(frame, false)) {
+    DroppedGpuFrames++;
+  }
+  frame.count = 0;
+}
+
+int Profiler::beginGpu(const char *name) {
+  if (!GpuReady) return -1;
+  GpuFrame &frame = GpuFrames[GpuFrameIndex];
+  if (frame.count == GPU_SCOPES) return -1;
+  const int scope = frame.count++;
+  frame.scopes[scope] = {name, 0, 0, GpuDepth++, 0, 0};
+  glQueryCounter(frame.queries[2 * scope], GL_TIMESTAMP);
+  return scope;
+}
+
+void Profiler::endGpu(int scope) {
+  if (scope < 0) return;
+  GpuDepth--;
+  glQueryCounter(GpuFrames[GpuFrameIndex].queries[2 * scope + 1],
+                 GL_TIMESTAMP);
+}
+
+// Timestamp queries complete in submission order, so once the last end query
+// of a frame is available all of its results are.
+bool Profiler::collect(GpuFrame &frame, bool wait) {
+  GLint available = GL_FALSE;
+  if (!wait) {
+    glGetQueryObjectiv(frame.queries[2 * frame.count - 1],
+                       GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available) return false;
+  }
+  for (int i = 0; i < frame.count; i++) {
+    GLuint64 begin = 0, end = 0;
+    glGetQueryObjectui64v(frame.queries[2 * i], GL_QUERY_RESULT, &begin);
+    glGetQueryObjectui64v(frame.queries[2 * i + 1], GL_QUERY_RESULT, &end);
+    ProfileEvent event = frame.scopes[i];
+    event.start = static_cast<int64_t>(begin) + GpuOffset;
+    event.duration = static_cast<int64_t>(end - begin);
+    push(*Gpu, event);
+  }
+  return true;
+}
+
+void Profiler::flush() {
+  if (!GpuReady) return;
+  for (int i = 1; i <= GPU_FRAMES; i++) {
+    GpuFrame &frame = GpuFrames[(GpuFrameIndex + i) % GPU_FRAMES];
+    if (frame.count > 0) collect(frame, true);
+    frame.count = 0;
+    glDeleteQueries(2 * GPU_SCOPES, frame.queries);
+  }
+  GpuReady = false;
+}
+
+uint64_t Profiler::getDroppedGpuFrames() { return DroppedGpuFrames; }
+
+///////////////////////////////////////////////////////////////////////// EXPORT
+
+static void writeJsonString(std::ostream &os, const std::string &s) {
+  os << '"';
+  for (char c : s) {
+    if (c == '"' || c == '\\') {
+      os << '\\' << c;
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      os << ' ';
+    } else {
+      os << c;
+    }
+  }
+  os << '"';
+}
+
+// Events are copied out before the count is read again, so that any a thread
+// overwrote in the meantime can be discarded instead of exported torn.
+bool Profiler::exportTrace(const std::string &filename) {
+  std::ofstream ofile(filename);
+  if (!ofile) {
+    MGL_LOG_WARNING("Cannot write " << filename);
+    return false;
+  }
+  ofile << std::fixed << std::setprecision(3);
+  ofile << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+  bool first = true;
+
+  std::lock_guard<std::mutex> lock(BuffersMutex);
+  for (const std::unique_ptr<ThreadBuffer> &buffer : Buffers) {
+    const uint64_t end = buffer->count.load(std::memory_order_acquire);
+    const uint64_t begin =
+        end > EVENTS_PER_THREAD ? end - EVENTS_PER_THREAD : 0;
+    std::vector<ProfileEvent> events;
+    events.reserve(static_cast<std::size_t>(end - begin));
+    for (uint64_t i = begin; i < end; i++) {
+      events.push_back(buffer->events[i % EVENTS_PER_THREAD]);
+    }
+    const uint64_t after = buffer->count.load(std::memory_order_acquire);
+    const uint64_t overwritten =
+        after > EVENTS_PER_THREAD ? after - EVENTS_PER_THREAD : 0;
+    const std::size_t skip = static_cast<std::size_t>(
+        std::min<uint64_t>(events.size(),
+                           overwritten > begin ? overwritten - begin : 0));
+
+    ofile << (first ? "" : ",") << "\n{\"ph\":\"M\",\"pid\":0,\"tid\":"
+          << buffer->id << ",\"name\":\"thread_name\",\"args\":{\"name\":";
+    writeJsonString(ofile, buffer->name);
+    ofile << "}}";
+    first = false;
+    for (std::size_t i = skip; i < events.size(); i++) {
+      const ProfileEvent &e = events[i];
+      ofile << ",\n{\"ph\":\"X\",\"pid\":0,\"tid\":" << buffer->id
+            << ",\"name\":";
+      writeJsonString(ofile, e.name);
+      ofile << ",\"ts\":" << e.start / 1000.0 << ",\"dur\":"
+            << e.duration / 1000.0 << ",\"args\":{\"depth\":" << e.depth;
+      if (e.allocations) {
+        ofile << ",\"allocations\":" << e.allocations << ",\"bytes\":"
+              << e.bytes;
+      }
+      ofile << "}}";
+    }
+  }
+  ofile << "\n]}\n";
+  return static_cast<bool>(ofile);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+}  // namespace mgl
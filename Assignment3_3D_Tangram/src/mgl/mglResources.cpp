@@ -0,0 +1,118 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Resource Manager
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "./mglResources.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace mgl {
+
+//////////////////////////////////////////////////////////////// ResourceManager
+
+static uint64_t fnv1a(uint64_t hash, const void *data, std::size_t size) {
+  const unsigned char *bytes = static_cast<const unsigned char *>(data);
+  for (std::size_t i = 0; i < size; i++) {
+    hash ^= bytes[i];
+    hash *= 0x100000001b3ull;
+  }
+  return hash;
+}
+
+uint64_t ResourceManager::hashSources(
+    const std::vector<ShaderSource> &sources) {
+  uint64_t hash = 0xcbf29ce484222325ull;
+  for (const ShaderSource &s : sources) {
+    const std::size_t length =
+        s.length < 0 ? std::strlen(s.source) : static_cast<std::size_t>(s.length);
+    hash = fnv1a(hash, &s.type, sizeof(s.type));
+    hash = fnv1a(hash, s.source, length);
+  }
+  return hash;
+}
+
+void ResourceManager::setShaderQueue(ShaderQueue *queue) { Queue = queue; }
+
+Handle<Mesh> ResourceManager::getMesh(const std::string &filename,
+                                      unsigned int flags) {
+  return getMesh(filename, flags,
+                 [&filename](Mesh &mesh) { mesh.create(filename); });
+}
+
+Handle<Mesh> ResourceManager::getMesh(const std::string &name,
+                                      unsigned int flags,
+                                      const MeshLoader &loader) {
+  Handle<Mesh> &mesh = Meshes[{name, flags}];
+  if (!mesh) {
+    mesh = std::make_shared<Mesh>();
+    mesh->setAssimpFlags(flags);
+    loader(*mesh);
+    mesh->setName(name);
+  }
+  return mesh;
+}
+
+// Sources without text in memory are read here, so that the hash covers
+// what is actually compiled.
+Handle<ShaderProgram> ResourceManager::getProgram(
+    const std::vector<ShaderSource> &sources, const ProgramSetup &setup) {
+  std::vector<ShaderSource> resolved = sources;
+  std::vector<std::string> texts(sources.size());
+  for (std::size_t i = 0; i < resolved.size(); i++) {
+    if (!resolved[i].source) {
+      std::ifstream ifile(resolved[i].filename);
+      std::stringstream buffer;
+      buffer << ifile.rdbuf();
+      texts[i] = buffer.str();
+      resolved[i].source = texts[i].c_str();
+      resolved[i].length = -1;
+    }
+  }
+
+  Handle<ShaderProgram> &program = Programs[hashSources(resolved)];
+  if (!program) {
+    program = std::make_shared<ShaderProgram>();
+    for (const ShaderSource &s : resolved) {
+      program->addShader(s.type, s.filename, s.source, s.length);
+    }
+    setup(*program);
+  }
+  return program;
+}
+
+unsigned int ResourceManager::collect() {
+  unsigned int freed = 0;
+  for (auto i = Meshes.begin(); i != Meshes.end();) {
+    if (i->second.use_count() == 1) {
+      i = Meshes.erase(i);
+      freed++;
+    } else {
+      ++i;
+    }
+  }
+  for (auto i = Programs.begin(); i != Programs.end();) {
+    if (i->second.use_count() == 1) {
+      if (Queue) Queue->remove(i->second.get());
+      i = Programs.erase(i);
+      freed++;
+    } else {
+      ++i;
+    }
+  }
+#ifdef DEBUG
+  if (freed) std::cout << "Freed " << freed << " resource(s)" << std::endl;
+#endif
+  return freed;
+}
+
+std::size_t ResourceManager::getMeshCount() { return Meshes.size(); }
+
+std::size_t ResourceManager::getProgramCount() { return Programs.size(); }
+
+////////////////////////////////////////////////////////////////////////////////
+}  // namespace mgl
@@ -0,0 +1,129 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Scene Management Class
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "./mglScenegraph.hpp"
+
+#include <GLFW/glfw3.h>
+
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <glm/gtx/quaternion.hpp>
+#include <glm/gtx/transform.hpp>
+
+#include "./mglMesh.hpp"
+#include "./mglShader.hpp"
+
+namespace mgl {
+
+////////////////////////////////////////////////////////////////////// SceneNode
+
+void SceneNode::setShader(ShaderProgram *shaders) { Shaders = shaders; }
+
+void SceneNode::setMesh(Mesh *mesh) { NodeMesh = mesh; }
+
+void SceneNode::addChild(SceneNode *child) { Children.push_back(child); }
+
+void SceneNode::addPosition(int pos, const glm::mat4 &m) { M[pos] = m; }
+
+std::vector<SceneNode *> &SceneNode::getChildren() { return Children; }
+
+float SceneNode::getStage() { return AnimationStage; }
+
+void SceneNode::setStage(float stage) {
+  AnimationStage = PrevAnimationStage = glm::clamp(stage, 0.0f, 1.0f);
+  pose();
+}
+
+bool SceneNode::update(const bool *pressedKeys) {
+  if (pressedKeys[GLFW_KEY_LEFT]) {
+    AnimationStage -= AnimationStep;
+  }
+  if (pressedKeys[GLFW_KEY_RIGHT]) {
+    AnimationStage += AnimationStep;
+  }
+  AnimationStage = glm::clamp(AnimationStage, 0.0f, 1.0f);
+
+  if (AnimationStage == PrevAnimationStage) {
+    return false;
+  }
+  PrevAnimationStage = AnimationStage;
+  pose();
+
+  for (SceneNode *child : Children) {
+    child->update(pressedKeys);
+  }
+  return true;
+}
+
+void SceneNode::pose() {
+  // Linear interpolation for translation
+  glm::vec3 initialTranslation = glm::vec3(M[0][3]);
+  glm::vec3 finalTranslation = glm::vec3(M[2][3]);
+  glm::vec3 currentTranslation =
+      glm::mix(initialTranslation, finalTranslation, AnimationStage);
+
+  // Linear interpolation for rotation, with the columns normalized to remove
+  // scaling effects
+  glm::mat3 initialRotationMatrix = glm::mat3(M[0]);
+  glm::mat3 finalRotationMatrix = glm::mat3(M[2]);
+  for (int i = 0; i < 3; ++i) {
+    initialRotationMatrix[i] = glm::normalize(initialRotationMatrix[i]);
+    finalRotationMatrix[i] = glm::normalize(finalRotationMatrix[i]);
+  }
+  glm::quat initialRotation = glm::quat_cast(initialRotationMatrix);
+  glm::quat finalRotation = glm::quat_cast(finalRotationMatrix);
+  glm::quat currentRotation =
+      glm::lerp(initialRotation, finalRotation, AnimationStage);
+
+  // Scaling doesn't change, so the initial scale is used
+  glm::vec3 currentScale = glm::vec3(
+      glm::length(M[0][0]), glm::length(M[0][1]), glm::length(M[0][2]));
+
+  M[1] = glm::translate(currentTranslation) * glm::toMat4(currentRotation) *
+         glm::scale(currentScale);
+}
+
+void SceneNode::draw(GLint modelMatrixId, GLint colorId,
+                     const glm::mat4 &parentTransform,
+                     ShaderProgram *parentShader) {
+  glm::mat4 totalTransform = parentTransform * M[1];
+
+  if (NodeMesh) {
+    if (!Shaders) Shaders = parentShader;
+    Shaders->bind();
+    glUniformMatrix4fv(modelMatrixId, 1, GL_FALSE,
+                       glm::value_ptr(totalTransform));
+    glUniform3f(colorId, Color[0], Color[1], Color[2]);
+    NodeMesh->draw();
+    Shaders->unbind();
+  }
+
+  for (SceneNode *child : Children) {
+    child->draw(modelMatrixId, colorId, totalTransform, Shaders);
+  }
+}
+
+// Reads nothing that update() writes, so the two may run concurrently.
+void SceneNode::drawCollected(GLint modelMatrixId, GLint colorId,
+                              const glm::mat4 *&transforms,
+                              ShaderProgram *parentShader) {
+  ShaderProgram *shaders = Shaders ? Shaders : parentShader;
+  if (NodeMesh) {
+    shaders->bind();
+    glUniformMatrix4fv(modelMatrixId, 1, GL_FALSE,
+                       glm::value_ptr(*transforms++));
+    glUniform3f(colorId, Color[0], Color[1], Color[2]);
+    NodeMesh->draw();
+    shaders->unbind();
+  }
+
+  for (SceneNode *child : Children) {
+    child->drawCollected(modelMatrixId, colorId, transforms, shaders);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+}  // namespace mgl
@@ -11,6 +11,8 @@
 #include <cassert>
 #include <fstream>
 
+#include "./mglLog.hpp"
+
 namespace mgl {
 
 ////////////////////////////////////////////////////////////////// ShaderProgram
@@ -24,8 +26,23 @@ const std::string ShaderProgram::read(const std::string &filename) {
   return shader_string;
 }
 
-const GLuint ShaderProgram::checkCompilation(const GLuint shader_id,
-                                             const std::string &filename) {
+const GLuint ShaderProgram::compileShader(const GLenum shader_type,
+                                          const std::string &filename) {
+  const std::string scode = read(filename);
+  return compileShader(shader_type, scode.c_str());
+}
+
+const GLuint ShaderProgram::compileShader(const GLenum shader_type,
+                                          const char *source,
+                                          const GLint length) {
+  const GLuint shader_id = glCreateShader(shader_type);
+  glShaderSource(shader_id, 1, &source, length < 0 ? 0 : &length);
+  glCompileShader(shader_id);
+  return shader_id;
+}
+
+bool ShaderProgram::checkCompilation(const GLuint shader_id,
+                                     const std::string &filename) {
   GLint compiled;
   glGetShaderiv(shader_id, GL_COMPILE_STATUS, &compiled);
   if (compiled == GL_FALSE) {
@@ -33,45 +50,67 @@ const GLuint ShaderProgram::checkCompilation(const GLuint shader_id,
     glGetShaderiv(shader_id, GL_INFO_LOG_LENGTH, &length);
     GLchar *const log = new char[length];
     glGetShaderInfoLog(shader_id, length, &length, log);
-    std::cerr << "[" << filename << "] " << std::endl << log;
+    MGL_LOG_ERROR("[" << filename << "]\n" << log);
     delete[] log;
-    exit(EXIT_FAILURE);
   }
-  return compiled;
+  return compiled == GL_TRUE;
 }
 
-void ShaderProgram::checkLinkage() {
+bool ShaderProgram::checkLinkage(const GLuint program_id) {
   GLint linked;
-  glGetProgramiv(ProgramId, GL_LINK_STATUS, &linked);
+  glGetProgramiv(program_id, GL_LINK_STATUS, &linked);
   if (linked == GL_FALSE) {
     GLint length;
-    glGetProgramiv(ProgramId, GL_INFO_LOG_LENGTH, &length);
+    glGetProgramiv(program_id, GL_INFO_LOG_LENGTH, &length);
     GLchar *const log = new char[length];
-    glGetProgramInfoLog(ProgramId, length, &length, log);
-    std::cerr << "[LINK] " << std::endl << log << std::endl;
+    glGetProgramInfoLog(program_id, length, &length, log);
+    MGL_LOG_ERROR("[LINK]\n" << log);
     delete[] log;
-    exit(EXIT_FAILURE);
   }
+  return linked == GL_TRUE;
+}
+
+bool ShaderProgram::isComplete(const GLuint program_id) {
+  if (!GLEW_KHR_parallel_shader_compile && !GLEW_ARB_parallel_shader_compile)
+    return true;
+  GLint completed;
+  glGetProgramiv(program_id, GL_COMPLETION_STATUS_KHR, &completed);
+  return completed == GL_TRUE;
 }
 
-ShaderProgram::ShaderProgram() : ProgramId(glCreateProgram()) {}
+ShaderProgram::ShaderProgram()
+    : ProgramId(glCreateProgram()),
+      Linked(false),
+      PendingId(0),
+      Memory(MEMORY_PROGRAM) {}
 
 ShaderProgram::~ShaderProgram() {
   glUseProgram(0);
-  glDeleteProgram(ProgramId);
+  DeletionQueue::getInstance().release(GL_OBJECT_PROGRAM, ProgramId);
+  if (PendingId) {
+    for (auto &i : PendingShaders) glDeleteShader(i.second);
+    glDeleteProgram(PendingId);
+  }
 }
 
 void ShaderProgram::addShader(const GLenum shader_type,
                               const std::string &filename) {
-  const GLuint shader_id = glCreateShader(shader_type);
-  const std::string scode = read(filename);
-  const GLchar *code = scode.c_str();
-  glShaderSource(shader_id, 1, &code, 0);
-  glCompileShader(shader_id);
-  checkCompilation(shader_id, filename);
+  const GLuint shader_id = compileShader(shader_type, filename);
   glAttachShader(ProgramId, shader_id);
 
-  Shaders[shader_type] = {shader_id};
+  Shaders[shader_type] = {shader_id, filename};
+}
+
+// The source is compiled from memory (length < 0 if null-terminated);
+// filename only labels compiler messages and, if it exists on disk, is what
+// live reload recompiles from.
+void ShaderProgram::addShader(const GLenum shader_type,
+                              const std::string &filename,
+                              const char *source, const GLint length) {
+  const GLuint shader_id = compileShader(shader_type, source, length);
+  glAttachShader(ProgramId, shader_id);
+
+  Shaders[shader_type] = {shader_id, filename};
 }
 
 void ShaderProgram::addAttribute(const std::string &name, const GLuint index) {
@@ -100,27 +139,126 @@ bool ShaderProgram::isUniformBlock(const std::string &name) {
   return Ubos.find(name) != Ubos.end();
 }
 
-void ShaderProgram::create() {
-  glLinkProgram(ProgramId);
-  checkLinkage();
-  for (auto &i : Shaders) {
-    glDetachShader(ProgramId, i.second);
-    glDeleteShader(i.second);
+void ShaderProgram::bindAttributes(const GLuint program_id) {
+  for (auto &i : Attributes) {
+    glBindAttribLocation(program_id, i.second.index, i.first.c_str());
   }
+}
 
+void ShaderProgram::resolveLocations() {
   for (auto &i : Uniforms) {
     i.second.index = glGetUniformLocation(ProgramId, i.first.c_str());
     if (i.second.index < 0)
-      std::cerr << "WARNING: Uniform " << i.first << " not found." << std::endl;
+      MGL_LOG_WARNING("Uniform " << i.first << " not found.");
   }
   for (auto &i : Ubos) {
     i.second.index = glGetUniformBlockIndex(ProgramId, i.first.c_str());
-    if (i.second.index < 0)
-      std::cerr << "WARNING: UBO " << i.first << " not found." << std::endl;
+    if (i.second.index == GL_INVALID_INDEX) {
+      MGL_LOG_WARNING("UBO " << i.first << " not found.");
+      continue;
+    }
     glUniformBlockBinding(ProgramId, i.second.index, i.second.binding_point);
   }
 }
 
+void ShaderProgram::create() {
+  submit();
+  finish();
+}
+
+void ShaderProgram::submit() { glLinkProgram(ProgramId); }
+
+bool ShaderProgram::isReady() { return Linked || isComplete(ProgramId); }
+
+void ShaderProgram::finish() {
+  bool ok = true;
+  for (auto &i : Shaders) {
+    ok = checkCompilation(i.second.index, i.second.filename) && ok;
+  }
+  if (!ok || !checkLinkage(ProgramId)) {
+    exit(EXIT_FAILURE);
+  }
+  for (auto &i : Shaders) {
+    glDetachShader(ProgramId, i.second.index);
+    glDeleteShader(i.second.index);
+  }
+  resolveLocations();
+  Linked = true;
+  updateMemory();
+}
+
+bool ShaderProgram::isLinked() { return Linked; }
+
+//////////////////////////////////////////////////////////////////// LIVE RELOAD
+
+void ShaderProgram::rebuild() {
+  if (PendingId) {
+    for (auto &i : PendingShaders) glDeleteShader(i.second);
+    glDeleteProgram(PendingId);
+    PendingShaders.clear();
+  }
+  PendingId = glCreateProgram();
+  for (auto &i : Shaders) {
+    const GLuint shader_id = compileShader(i.first, i.second.filename);
+    glAttachShader(PendingId, shader_id);
+    PendingShaders[i.first] = shader_id;
+  }
+  bindAttributes(PendingId);
+  glLinkProgram(PendingId);
+}
+
+bool ShaderProgram::isRebuilding() { return PendingId != 0; }
+
+bool ShaderProgram::pollRebuild() {
+  if (!PendingId || !isComplete(PendingId)) return false;
+
+  bool ok = true;
+  for (auto &i : PendingShaders) {
+    ok = checkCompilation(i.second, Shaders[i.first].filename) && ok;
+  }
+  ok = ok && checkLinkage(PendingId);
+  for (auto &i : PendingShaders) {
+    glDetachShader(PendingId, i.second);
+    glDeleteShader(i.second);
+  }
+  PendingShaders.clear();
+
+  if (!ok) {
+    MGL_LOG_WARNING("Shader reload failed, keeping previous program.");
+    glDeleteProgram(PendingId);
+    PendingId = 0;
+    return false;
+  }
+  DeletionQueue::getInstance().release(GL_OBJECT_PROGRAM, ProgramId);
+  ProgramId = PendingId;
+  PendingId = 0;
+  resolveLocations();
+  updateMemory();
+  return true;
+}
+
+// The binary length is the closest the driver will tell us about the size of
+// a linked program; without GL_ARB_get_program_binary it is left at zero.
+void ShaderProgram::updateMemory() {
+  std::string name;
+  uint64_t cpu = sizeof(ShaderProgram);
+  for (auto &i : Shaders) {
+    name += (name.empty() ? "" : "+") + i.second.filename;
+    cpu += sizeof(i) + i.second.filename.capacity();
+  }
+  for (auto &i : Attributes) cpu += sizeof(i) + i.first.capacity();
+  for (auto &i : Uniforms) cpu += sizeof(i) + i.first.capacity();
+  for (auto &i : Ubos) cpu += sizeof(i) + i.first.capacity();
+  Memory.setName(name);
+  Memory.setCpu(cpu);
+
+  GLint length = 0;
+  if (GLEW_ARB_get_program_binary) {
+    glGetProgramiv(ProgramId, GL_PROGRAM_BINARY_LENGTH, &length);
+  }
+  Memory.setGpu(static_cast<uint64_t>(length));
+}
+
 void ShaderProgram::bind() { glUseProgram(ProgramId); }
 
 void ShaderProgram::unbind() { glUseProgram(0); }
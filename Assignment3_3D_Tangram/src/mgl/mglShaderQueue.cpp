@@ -0,0 +1,306 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Shader Compile Queue and Live Reload
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "./mglShaderQueue.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#include "./mglApp.hpp"
+#include "./mglLog.hpp"
+
+namespace mgl {
+
+//////////////////////////////////////////////////////////////////// FileWatcher
+
+FileWatcher::FileWatcher() : LastPoll(0.0) {
+#ifdef __linux__
+  Fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  StopFd = Fd >= 0 ? eventfd(0, EFD_CLOEXEC) : -1;
+  if (StopFd < 0) {
+    MGL_LOG_WARNING("inotify unavailable.");
+    if (Fd >= 0) close(Fd);
+    Fd = -1;
+  }
+#endif
+}
+
+FileWatcher::~FileWatcher() {
+#ifdef __linux__
+  if (Thread.joinable()) {
+    const uint64_t stop = 1;
+    if (write(StopFd, &stop, sizeof(stop)) < 0) {
+      MGL_LOG_ERROR("Cannot stop the file watcher thread.");
+    }
+    Thread.join();
+  }
+  if (StopFd >= 0) close(StopFd);
+  if (Fd >= 0) close(Fd);
+#endif
+}
+
+void FileWatcher::setListener(std::function<void()> listener) {
+  Listener = std::move(listener);
+}
+
+// Embedded or packed shaders have no file on disk to watch.
+void FileWatcher::watch(const std::string &filename) {
+  if (isWatched(filename)) return;
+  std::error_code ec;
+  std::filesystem::path path =
+      std::filesystem::absolute(filename, ec).lexically_normal();
+  if (!std::filesystem::exists(path, ec)) return;
+  std::lock_guard<std::mutex> lock(Mutex);
+  Files.push_back({filename, path, std::filesystem::last_write_time(path, ec)});
+
+#ifdef __linux__
+  // Editors usually save by renaming a temporary file over the original, so
+  // the directory is watched rather than the file itself.
+  if (Fd >= 0) {
+    const std::filesystem::path dir = path.parent_path();
+    int wd = inotify_add_watch(Fd, dir.c_str(),
+                               IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+    if (wd >= 0) Directories[wd] = dir;
+    if (!Thread.joinable()) Thread = std::thread(&FileWatcher::run, this);
+  }
+#endif
+}
+
+// A directory stays watched while another file in it is.
+void FileWatcher::unwatch(const std::string &filename) {
+  std::lock_guard<std::mutex> lock(Mutex);
+  auto file = std::find_if(Files.begin(), Files.end(), [&](const FileInfo &f) {
+    return f.filename == filename;
+  });
+  if (file == Files.end()) return;
+  const std::filesystem::path dir = file->path.parent_path();
+  Files.erase(file);
+
+#ifdef __linux__
+  Changed.erase(std::remove(Changed.begin(), Changed.end(), filename),
+                Changed.end());
+  if (Fd < 0) return;
+  for (const FileInfo &f : Files) {
+    if (f.path.parent_path() == dir) return;
+  }
+  for (auto i = Directories.begin(); i != Directories.end(); ++i) {
+    if (i->second == dir) {
+      inotify_rm_watch(Fd, i->first);
+      Directories.erase(i);
+      return;
+    }
+  }
+#endif
+}
+
+bool FileWatcher::isWatched(const std::string &filename) {
+  std::lock_guard<std::mutex> lock(Mutex);
+  return std::find_if(Files.begin(), Files.end(), [&](const FileInfo &f) {
+           return f.filename == filename;
+         }) != Files.end();
+}
+
+bool FileWatcher::isPolling() {
+  std::lock_guard<std::mutex> lock(Mutex);
+#ifdef __linux__
+  if (Fd >= 0) return false;
+#endif
+  return !Files.empty();
+}
+
+#ifdef __linux__
+// Blocks until inotify has events, or until the destructor asks it to stop.
+void FileWatcher::run() {
+  pollfd fds[2] = {{Fd, POLLIN, 0}, {StopFd, POLLIN, 0}};
+  alignas(inotify_event) char buffer[4096];
+  for (;;) {
+    if (::poll(fds, 2, -1) < 0) {
+      if (errno == EINTR) continue;
+      MGL_LOG_ERROR("File watcher stopped: " << std::strerror(errno));
+      return;
+    }
+    if (fds[1].revents) return;
+    bool changed = false;
+    {
+      std::lock_guard<std::mutex> lock(Mutex);
+      ssize_t length;
+      while ((length = read(Fd, buffer, sizeof(buffer))) > 0) {
+        for (char *p = buffer; p < buffer + length;) {
+          const inotify_event *event = reinterpret_cast<inotify_event *>(p);
+          auto dir = Directories.find(event->wd);
+          if (dir != Directories.end() && event->len > 0) {
+            const std::filesystem::path path = dir->second / event->name;
+            for (FileInfo &f : Files) {
+              if (f.path == path &&
+                  std::find(Changed.begin(), Changed.end(), f.filename) ==
+                      Changed.end()) {
+                Changed.push_back(f.filename);
+                changed = true;
+              }
+            }
+          }
+          p += sizeof(inotify_event) + event->len;
+        }
+      }
+    }
+    if (changed && Listener) Listener();
+  }
+}
+#endif
+
+std::vector<std::string> FileWatcher::poll() {
+  std::vector<std::string> changed;
+  std::lock_guard<std::mutex> lock(Mutex);
+#ifdef __linux__
+  if (Fd >= 0) {
+    changed.swap(Changed);
+    return changed;
+  }
+#endif
+  // Not glfwGetTime(), which is unavailable when the Engine runs on EGL.
+  const double now = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now().time_since_epoch())
+                         .count();
+  if (now - LastPoll < POLL_INTERVAL) return changed;
+  LastPoll = now;
+  for (FileInfo &f : Files) {
+    std::error_code ec;
+    auto time = std::filesystem::last_write_time(f.path, ec);
+    if (!ec && time != f.time) {
+      f.time = time;
+      changed.push_back(f.filename);
+    }
+  }
+  return changed;
+}
+
+//////////////////////////////////////////////////////////////////// ShaderQueue
+
+ShaderQueue::ShaderQueue() : IdlePolling(false) {
+  // Let the driver use as many compiler threads as it sees fit.
+  if (GLEW_KHR_parallel_shader_compile) {
+    glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+  } else if (GLEW_ARB_parallel_shader_compile) {
+    glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
+  }
+  Watcher.setListener([] { Engine::getInstance().invalidate(); });
+}
+
+ShaderQueue::~ShaderQueue() {
+  if (IdlePolling) Engine::getInstance().setIdlePoll(nullptr, 0.0);
+}
+
+void ShaderQueue::add(ShaderProgram *program) {
+  if (program->isLinked() ||
+      std::find(Pending.begin(), Pending.end(), program) != Pending.end())
+    return;
+  program->submit();
+  Pending.push_back(program);
+}
+
+void ShaderQueue::watch(ShaderProgram *program) {
+  if (std::find(Watched.begin(), Watched.end(), program) != Watched.end())
+    return;
+  Watched.push_back(program);
+  for (auto &i : program->Shaders) {
+    Watcher.watch(i.second.filename);
+  }
+  // Nothing else would wake an on-demand wait when a file changes.
+  if (!IdlePolling && Watcher.isPolling()) {
+    Engine::getInstance().setIdlePoll([this] { return pollFiles(); },
+                                      FileWatcher::POLL_INTERVAL);
+    IdlePolling = true;
+  }
+}
+
+// Files still used by another watched program stay watched.
+void ShaderQueue::remove(ShaderProgram *program) {
+  Pending.erase(std::remove(Pending.begin(), Pending.end(), program),
+                Pending.end());
+  auto watched = std::find(Watched.begin(), Watched.end(), program);
+  if (watched == Watched.end()) return;
+  Watched.erase(watched);
+  for (auto &i : program->Shaders) {
+    bool shared = false;
+    for (ShaderProgram *other : Watched) {
+      for (auto &j : other->Shaders) {
+        if (j.second.filename == i.second.filename) shared = true;
+      }
+    }
+    if (!shared) Watcher.unwatch(i.second.filename);
+  }
+  if (IdlePolling && !Watcher.isPolling()) {
+    Engine::getInstance().setIdlePoll(nullptr, 0.0);
+    IdlePolling = false;
+  }
+}
+
+bool ShaderQueue::update() {
+  bool changed = false;
+
+  for (auto it = Pending.begin(); it != Pending.end();) {
+    if ((*it)->isReady()) {
+      (*it)->finish();
+      it = Pending.erase(it);
+      changed = true;
+    } else {
+      ++it;
+    }
+  }
+
+  pollFiles();
+  for (ShaderProgram *program : Watched) {
+    for (auto &i : program->Shaders) {
+      if (std::find(Changed.begin(), Changed.end(), i.second.filename) !=
+          Changed.end()) {
+#ifdef DEBUG
+        std::cout << "Reloading [" << i.second.filename << "]" << std::endl;
+#endif
+        program->rebuild();
+        break;
+      }
+    }
+    if (program->isRebuilding() && program->pollRebuild()) {
+      changed = true;
+    }
+  }
+  Changed.clear();
+  return changed;
+}
+
+// Also called by the Engine while it waits, so the changes are kept until
+// the next update().
+bool ShaderQueue::pollFiles() {
+  const std::vector<std::string> files = Watcher.poll();
+  Changed.insert(Changed.end(), files.begin(), files.end());
+  return !files.empty();
+}
+
+bool ShaderQueue::isIdle() {
+  if (!Pending.empty()) return false;
+  for (ShaderProgram *program : Watched) {
+    if (program->isRebuilding()) return false;
+  }
+  return true;
+}
+
+void ShaderQueue::wait() {
+  for (ShaderProgram *program : Pending) program->finish();
+  Pending.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+}  // namespace mgl
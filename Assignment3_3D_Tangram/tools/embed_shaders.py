@@ -0,0 +1,66 @@
+#!/usr/bin/env python3
+################################################################################
+#
+# Shader Embedding Build Step
+#
+# Writes the given GLSL files into a C++ header as constexpr raw string
+# literals, so the executable needs no shader file I/O at startup:
+#
+#   embed_shaders.py <output.hpp> <shader.glsl>...
+#
+# "vertex_shader.glsl" becomes mgl::embedded::VERTEX_SHADER_GLSL.
+#
+################################################################################
+
+import os
+import re
+import sys
+
+DELIMITER = "glsl"
+CHUNK = 8192
+
+
+def identifier(path):
+    name = os.path.basename(path)
+    return re.sub(r"[^0-9A-Za-z]", "_", name).upper()
+
+
+def embed(path):
+    with open(path, "r", encoding="utf-8") as f:
+        source = f.read()
+    if ")" + DELIMITER + '"' in source:
+        sys.exit("embed_shaders: delimiter clash in " + path)
+    # MSVC limits a single string literal to 16K, so long sources are split
+    # into adjacent literals.
+    pieces = [source[i:i + CHUNK] for i in range(0, len(source), CHUNK)]
+    literals = "\n".join(
+        "R\"{}({}){}\"".format(DELIMITER, piece, DELIMITER) for piece in pieces)
+    return "constexpr char {}[] = {};\n".format(identifier(path), literals)
+
+
+def main(argv):
+    if len(argv) < 3:
+        sys.exit("usage: embed_shaders.py <output.hpp> <shader.glsl>...")
+    output, inputs = argv[1], argv[2:]
+
+    text = "// Generated by tools/embed_shaders.py. Do not edit.\n\n"
+    text += "#ifndef MGL_EMBEDDED_SHADERS_HPP\n"
+    text += "#define MGL_EMBEDDED_SHADERS_HPP\n\n"
+    text += "namespace mgl {\nnamespace embedded {\n\n"
+    for path in inputs:
+        text += embed(path) + "\n"
+    text += "}  // namespace embedded\n}  // namespace mgl\n\n"
+    text += "#endif /* MGL_EMBEDDED_SHADERS_HPP */\n"
+
+    # Only touch the header when it changes, to avoid needless rebuilds.
+    if os.path.exists(output):
+        with open(output, "r", encoding="utf-8") as f:
+            if f.read() == text:
+                return
+    os.makedirs(os.path.dirname(os.path.abspath(output)), exist_ok=True)
+    with open(output, "w", encoding="utf-8", newline="\n") as f:
+        f.write(text)
+
+
+if __name__ == "__main__":
+    main(sys.argv)
@@ -0,0 +1,383 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Microbenchmarks for the mgl Hot Paths
+//
+//   mglbench [--json <file>] [--filter <text>] [--repetitions <n>]
+//            [--warmup <n>] [--max-nodes <n>] [--no-gl]
+//
+// Every case is run for --warmup discarded samples, then --repetitions timed
+// samples; a sample repeats the case until it takes at least MIN_SAMPLE_TIME.
+// CPU-only cases run first and need no context. Cases that call OpenGL run
+// inside the Engine's headless context, so no display or GPU is required.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <glm/gtx/transform.hpp>
+
+#include "../mgl/mgl.hpp"
+
+static const double MIN_SAMPLE_TIME = 0.005;  // seconds
+
+struct Options {
+  std::string json;
+  std::string filter;
+  int repetitions = 10;
+  int warmup = 2;
+  std::size_t maxNodes = 1000000;
+  bool gl = true;
+};
+
+struct Result {
+  std::string name;
+  std::size_t items;  // nodes, vertices, ... processed per iteration
+  std::size_t iterations;
+  std::vector<double> samples;  // nanoseconds per iteration
+  double min, median, mean, stddev;
+};
+
+static Options options;
+static std::vector<Result> results;
+static volatile std::size_t sink;  // keeps results from being optimized out
+
+//////////////////////////////////////////////////////////////////////// RUNNER
+
+using Clock = std::chrono::steady_clock;
+
+static double secondsSince(Clock::time_point start) {
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// `after` runs untimed after every sample, e.g. to drain the GL queue.
+static void measure(const std::string &name, std::size_t items,
+                    const std::function<void()> &iteration,
+                    const std::function<void()> &after = nullptr) {
+  if (name.find(options.filter) == std::string::npos) return;
+
+  std::size_t iterations = 1;
+  for (;;) {
+    const Clock::time_point start = Clock::now();
+    for (std::size_t i = 0; i < iterations; i++) iteration();
+    if (after) after();
+    if (secondsSince(start) >= MIN_SAMPLE_TIME) break;
+    iterations *= 2;
+  }
+
+  Result r{name, items, iterations, {}, 0.0, 0.0, 0.0, 0.0};
+  for (int s = 0; s < options.warmup + options.repetitions; s++) {
+    const Clock::time_point start = Clock::now();
+    for (std::size_t i = 0; i < iterations; i++) iteration();
+    const double elapsed = secondsSince(start);
+    if (after) after();
+    if (s >= options.warmup) r.samples.push_back(elapsed * 1e9 / iterations);
+  }
+
+  std::vector<double> sorted = r.samples;
+  std::sort(sorted.begin(), sorted.end());
+  const std::size_t n = sorted.size();
+  r.min = sorted.front();
+  r.median = n % 2 ? sorted[n / 2] : (sorted[n / 2 - 1] + sorted[n / 2]) / 2;
+  for (double v : sorted) r.mean += v / n;
+  for (double v : sorted) r.stddev += (v - r.mean) * (v - r.mean) / n;
+  r.stddev = std::sqrt(r.stddev);
+
+  std::cout << name << std::string(name.size() < 32 ? 32 - name.size() : 1, ' ')
+            << r.median << " ns (min " << r.min << ", +/- " << r.stddev
+            << ", " << r.median / items << " ns/item)" << std::endl;
+  results.push_back(r);
+}
+
+static std::vector<std::size_t> nodeCounts() {
+  std::vector<std::size_t> counts;
+  for (std::size_t n = 10; n <= options.maxNodes; n *= 10) counts.push_back(n);
+  return counts;
+}
+
+///////////////////////////////////////////////////////////////////////// SCENES
+
+// A tree with up to eight children per node, filled breadth first. Every node
+// animates between two random placements, as the tangram pieces do.
+struct Scene {
+  std::vector<mgl::SceneNode> nodes;
+
+  Scene(std::size_t n, mgl::Mesh *mesh, mgl::ShaderProgram *shaders)
+      : nodes(n) {
+    std::mt19937 random(1234);
+    std::uniform_real_distribution<float> u(-1.0f, 1.0f);
+    for (std::size_t i = 0; i < n; i++) {
+      mgl::SceneNode &node = nodes[i];
+      const glm::mat4 box =
+          glm::translate(glm::vec3(u(random), u(random), u(random)));
+      const glm::mat4 shape =
+          glm::translate(glm::vec3(u(random), u(random), u(random))) *
+          glm::rotate(u(random), glm::vec3(0.0f, 1.0f, 0.0f)) *
+          glm::scale(glm::vec3(0.01f));
+      node.addPosition(0, box);
+      node.addPosition(1, box);
+      node.addPosition(2, shape);
+      node.setMesh(i > 0 ? mesh : nullptr);
+      if (i > 0) nodes[(i - 1) / 8].addChild(&node);
+    }
+    nodes[0].setShader(shaders);
+  }
+};
+
+// Alternating the keys makes every update move the animation, so the whole
+// tree is traversed instead of stopping at an unchanged root.
+static bool *alternatingKeys() {
+  static bool keys[GLFW_KEY_LAST + 1] = {};
+  static bool right = false;
+  right = !right;
+  keys[GLFW_KEY_RIGHT] = right;
+  keys[GLFW_KEY_LEFT] = !right;
+  return keys;
+}
+
+// One mesh of n_triangles in a strip, with positions and normals, as Assimp
+// would hand it over after triangulation.
+static std::unique_ptr<aiScene> syntheticScene(unsigned int n_triangles) {
+  std::unique_ptr<aiScene> scene = std::make_unique<aiScene>();
+  aiMesh *mesh = new aiMesh();
+  mesh->mNumVertices = n_triangles + 2;
+  mesh->mVertices = new aiVector3D[mesh->mNumVertices];
+  mesh->mNormals = new aiVector3D[mesh->mNumVertices];
+  for (unsigned int i = 0; i < mesh->mNumVertices; i++) {
+    mesh->mVertices[i] = aiVector3D(0.5f * (i / 2), 0.5f * (i % 2), 0.0f);
+    mesh->mNormals[i] = aiVector3D(0.0f, 0.0f, 1.0f);
+  }
+  mesh->mNumFaces = n_triangles;
+  mesh->mFaces = new aiFace[n_triangles];
+  for (unsigned int i = 0; i < n_triangles; i++) {
+    mesh->mFaces[i].mNumIndices = 3;
+    mesh->mFaces[i].mIndices = new unsigned int[3]{i, i + 1, i + 2};
+  }
+  scene->mNumMeshes = 1;
+  scene->mMeshes = new aiMesh *[1] { mesh };
+  return scene;
+}
+
+// Waits for the next frame forever, as a running tween does.
+static mgl::Animation idleAnimation() {
+  for (;;) co_await mgl::nextFrame();
+}
+
+//////////////////////////////////////////////////////////////////////////// CPU
+
+static void benchmarkCpu() {
+  for (std::size_t n : nodeCounts()) {
+    Scene scene(n, nullptr, nullptr);
+    measure("scene_update/" + std::to_string(n), n,
+            [&] { scene.nodes[0].update(alternatingKeys()); });
+  }
+
+  for (unsigned int n = 1000; n <= 1000000; n *= 10) {
+    std::unique_ptr<aiScene> ai = syntheticScene(n);
+    measure("mesh_process_scene/" + std::to_string(n), n, [&] {
+      mgl::Mesh mesh;
+      mesh.load(ai.get());
+      sink = sink + mesh.hasNormals();
+    });
+  }
+
+  const std::size_t max_animations =
+      std::min<std::size_t>(options.maxNodes, 100000);
+  for (std::size_t n = 10; n <= max_animations; n *= 10) {
+    mgl::Animator animator;
+    for (std::size_t i = 0; i < n; i++) animator.start(idleAnimation());
+    animator.update(0.0);
+    measure("animation_resume/" + std::to_string(n), n,
+            [&] { animator.update(1.0 / 60.0); });
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////// GL
+
+static const char VERTEX_SHADER[] = R"(#version 330 core
+in vec3 inPosition;
+uniform mat4 ModelMatrix;
+uniform Camera {
+  mat4 ViewMatrix;
+  mat4 ProjectionMatrix;
+};
+void main(void) {
+  gl_Position = ProjectionMatrix * ViewMatrix * ModelMatrix *
+                vec4(inPosition, 1.0);
+}
+)";
+
+static const char FRAGMENT_SHADER[] = R"(#version 330 core
+uniform vec3 Color;
+out vec4 FragmentColor;
+void main(void) { FragmentColor = vec4(Color, 1.0); }
+)";
+
+static const GLuint UBO_BP = 0;
+
+static void setupProgram(mgl::ShaderProgram &program) {
+  program.addShader(GL_VERTEX_SHADER, "bench.vert", VERTEX_SHADER);
+  program.addShader(GL_FRAGMENT_SHADER, "bench.frag", FRAGMENT_SHADER);
+  program.addAttribute(mgl::POSITION_ATTRIBUTE, mgl::Mesh::POSITION);
+  program.addUniform(mgl::MODEL_MATRIX);
+  program.addUniform(mgl::COLOR);
+  program.addUniformBlock(mgl::CAMERA_BLOCK, UBO_BP);
+}
+
+constexpr float CUBE_FACE[4][2] = {
+    {-0.5f, 0.0f}, {0.0f, 0.0f}, {0.0f, 0.5f}, {-0.5f, 0.5f}};
+constexpr auto CUBE_GEOMETRY = mgl::extrude(CUBE_FACE, 0.5f);
+
+static void benchmarkGl() {
+  // Deletion is deferred to the DeletionQueue, flushed here so that it is
+  // still timed along with the creation.
+  measure("shader_create", 1, [] {
+    {
+      mgl::ShaderProgram program;
+      setupProgram(program);
+      program.create();
+    }
+    mgl::DeletionQueue::getInstance().flush();
+  });
+
+  mgl::ShaderProgram program;
+  setupProgram(program);
+  program.create();
+
+  measure("uniform_lookup/map", 2, [&] {
+    sink = sink + program.Uniforms[mgl::MODEL_MATRIX].index +
+           program.Uniforms[mgl::COLOR].index;
+  });
+  measure("uniform_lookup/gl", 2, [&] {
+    sink = sink + glGetUniformLocation(program.ProgramId, mgl::MODEL_MATRIX) +
+           glGetUniformLocation(program.ProgramId, mgl::COLOR);
+  });
+
+  mgl::OrbitCamera camera(UBO_BP, 'A');
+  camera.setViewMatrix(glm::vec3(0.0f, 0.0f, 8.0f), glm::vec3(0.0f),
+                       glm::vec3(0.0f, 1.0f, 0.0f));
+  camera.setPerspectiveMatrix(30.0f, 4.0f / 3.0f, 1.0f, 10.0f);
+  measure("camera_update", 1, [&] {
+    camera.update();
+    camera.upload();
+  });
+
+  mgl::Mesh mesh;
+  mesh.create(CUBE_GEOMETRY);
+  const GLint model_matrix = program.Uniforms[mgl::MODEL_MATRIX].index;
+  const GLint color = program.Uniforms[mgl::COLOR].index;
+  for (std::size_t n : nodeCounts()) {
+    Scene scene(n, &mesh, &program);
+    scene.nodes[0].update(alternatingKeys());
+    measure("scene_draw/" + std::to_string(n), n,
+            [&] { scene.nodes[0].draw(model_matrix, color); },
+            [] { glFinish(); });
+  }
+
+  // A fresh snapshot per frame, as the render thread takes one.
+  for (std::size_t n : nodeCounts()) {
+    Scene scene(n, &mesh, &program);
+    scene.nodes[0].update(alternatingKeys());
+    measure("scene_collect/heap/" + std::to_string(n), n, [&] {
+      std::vector<glm::mat4> transforms;
+      scene.nodes[0].collect(transforms);
+      sink = sink + transforms.size();
+    });
+    mgl::FrameArena &arena = mgl::FrameArena::getLocal();
+    measure("scene_collect/arena/" + std::to_string(n), n, [&] {
+      arena.reset();
+      mgl::FrameVector<glm::mat4> transforms;
+      scene.nodes[0].collect(transforms);
+      sink = sink + transforms.size();
+    });
+  }
+}
+
+class BenchApp : public mgl::App {
+ public:
+  void initCallback(GLFWwindow *window) override {
+#ifdef DEBUG
+    std::cout << "OpenGL Renderer: " << glGetString(GL_RENDERER) << std::endl;
+#endif
+    benchmarkGl();
+  }
+};
+
+////////////////////////////////////////////////////////////////////////// JSON
+
+static bool writeJson(const std::string &filename) {
+  std::ofstream ofile(filename);
+  ofile << "{\n  \"benchmarks\": [";
+  for (std::size_t i = 0; i < results.size(); i++) {
+    const Result &r = results[i];
+    ofile << (i ? "," : "") << "\n    {\"name\": \"" << r.name
+          << "\", \"items\": " << r.items
+          << ", \"iterations\": " << r.iterations
+          << ", \"repetitions\": " << r.samples.size()
+          << ", \"min_ns\": " << r.min << ", \"median_ns\": " << r.median
+          << ", \"mean_ns\": " << r.mean << ", \"stddev_ns\": " << r.stddev
+          << ", \"samples_ns\": [";
+    for (std::size_t s = 0; s < r.samples.size(); s++) {
+      ofile << (s ? ", " : "") << r.samples[s];
+    }
+    ofile << "]}";
+  }
+  ofile << "\n  ]\n}\n";
+  if (!ofile) {
+    std::cerr << "ERROR: Cannot write " << filename << std::endl;
+    return false;
+  }
+  return true;
+}
+
+/////////////////////////////////////////////////////////////////////////// MAIN
+
+static int usage() {
+  std::cerr << "usage: mglbench [--json <file>] [--filter <text>] "
+               "[--repetitions <n>] [--warmup <n>] [--max-nodes <n>] [--no-gl]"
+            << std::endl;
+  return EXIT_FAILURE;
+}
+
+int main(int argc, char *argv[]) {
+  for (int i = 1; i < argc; i++) {
+    const std::string arg = argv[i];
+    if (arg == "--json" && i + 1 < argc) {
+      options.json = argv[++i];
+    } else if (arg == "--filter" && i + 1 < argc) {
+      options.filter = argv[++i];
+    } else if (arg == "--repetitions" && i + 1 < argc) {
+      options.repetitions = std::max(1, std::stoi(argv[++i]));
+    } else if (arg == "--warmup" && i + 1 < argc) {
+      options.warmup = std::max(0, std::stoi(argv[++i]));
+    } else if (arg == "--max-nodes" && i + 1 < argc) {
+      options.maxNodes = std::stoul(argv[++i]);
+    } else if (arg == "--no-gl") {
+      options.gl = false;
+    } else {
+      return usage();
+    }
+  }
+
+  benchmarkCpu();
+  if (options.gl) {
+    mgl::Engine &engine = mgl::Engine::getInstance();
+    engine.setApp(new BenchApp());
+    engine.setWindow(640, 480, "mglbench", 0, 0);
+    engine.setHeadless(true);
+    engine.setFrameLimit(1);
+    engine.init();
+    engine.run();
+  }
+
+  if (!options.json.empty() && !writeJson(options.json)) return EXIT_FAILURE;
+  return EXIT_SUCCESS;
+}
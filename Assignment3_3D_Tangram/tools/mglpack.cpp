@@ -0,0 +1,80 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Asset Pack Tool
+//
+//   mglpack [-c] [-C <dir>] <output.mglpack> <file>...
+//   mglpack -l <input.mglpack>
+//
+// Entries are named by their path relative to -C (default: current
+// directory), e.g. "assets/models/cube.obj", which is also the name used to
+// look them up at runtime. -c LZ4-compresses entries that get smaller.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "../mgl/mglAssetPack.hpp"
+
+static int usage() {
+  std::cerr << "usage: mglpack [-c] [-C <dir>] <output.mglpack> <file>..."
+            << std::endl
+            << "       mglpack -l <input.mglpack>" << std::endl;
+  return EXIT_FAILURE;
+}
+
+static int list(const std::string &filename) {
+  mgl::AssetPack pack;
+  if (!pack.open(filename)) return EXIT_FAILURE;
+  for (const std::string &name : pack.list()) {
+    std::cout << name << " (" << pack.get(name).size << " bytes)" << std::endl;
+  }
+  return EXIT_SUCCESS;
+}
+
+int main(int argc, char *argv[]) {
+  bool compress = false;
+  std::filesystem::path root = ".";
+  std::vector<std::string> args;
+  for (int i = 1; i < argc; i++) {
+    const std::string arg = argv[i];
+    if (arg == "-c") {
+      compress = true;
+    } else if (arg == "-C" && i + 1 < argc) {
+      root = argv[++i];
+    } else if (arg == "-l" && i + 1 < argc) {
+      return list(argv[++i]);
+    } else {
+      args.push_back(arg);
+    }
+  }
+  if (args.size() < 2) return usage();
+
+  mgl::AssetPackWriter writer;
+  std::size_t raw = 0;
+  for (std::size_t i = 1; i < args.size(); i++) {
+    const std::filesystem::path path = root / args[i];
+    std::ifstream ifile(path, std::ios::binary);
+    if (!ifile) {
+      std::cerr << "ERROR: Cannot read " << path.string() << std::endl;
+      return EXIT_FAILURE;
+    }
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(ifile)),
+                              std::istreambuf_iterator<char>());
+    raw += data.size();
+    writer.add(std::filesystem::path(args[i]).lexically_normal().generic_string(),
+               data, compress);
+  }
+  if (!writer.write(args[0])) return EXIT_FAILURE;
+
+  std::cout << "Packed " << args.size() - 1 << " file(s), " << raw
+            << " bytes -> " << std::filesystem::file_size(args[0]) << " bytes ["
+            << args[0] << "]" << std::endl;
+  return EXIT_SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,132 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// GL Trace Replayer
+//
+//   mglreplay <trace> [--frames <n>] [--warmup <n>] [--report <file>]
+//             [--baseline <file>] [--tolerance <percent>] [--gl-stats <n>]
+//
+// Re-issues a trace captured with --gl-capture in the Engine's headless
+// context, as fast as the driver takes it, without any of the app logic.
+// The resources are created once, then the captured frames are played in a
+// loop for --warmup discarded and --frames measured frames (by default as
+// many as were captured). Timings are collected as in the app's benchmark
+// mode, so reports and baselines are interchangeable with its own.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <string>
+
+#include "../mgl/mgl.hpp"
+
+struct Options {
+  std::string trace;
+  unsigned int frames = 0;
+  unsigned int warmup = 10;
+  std::string report;
+  std::string baseline;
+  double tolerance = 10.0;
+};
+
+static Options options;
+static mgl::GLTracePlayer player;
+
+class ReplayApp : public mgl::App {
+ public:
+  void initCallback(GLFWwindow *window) override {
+    const auto start = std::chrono::steady_clock::now();
+    player.setup();
+    glFinish();
+    std::cout << "Setup: "
+              << std::chrono::duration<double, std::milli>(
+                     std::chrono::steady_clock::now() - start)
+                     .count()
+              << " ms" << std::endl;
+  }
+
+  void displayCallback(GLFWwindow *window, double elapsed) override {
+    player.play(Frame);
+    Frame = (Frame + 1) % player.getFrameCount();
+  }
+
+ private:
+  uint32_t Frame = 0;
+};
+
+/////////////////////////////////////////////////////////////////////////// MAIN
+
+static int usage() {
+  std::cerr << "usage: mglreplay <trace> [--frames <n>] [--warmup <n>] "
+               "[--report <file>] [--baseline <file>] [--tolerance <percent>] "
+               "[--gl-stats <n>]"
+            << std::endl;
+  return EXIT_FAILURE;
+}
+
+int main(int argc, char *argv[]) {
+  mgl::Engine &engine = mgl::Engine::getInstance();
+  for (int i = 1; i < argc; i++) {
+    const std::string arg = argv[i];
+    if (arg == "--frames" && i + 1 < argc) {
+      options.frames = std::max(1, std::stoi(argv[++i]));
+    } else if (arg == "--warmup" && i + 1 < argc) {
+      options.warmup = std::max(0, std::stoi(argv[++i]));
+    } else if (arg == "--report" && i + 1 < argc) {
+      options.report = argv[++i];
+    } else if (arg == "--baseline" && i + 1 < argc) {
+      options.baseline = argv[++i];
+    } else if (arg == "--tolerance" && i + 1 < argc) {
+      options.tolerance = std::stod(argv[++i]);
+    } else if (arg == "--gl-stats" && i + 1 < argc) {
+      engine.setCallCounting(true);
+      mgl::GLCounters::getInstance().setSummaryInterval(std::stoi(argv[++i]));
+    } else if (options.trace.empty() && arg[0] != '-') {
+      options.trace = arg;
+    } else {
+      return usage();
+    }
+  }
+  if (options.trace.empty()) return usage();
+
+  if (!player.open(options.trace)) return EXIT_FAILURE;
+  const uint32_t frames = player.getFrameCount();
+  if (frames == 0) {
+    std::cerr << "ERROR: " << options.trace << " has no frames" << std::endl;
+    return EXIT_FAILURE;
+  }
+  std::size_t commands = 0;
+  for (uint32_t i = 0; i < frames; i++) commands += player.getCommandCount(i);
+  std::cout << "Trace: " << frames << " frame(s), " << commands / frames
+            << " command(s) per frame, " << player.getWidth() << "x"
+            << player.getHeight() << std::endl;
+
+  engine.setApp(new ReplayApp());
+  engine.setOpenGL(3, 3);
+  engine.setWindow(player.getWidth(), player.getHeight(), "mglreplay", 0, 0);
+  engine.setHeadless(true);
+  engine.setBenchmark(options.warmup, options.frames ? options.frames : frames);
+  engine.init();
+  engine.run();
+
+  mgl::FrameStats &stats = engine.getFrameStats();
+  std::map<std::string, double> metrics = stats.getMetrics();
+  std::cout << "CPU frame [ms]: p50 " << metrics["cpu_p50_ms"] << ", p95 "
+            << metrics["cpu_p95_ms"] << ", p99 " << metrics["cpu_p99_ms"]
+            << ", max " << metrics["cpu_max_ms"] << std::endl;
+  if (stats.hasGpu()) {
+    std::cout << "GPU frame [ms]: p50 " << metrics["gpu_p50_ms"] << ", p95 "
+              << metrics["gpu_p95_ms"] << ", p99 " << metrics["gpu_p99_ms"]
+              << ", max " << metrics["gpu_max_ms"] << std::endl;
+  }
+  if (!options.report.empty() && !stats.writeReport(options.report)) {
+    return EXIT_FAILURE;
+  }
+  if (!options.baseline.empty() &&
+      !stats.compare(options.baseline, options.tolerance)) {
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}